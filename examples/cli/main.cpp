@@ -42,9 +42,12 @@ struct SDCliParams {
     bool verbose          = false;
     bool canny_preprocess = false;
     bool convert_name     = false;
+    bool exec_order       = false;
 
     preview_t preview_method = PREVIEW_NONE;
     int preview_interval     = 1;
+    int preview_threads      = 0;
+    int preview_downscale    = 1;
     std::string preview_path = "preview.png";
     int preview_fps          = 16;
     bool taesd_preview       = false;
@@ -57,6 +60,9 @@ struct SDCliParams {
     std::string imatrix_out;
     std::vector<std::string> imatrix_in;
 
+    float quant_search_bpw         = 0.f;
+    std::string quant_search_types = "q4_K,q5_K,q6_K,q8_0";
+
     bool normal_exit = false;
 
     ArgOptions get_options() {
@@ -88,6 +94,11 @@ struct SDCliParams {
              "compute the imatrix for this run and save it to the provided path",
              0,
              &imatrix_out},
+            {"",
+             "--quant-search-types",
+             "candidate types for --quant-search-bpw (default: q4_K,q5_K,q6_K,q8_0)",
+             0,
+             &quant_search_types},
         };
 
         options.int_options = {
@@ -95,12 +106,29 @@ struct SDCliParams {
              "--preview-interval",
              "interval in denoising steps between consecutive updates of the image preview file (default is 1, meaning updating at every step)",
              &preview_interval},
+            {"",
+             "--preview-threads",
+             "threads of the worker that decodes vae/tae previews while sampling continues (default: 0, the --threads value when the preview decoder does not compete with sampling; < 0 decodes previews on the sampling thread)",
+             &preview_threads},
+            {"",
+             "--preview-downscale",
+             "shrink latents by this factor before vae/tae preview decodes (default: 1)",
+             &preview_downscale},
             {"",
              "--output-begin-idx",
              "starting index for output image sequence, must be non-negative (default 0 if specified %d in output path, 1 otherwise)",
              &output_begin_idx},
         };
 
+        options.float_options = {
+            {"",
+             "--quant-search-bpw",
+             "convert mode: pick a type per tensor group from --quant-search-types so the quantized tensors average "
+             "this many bits per weight, ranking tensors by imatrix-weighted error (use with --imat-in). "
+             "Rules given with --tensor-type-rules take precedence",
+             &quant_search_bpw},
+        };
+
         options.bool_options = {
             {"",
              "--canny",
@@ -110,6 +138,11 @@ struct SDCliParams {
              "--convert-name",
              "convert tensor name (for convert mode)",
              true, &convert_name},
+            {"",
+             "--exec-order",
+             "convert mode: write tensors in forward execution order (text encoders, diffusion model blocks in index order, VAE) "
+             "instead of name order, so streamed or cold-mmap loads read the file sequentially",
+             true, &exec_order},
             {"-v",
              "--verbose",
              "print extra info",
@@ -268,13 +301,18 @@ struct SDCliParams {
             << "  color: " << (color ? "true" : "false") << ",\n"
             << "  canny_preprocess: " << (canny_preprocess ? "true" : "false") << ",\n"
             << "  convert_name: " << (convert_name ? "true" : "false") << ",\n"
+            << "  exec_order: " << (exec_order ? "true" : "false") << ",\n"
             << "  preview_method: " << previews_str[preview_method] << ",\n"
             << "  preview_interval: " << preview_interval << ",\n"
+            << "  preview_threads: " << preview_threads << ",\n"
+            << "  preview_downscale: " << preview_downscale << ",\n"
             << "  preview_path: \"" << preview_path << "\",\n"
             << "  preview_fps: " << preview_fps << ",\n"
             << "  taesd_preview: " << (taesd_preview ? "true" : "false") << ",\n"
             << "  preview_noisy: " << (preview_noisy ? "true" : "false") << ",\n"
             << "  imatrix_out: \"" << imatrix_out << "\",\n"
+            << "  quant_search_bpw: " << quant_search_bpw << ",\n"
+            << "  quant_search_types: \"" << quant_search_types << "\",\n"
             << "  metadata_raw: " << (metadata_raw ? "true" : "false") << ",\n"
             << "  metadata_brief: " << (metadata_brief ? "true" : "false") << ",\n"
             << "  metadata_all: " << (metadata_all ? "true" : "false") << "\n"
@@ -432,6 +470,53 @@ static fs::path get_video_audio_sidecar_path(const SDCliParams& cli_params) {
     return base_path;
 }
 
+// Path of a multi-frame video: the output path with .avi unless it already
+// names an .avi, .webm or .webp file.
+static fs::path get_video_output_path(const SDCliParams& cli_params) {
+    fs::path out_path     = cli_params.output_path;
+    fs::path ext          = out_path.has_extension() ? out_path.extension() : fs::path{};
+    std::string ext_lower = ext.string();
+    std::transform(ext_lower.begin(), ext_lower.end(), ext_lower.begin(), ::tolower);
+    if (ext_lower == ".avi" || ext_lower == ".webm" || ext_lower == ".webp") {
+        return out_path;
+    }
+    fs::path video_path = out_path;
+    if (encoded_image_format_from_path(out_path.string()) != EncodedImageFormat::UNKNOWN) {
+        video_path.replace_extension();
+    }
+    video_path += ".avi";
+    return video_path;
+}
+
+static bool create_output_directory(const fs::path& out_path) {
+    if (out_path.parent_path().empty()) {
+        return true;
+    }
+    std::error_code ec;
+    fs::create_directories(out_path.parent_path(), ec);
+    if (ec) {
+        LOG_ERROR("failed to create directory '%s': %s",
+                  out_path.parent_path().string().c_str(), ec.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+static void write_audio_sidecar(const fs::path& wav_path, const sd_audio_t* audio) {
+    if (audio == nullptr) {
+        return;
+    }
+    if (write_wav_to_file(wav_path.string(),
+                          audio->data,
+                          audio->sample_count,
+                          audio->channels,
+                          audio->sample_rate)) {
+        LOG_INFO("save result audio to '%s'", wav_path.string().c_str());
+    } else {
+        LOG_WARN("failed to save result audio to '%s'", wav_path.string().c_str());
+    }
+}
+
 bool save_results(const SDCliParams& cli_params,
                   const SDContextParams& ctx_params,
                   const SDGenerationParams& gen_params,
@@ -442,17 +527,9 @@ bool save_results(const SDCliParams& cli_params,
         return false;
     }
 
-    namespace fs      = std::filesystem;
     fs::path out_path = cli_params.output_path;
-
-    if (!out_path.parent_path().empty()) {
-        std::error_code ec;
-        fs::create_directories(out_path.parent_path(), ec);
-        if (ec) {
-            LOG_ERROR("failed to create directory '%s': %s",
-                      out_path.parent_path().string().c_str(), ec.message().c_str());
-            return false;
-        }
+    if (!create_output_directory(out_path)) {
+        return false;
     }
 
     fs::path base_path = out_path;
@@ -491,21 +568,6 @@ bool save_results(const SDCliParams& cli_params,
         return ok;
     };
 
-    auto write_audio_sidecar = [&](const fs::path& wav_path) {
-        if (generated_audio == nullptr) {
-            return;
-        }
-        if (write_wav_to_file(wav_path.string(),
-                              generated_audio->data,
-                              generated_audio->sample_count,
-                              generated_audio->channels,
-                              generated_audio->sample_rate)) {
-            LOG_INFO("save result audio to '%s'", wav_path.string().c_str());
-        } else {
-            LOG_WARN("failed to save result audio to '%s'", wav_path.string().c_str());
-        }
-    };
-
     int sucessful_reults = 0;
 
     if (std::regex_search(cli_params.output_path, format_specifier_regex)) {
@@ -525,11 +587,8 @@ bool save_results(const SDCliParams& cli_params,
     }
 
     if (cli_params.mode == VID_GEN && num_results > 1) {
-        if (ext_lower != ".avi" && ext_lower != ".webp" && ext_lower != ".webm")
-            ext = ".avi";
-        fs::path video_path = base_path;
-        video_path += ext;
-        std::string final_ext_lower = ext.string();
+        fs::path video_path         = get_video_output_path(cli_params);
+        std::string final_ext_lower = video_path.extension().string();
         std::transform(final_ext_lower.begin(), final_ext_lower.end(), final_ext_lower.begin(), ::tolower);
         const bool mux_audio = generated_audio != nullptr && (final_ext_lower == ".avi" || final_ext_lower == ".webm");
         if (create_video_from_sd_images(video_path.string().c_str(), results, num_results, gen_params.fps, 90, mux_audio ? generated_audio : nullptr) == 0) {
@@ -537,7 +596,7 @@ bool save_results(const SDCliParams& cli_params,
             if (generated_audio != nullptr && !mux_audio) {
                 fs::path wav_path = video_path;
                 wav_path.replace_extension(".wav");
-                write_audio_sidecar(wav_path);
+                write_audio_sidecar(wav_path, generated_audio);
             }
             return true;
         } else {
@@ -561,11 +620,67 @@ bool save_results(const SDCliParams& cli_params,
     }
     LOG_INFO("%d/%d images saved", sucessful_reults, num_results);
     if (generated_audio != nullptr) {
-        write_audio_sidecar(get_video_audio_sidecar_path(cli_params));
+        write_audio_sidecar(get_video_audio_sidecar_path(cli_params), generated_audio);
     }
     return sucessful_reults != 0;
 }
 
+// A multi-frame video written straight to a video file can be encoded while
+// it is decoded; numbered frame files and ESRGAN upscaling need every frame
+// first.
+static bool can_stream_video(const SDCliParams& cli_params,
+                             const SDContextParams& ctx_params,
+                             const SDGenerationParams& gen_params) {
+    return cli_params.mode == VID_GEN &&
+           gen_params.video_frames > 1 &&
+           !std::regex_search(cli_params.output_path, format_specifier_regex) &&
+           !(ctx_params.esrgan_path.size() > 0 && gen_params.upscale_repeats > 0);
+}
+
+// generate_video() with the frames, and the LTX-AV audio ahead of them, going
+// through a VideoWriter into the output file as they are decoded.
+static bool generate_video_to_file(sd_ctx_t* sd_ctx,
+                                   sd_vid_gen_params_t vid_gen_params,
+                                   const SDCliParams& cli_params,
+                                   const SDGenerationParams& gen_params) {
+    const fs::path video_path = get_video_output_path(cli_params);
+    if (!create_output_directory(video_path)) {
+        return false;
+    }
+
+    bool ok        = false;
+    int num_frames = 0;
+    {
+        FileMediaSink sink(video_path.string());
+        if (!sink.is_open()) {
+            LOG_ERROR("failed to open '%s' for writing", video_path.string().c_str());
+            return false;
+        }
+        VideoWriterOptions options;
+        options.fps             = gen_params.fps;
+        options.quality         = 90;
+        options.expected_frames = gen_params.video_frames;
+
+        StreamingVideoOutput output(video_path.extension().string(), &sink, options);
+        output.attach(&vid_gen_params);
+        ok         = generate_video(sd_ctx, &vid_gen_params, nullptr, &num_frames, nullptr) && output.finalize();
+        num_frames = output.frame_count();
+        if (ok && output.unmuxed_audio() != nullptr) {
+            fs::path wav_path = video_path;
+            wav_path.replace_extension(".wav");
+            write_audio_sidecar(wav_path, output.unmuxed_audio());
+        }
+    }
+    if (!ok) {
+        std::error_code ec;
+        fs::remove(video_path, ec);
+        LOG_ERROR("Failed to save result video to '%s'", video_path.string().c_str());
+        return false;
+    }
+    LOG_INFO("save result video to '%s' (%d frames)", video_path.string().c_str(), num_frames);
+    return true;
+}
+
 static bool apply_adetailer(sd_ctx_t* sd_ctx,
                             const sd_ctx_params_t& sd_ctx_params,
                             const SDContextParams& ctx_params,
@@ -685,6 +800,7 @@ int main(int argc, const char* argv[]) {
                             !cli_params.preview_noisy,
                             cli_params.preview_noisy,
                             (void*)&cli_params);
+    sd_set_preview_decode_options(cli_params.preview_threads, cli_params.preview_downscale);
 
     LOG_DEBUG("version: %s", version_string().c_str());
     LOG_DEBUG("%s", sd_get_system_info());
@@ -708,17 +824,42 @@ int main(int argc, const char* argv[]) {
     }
 
     if (cli_params.mode == CONVERT) {
-        bool success = convert_with_components(ctx_params.model_path.c_str(),
-                                               ctx_params.clip_l_path.c_str(),
-                                               ctx_params.clip_g_path.c_str(),
-                                               ctx_params.t5xxl_path.c_str(),
-                                               ctx_params.diffusion_model_path.c_str(),
-                                               ctx_params.vae_path.c_str(),
-                                               cli_params.output_path.c_str(),
-                                               ctx_params.wtype,
-                                               ctx_params.tensor_type_rules.c_str(),
-                                               cli_params.convert_name,
-                                               ctx_params.n_threads);
+        std::string tensor_type_rules = ctx_params.tensor_type_rules;
+        if (cli_params.quant_search_bpw > 0.f) {
+            char* searched_rules = search_tensor_type_rules(ctx_params.model_path.c_str(),
+                                                            ctx_params.clip_l_path.c_str(),
+                                                            ctx_params.clip_g_path.c_str(),
+                                                            ctx_params.t5xxl_path.c_str(),
+                                                            ctx_params.diffusion_model_path.c_str(),
+                                                            ctx_params.vae_path.c_str(),
+                                                            cli_params.quant_search_types.c_str(),
+                                                            cli_params.quant_search_bpw,
+                                                            cli_params.convert_name,
+                                                            ctx_params.n_threads);
+            if (searched_rules == nullptr) {
+                LOG_ERROR("quantization search failed");
+                return 1;
+            }
+            LOG_INFO("searched tensor type rules: %s", searched_rules);
+            // First matching rule wins, so explicit rules go first.
+            if (!tensor_type_rules.empty()) {
+                tensor_type_rules += ",";
+            }
+            tensor_type_rules += searched_rules;
+            free(searched_rules);
+        }
+        bool success = convert_with_components_ex(ctx_params.model_path.c_str(),
+                                                  ctx_params.clip_l_path.c_str(),
+                                                  ctx_params.clip_g_path.c_str(),
+                                                  ctx_params.t5xxl_path.c_str(),
+                                                  ctx_params.diffusion_model_path.c_str(),
+                                                  ctx_params.vae_path.c_str(),
+                                                  cli_params.output_path.c_str(),
+                                                  ctx_params.wtype,
+                                                  tensor_type_rules.c_str(),
+                                                  cli_params.convert_name,
+                                                  ctx_params.n_threads,
+                                                  cli_params.exec_order);
         if (!success) {
             LOG_ERROR("convert '%s'/'%s' to '%s' failed",
                       ctx_params.model_path.c_str(),
@@ -846,6 +987,7 @@ int main(int argc, const char* argv[]) {
     SDImageVec results;
     int num_results             = 0;
     sd_audio_t* generated_audio = nullptr;
+    bool video_streamed         = false;
 
     if (cli_params.mode == UPSCALE) {
         num_results = 1;
@@ -888,14 +1030,22 @@ int main(int argc, const char* argv[]) {
             results.push_back(gen_params.init_image.release());
         } else if (cli_params.mode == VID_GEN) {
             sd_vid_gen_params_t vid_gen_params = gen_params.to_sd_vid_gen_params_t();
-            sd_image_t* generated_video        = nullptr;
-            if (!generate_video(sd_ctx.get(), &vid_gen_params, &generated_video, &num_results, &generated_audio)) {
-                generated_video = nullptr;
+            if (can_stream_video(cli_params, ctx_params, gen_params)) {
+                video_streamed = generate_video_to_file(sd_ctx.get(), vid_gen_params, cli_params, gen_params);
+                if (!video_streamed) {
+                    LOG_ERROR("generate failed");
+                    return 1;
+                }
+            } else {
+                sd_image_t* generated_video = nullptr;
+                if (!generate_video(sd_ctx.get(), &vid_gen_params, &generated_video, &num_results, &generated_audio)) {
+                    generated_video = nullptr;
+                }
+                results.adopt(generated_video, num_results);
             }
-            results.adopt(generated_video, num_results);
         }
 
-        if (!results) {
+        if (!video_streamed && !results) {
             LOG_ERROR("generate failed");
             return 1;
         }
@@ -954,7 +1104,8 @@ int main(int argc, const char* argv[]) {
         }
     }
 
-    if (!save_results(cli_params, ctx_params, gen_params, results.data(), num_results, generated_audio)) {
+    if (!video_streamed &&
+        !save_results(cli_params, ctx_params, gen_params, results.data(), num_results, generated_audio)) {
         free_sd_audio(generated_audio);
         return 1;
     }
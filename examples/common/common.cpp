@@ -1,6 +1,7 @@
 #include "common.h"
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
@@ -452,6 +453,12 @@ ArgOptions SDContextParams::get_options() {
          "weight type per tensor pattern (example: \"^vae\\.=f16,model\\.=q8_0\")",
          (int)',',
          &tensor_type_rules},
+        {"",
+         "--f8-weight-type",
+         "type FP8 (e4m3/e5m2) weights are loaded as: f16 (default, exact, twice the memory) or q8_0 (about the FP8 file size, lossy). "
+         "Accepts a single type or per-module assignments, e.g. diffusion=q8_0,te=f16",
+         (int)',',
+         &f8_weight_type},
         {"",
          "--model-args",
          "extra model args, key=value list. Supports chroma_use_dit_mask, chroma_use_t5_mask, "
@@ -508,6 +515,16 @@ ArgOptions SDContextParams::get_options() {
          "number of threads to use during computation (default: -1). "
          "If threads <= 0, then threads will be set to the number of CPU physical cores",
          &n_threads},
+        {"",
+         "--lora-cache-size",
+         "MiB used to keep recently used LoRAs: the merged weights of LoRA stacks in the immediately apply mode, "
+         "the parsed LoRA files in the at_runtime apply mode (default: 0, disabled)",
+         &lora_cache_size},
+        {"",
+         "--encode-cache-size",
+         "MiB used to keep the VAE latents and vision embeddings of recently used init/ref/control images, "
+         "so requests that resend the same image skip the encode (default: 0, disabled)",
+         &encode_cache_size},
     };
 
     options.bool_options = {
@@ -637,6 +654,20 @@ ArgOptions SDContextParams::get_options() {
         return 1;
     };
 
+    auto on_numa_arg = [&](int argc, const char** argv, int index) {
+        if (++index >= argc) {
+            return -1;
+        }
+        const char* arg = argv[index];
+        numa            = str_to_sd_numa_mode(arg);
+        if (numa == SD_NUMA_MODE_COUNT) {
+            LOG_ERROR("error: invalid numa mode %s",
+                      arg);
+            return -1;
+        }
+        return 1;
+    };
+
     options.manual_options = {
         {"",
          "--type",
@@ -663,6 +694,13 @@ ArgOptions SDContextParams::get_options() {
          "but it usually offers faster inference speed and, in some cases, lower memory usage. "
          "The at_runtime mode, on the other hand, is exactly the opposite.",
          on_lora_apply_mode_arg},
+        {"",
+         "--numa",
+         "NUMA policy for CPU inference, one of [disabled, distribute, isolate, numactl], default is disabled. "
+         "distribute spreads threads over all nodes and interleaves CPU params across them; "
+         "isolate keeps threads and CPU params on the node the process started on; "
+         "numactl follows the binding of an outer numactl, e.g. one process per socket for throughput",
+         on_numa_arg},
         {"",
          "--list-devices",
          "list available ggml backend devices (one 'name<TAB>description' per line) and exit; "
@@ -843,6 +881,10 @@ std::string SDContextParams::to_string() const {
         << "  vae_conv_direct: " << (vae_conv_direct ? "true" : "false") << ",\n"
         << "  prediction: " << sd_prediction_name(prediction) << ",\n"
         << "  lora_apply_mode: " << sd_lora_apply_mode_name(lora_apply_mode) << ",\n"
+        << "  numa: " << sd_numa_mode_name(numa) << ",\n"
+        << "  lora_cache_size: " << lora_cache_size << ",\n"
+        << "  encode_cache_size: " << encode_cache_size << ",\n"
+        << "  f8_weight_type: \"" << f8_weight_type << "\",\n"
         << "  force_sdxl_vae_conv_scale: " << (force_sdxl_vae_conv_scale ? "true" : "false") << "\n"
         << "}";
     return oss.str();
@@ -905,6 +947,10 @@ sd_ctx_params_t SDContextParams::to_sd_ctx_params_t(bool taesd_preview) {
     sd_ctx_params.auto_fit                        = auto_fit;
     sd_ctx_params.rpc_servers                     = rpc_servers.c_str();
     sd_ctx_params.model_args                      = model_args.empty() ? nullptr : model_args.c_str();
+    sd_ctx_params.numa                            = numa;
+    sd_ctx_params.lora_cache_size                 = lora_cache_size;
+    sd_ctx_params.f8_weight_type                  = f8_weight_type.c_str();
+    sd_ctx_params.encode_cache_size               = encode_cache_size;
     return sd_ctx_params;
 }
 
@@ -1002,7 +1048,7 @@ ArgOptions SDGenerationParams::get_options() {
          &extra_sample_args},
         {"",
          "--extra-tiling-args",
-         "extra VAE tiling args, key=value list. LTX video VAE supports temporal_tile_frames (default: 4), temporal_tile_overlap (default: 1)",
+         "extra VAE tiling args, key=value list. tile_batch (default: 1) runs that many spatial tiles per compute on image VAEs. LTX video VAE supports temporal_tile_frames (default: 4), temporal_tile_overlap (default: 1)",
          (int)',',
          &extra_tiling_args},
         {"",
@@ -1593,76 +1639,77 @@ ArgOptions SDGenerationParams::get_options() {
     return options;
 }
 
-static const std::string k_base64_chars =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/";
-
-static bool is_base64(unsigned char c) {
-    return std::isalnum(c) || c == '+' || c == '/';
+// 6-bit value of each base64 character; 0xFF for anything else, including
+// the '=' padding, which ends the data.
+static const std::array<uint8_t, 256> k_base64_values = [] {
+    static const char chars[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz"
+        "0123456789+/";
+    std::array<uint8_t, 256> values;
+    values.fill(0xFF);
+    for (int i = 0; i < 64; ++i) {
+        values[static_cast<uint8_t>(chars[i])] = static_cast<uint8_t>(i);
+    }
+    return values;
+}();
+
+// Decodes up to the first character that is not part of the base64 alphabet.
+// Uploads are megabytes of text, so whole quads go through one table lookup
+// per character and a single validity check instead of a search per
+// character.
+static std::vector<uint8_t> decode_base64_bytes(const char* encoded, size_t size) {
+    std::vector<uint8_t> ret(size / 4 * 3 + 3);
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(encoded);
+    uint8_t* out      = ret.data();
+    size_t pos        = 0;
+    for (; pos + 4 <= size; pos += 4) {
+        const uint32_t a = k_base64_values[in[pos]];
+        const uint32_t b = k_base64_values[in[pos + 1]];
+        const uint32_t c = k_base64_values[in[pos + 2]];
+        const uint32_t d = k_base64_values[in[pos + 3]];
+        if ((a | b | c | d) & 0x80) {
+            break;
+        }
+        const uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0]           = static_cast<uint8_t>(v >> 16);
+        out[1]           = static_cast<uint8_t>(v >> 8);
+        out[2]           = static_cast<uint8_t>(v);
+        out += 3;
+    }
+
+    // Partial quad before the end or the first invalid character: n < 4
+    // characters carry n - 1 bytes.
+    uint32_t v = 0;
+    int n      = 0;
+    for (; pos < size && k_base64_values[in[pos]] != 0xFF; ++pos, ++n) {
+        v = (v << 6) | k_base64_values[in[pos]];
+    }
+    v <<= 6 * (4 - n);
+    for (int i = 0; i < n - 1; ++i) {
+        *out++ = static_cast<uint8_t>(v >> (16 - 8 * i));
+    }
+
+    ret.resize(static_cast<size_t>(out - ret.data()));
+    return ret;
 }
 
-static std::vector<uint8_t> decode_base64_bytes(const std::string& encoded_string) {
-    int in_len = static_cast<int>(encoded_string.size());
-    int i      = 0;
-    int j      = 0;
-    int in_    = 0;
-    uint8_t char_array_4[4];
-    uint8_t char_array_3[3];
-    std::vector<uint8_t> ret;
-
-    while (in_len-- && encoded_string[in_] != '=' && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_];
-        in_++;
-        if (i == 4) {
-            for (i = 0; i < 4; i++) {
-                char_array_4[i] = static_cast<uint8_t>(k_base64_chars.find(char_array_4[i]));
-            }
-
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-            for (i = 0; i < 3; i++) {
-                ret.push_back(char_array_3[i]);
-            }
-            i = 0;
-        }
-    }
-
-    if (i) {
-        for (j = i; j < 4; j++) {
-            char_array_4[j] = 0;
-        }
-
-        for (j = 0; j < 4; j++) {
-            char_array_4[j] = static_cast<uint8_t>(k_base64_chars.find(char_array_4[j]));
-        }
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-        for (j = 0; j < i - 1; j++) {
-            ret.push_back(char_array_3[j]);
-        }
+static std::vector<uint8_t> decode_base64_payload(const std::string& encoded_input) {
+    size_t begin   = 0;
+    auto comma_pos = encoded_input.find(',');
+    if (comma_pos != std::string::npos) {
+        begin = comma_pos + 1;
     }
-
-    return ret;
+    return decode_base64_bytes(encoded_input.data() + begin, encoded_input.size() - begin);
 }
 
 bool decode_base64_image(const std::string& encoded_input,
                          int target_channels,
                          int expected_width,
                          int expected_height,
-                         SDImageOwner& out_image) {
-    std::string encoded = encoded_input;
-    auto comma_pos      = encoded.find(',');
-    if (comma_pos != std::string::npos) {
-        encoded = encoded.substr(comma_pos + 1);
-    }
-
-    std::vector<uint8_t> image_bytes = decode_base64_bytes(encoded);
+                         SDImageOwner& out_image,
+                         int n_threads) {
+    std::vector<uint8_t> image_bytes = decode_base64_payload(encoded_input);
     if (image_bytes.empty()) {
         return false;
     }
@@ -1675,7 +1722,8 @@ bool decode_base64_image(const std::string& encoded_input,
                                                 decoded_height,
                                                 expected_width,
                                                 expected_height,
-                                                target_channels);
+                                                target_channels,
+                                                n_threads);
     if (raw_data == nullptr) {
         return false;
     }
@@ -1684,12 +1732,42 @@ bool decode_base64_image(const std::string& encoded_input,
     return true;
 }
 
-static bool parse_image_json_field(const json& parent,
+void decode_base64_images(std::vector<Base64ImageJob>& jobs, int n_threads) {
+    std::vector<std::vector<uint8_t>> image_bytes(jobs.size());
+    std::vector<ImageLoadJob> load_jobs(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        jobs[i].decoded = false;
+        if (jobs[i].encoded != nullptr) {
+            image_bytes[i] = decode_base64_payload(*jobs[i].encoded);
+        }
+        load_jobs[i].bytes            = reinterpret_cast<const char*>(image_bytes[i].data());
+        load_jobs[i].len              = static_cast<int>(image_bytes[i].size());
+        load_jobs[i].expected_width   = jobs[i].expected_width;
+        load_jobs[i].expected_height  = jobs[i].expected_height;
+        load_jobs[i].expected_channel = jobs[i].target_channels;
+    }
+
+    load_images_from_memory(load_jobs, n_threads);
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const ImageLoadJob& loaded = load_jobs[i];
+        if (loaded.pixels == nullptr) {
+            continue;
+        }
+        jobs[i].out_image->reset({(uint32_t)loaded.width, (uint32_t)loaded.height, (uint32_t)loaded.expected_channel, loaded.pixels});
+        jobs[i].decoded = true;
+    }
+}
+
+// Queues parent[key] for decode_base64_images(); a null value clears
+// out_image right away.
+static bool queue_image_json_field(const json& parent,
                                    const char* key,
                                    int channels,
                                    int expected_width,
                                    int expected_height,
-                                   SDImageOwner& out_image) {
+                                   SDImageOwner& out_image,
+                                   std::vector<Base64ImageJob>& jobs) {
     if (!parent.contains(key)) {
         return true;
     }
@@ -1700,15 +1778,19 @@ static bool parse_image_json_field(const json& parent,
     if (!parent.at(key).is_string()) {
         return false;
     }
-    return decode_base64_image(parent.at(key).get<std::string>(), channels, expected_width, expected_height, out_image);
+    jobs.push_back({&parent.at(key).get_ref<const std::string&>(), channels, expected_width, expected_height, &out_image});
+    return true;
 }
 
-static bool parse_image_array_json_field(const json& parent,
+// Sizes out_images to the array in parent[key] and queues every element;
+// the vector must not be resized again before the jobs have run.
+static bool queue_image_array_json_field(const json& parent,
                                          const char* key,
                                          int channels,
                                          int expected_width,
                                          int expected_height,
-                                         std::vector<SDImageOwner>& out_images) {
+                                         std::vector<SDImageOwner>& out_images,
+                                         std::vector<Base64ImageJob>& jobs) {
     if (!parent.contains(key)) {
         return true;
     }
@@ -1720,16 +1802,16 @@ static bool parse_image_array_json_field(const json& parent,
         return false;
     }
 
-    out_images.clear();
-    for (const auto& item : parent.at(key)) {
+    const json& items = parent.at(key);
+    for (const auto& item : items) {
         if (!item.is_string()) {
             return false;
         }
-        SDImageOwner image;
-        if (!decode_base64_image(item.get<std::string>(), channels, expected_width, expected_height, image)) {
-            return false;
-        }
-        out_images.push_back(std::move(image));
+    }
+    out_images.clear();
+    out_images.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        jobs.push_back({&items[i].get_ref<const std::string&>(), channels, expected_width, expected_height, &out_images[i]});
     }
     return true;
 }
@@ -1827,7 +1909,8 @@ static bool resolve_model_file_from_dir(const std::string& model_name,
 
 bool SDGenerationParams::from_json_str(
     const std::string& json_str,
-    const std::function<std::string(const std::string&)>& lora_path_resolver) {
+    const std::function<std::string(const std::string&)>& lora_path_resolver,
+    int image_decode_threads) {
     json j;
     try {
         j = json::parse(json_str);
@@ -2033,29 +2116,49 @@ bool SDGenerationParams::from_json_str(
         LOG_ERROR("invalid lora");
         return false;
     }
-    if (!parse_image_json_field(j, "init_image", 3, width, height, init_image)) {
-        LOG_ERROR("invalid init_image");
-        return false;
-    }
-    if (!parse_image_json_field(j, "end_image", 3, width, height, end_image)) {
-        LOG_ERROR("invalid end_image");
-        return false;
-    }
-    if (!parse_image_array_json_field(j, "ref_images", 3, width, height, ref_images)) {
-        LOG_ERROR("invalid ref_images");
-        return false;
-    }
-    if (!parse_image_array_json_field(j, "control_frames", 3, width, height, control_frames)) {
-        LOG_ERROR("invalid control_frames");
-        return false;
-    }
-    if (!parse_image_json_field(j, "mask_image", 1, width, height, mask_image)) {
-        LOG_ERROR("invalid mask_image");
+    // Every uploaded image of the request decodes and resizes in one batch.
+    struct ImageField {
+        const char* key;
+        size_t first_job;
+        size_t job_count;
+    };
+    std::vector<Base64ImageJob> image_jobs;
+    std::vector<ImageField> image_fields;
+    auto queue_image = [&](const char* key, int channels, SDImageOwner& out_image) {
+        const size_t first_job = image_jobs.size();
+        if (!queue_image_json_field(j, key, channels, width, height, out_image, image_jobs)) {
+            LOG_ERROR("invalid %s", key);
+            return false;
+        }
+        image_fields.push_back({key, first_job, image_jobs.size() - first_job});
+        return true;
+    };
+    auto queue_image_array = [&](const char* key, int channels, std::vector<SDImageOwner>& out_images) {
+        const size_t first_job = image_jobs.size();
+        if (!queue_image_array_json_field(j, key, channels, width, height, out_images, image_jobs)) {
+            LOG_ERROR("invalid %s", key);
+            return false;
+        }
+        image_fields.push_back({key, first_job, image_jobs.size() - first_job});
+        return true;
+    };
+    if (!queue_image("init_image", 3, init_image) ||
+        !queue_image("end_image", 3, end_image) ||
+        !queue_image_array("ref_images", 3, ref_images) ||
+        !queue_image_array("control_frames", 3, control_frames) ||
+        !queue_image("mask_image", 1, mask_image) ||
+        !queue_image("control_image", 3, control_image)) {
         return false;
     }
-    if (!parse_image_json_field(j, "control_image", 3, width, height, control_image)) {
-        LOG_ERROR("invalid control_image");
-        return false;
+
+    decode_base64_images(image_jobs, image_decode_threads);
+    for (const ImageField& field : image_fields) {
+        for (size_t i = field.first_job; i < field.first_job + field.job_count; ++i) {
+            if (!image_jobs[i].decoded) {
+                LOG_ERROR("invalid %s", field.key);
+                return false;
+            }
+        }
     }
 
     return true;
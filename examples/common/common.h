@@ -112,7 +112,24 @@ bool decode_base64_image(const std::string& encoded_input,
                          int target_channels,
                          int expected_width,
                          int expected_height,
-                         SDImageOwner& out_image);
+                         SDImageOwner& out_image,
+                         int n_threads = 1);
+
+// One upload for decode_base64_images(); out_image is only written when the
+// image decodes.
+struct Base64ImageJob {
+    const std::string* encoded = nullptr;
+    int target_channels        = 3;
+    int expected_width         = 0;
+    int expected_height        = 0;
+    SDImageOwner* out_image    = nullptr;
+    bool decoded               = false;
+};
+
+// decode_base64_image() for all uploads of a request at once: the images
+// decode and resize concurrently on up to n_threads threads (<= 0: one per
+// hardware thread).
+void decode_base64_images(std::vector<Base64ImageJob>& jobs, int n_threads);
 
 struct SDContextParams {
     int n_threads = -1;
@@ -170,6 +187,10 @@ struct SDContextParams {
 
     prediction_t prediction           = PREDICTION_COUNT;
     lora_apply_mode_t lora_apply_mode = LORA_APPLY_AUTO;
+    sd_numa_mode_t numa               = SD_NUMA_DISABLED;
+    int lora_cache_size               = 0;
+    int encode_cache_size             = 0;
+    std::string f8_weight_type;
 
     bool force_sdxl_vae_conv_scale = false;
 
@@ -289,7 +310,8 @@ struct SDGenerationParams {
     SDGenerationParams& operator=(SDGenerationParams&& other) noexcept = default;
     ArgOptions get_options();
     bool from_json_str(const std::string& json_str,
-                       const std::function<std::string(const std::string&)>& lora_path_resolver = {});
+                       const std::function<std::string(const std::string&)>& lora_path_resolver = {},
+                       int image_decode_threads                                                 = 1);
     bool initialize_cache_params();
     void extract_and_remove_lora(const std::string& lora_model_dir);
     bool width_and_height_are_set() const;
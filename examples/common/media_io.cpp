@@ -3,7 +3,9 @@
 #include "resource_owners.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cerrno>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -11,8 +13,17 @@
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_STATIC
 #include "stb_image.h"
@@ -96,53 +107,39 @@ using WebPAnimEncoderPtr = std::unique_ptr<WebPAnimEncoder, WebPAnimEncoderDelet
 #endif
 
 #ifdef SD_USE_WEBM
-class MemoryMkvWriter : public mkvmuxer::IMkvWriter {
+class MediaSinkMkvWriter : public mkvmuxer::IMkvWriter {
 public:
+    explicit MediaSinkMkvWriter(MediaSink* sink)
+        : sink_(sink) {
+    }
+
     mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len) override {
         if (buf == nullptr && len > 0) {
             return -1;
         }
-        const size_t end_pos = position_ + static_cast<size_t>(len);
-        if (end_pos > data_.size()) {
-            data_.resize(end_pos);
-        }
-        if (len > 0) {
-            memcpy(data_.data() + position_, buf, len);
-        }
-        position_ = end_pos;
-        return 0;
+        return sink_->write(buf, len) ? 0 : -1;
     }
 
     mkvmuxer::int64 Position() const override {
-        return static_cast<mkvmuxer::int64>(position_);
+        return static_cast<mkvmuxer::int64>(sink_->position());
     }
 
     mkvmuxer::int32 Position(mkvmuxer::int64 position) override {
         if (position < 0) {
             return -1;
         }
-        const size_t target = static_cast<size_t>(position);
-        if (target > data_.size()) {
-            data_.resize(target);
-        }
-        position_ = target;
-        return 0;
+        return sink_->seek(static_cast<uint64_t>(position)) ? 0 : -1;
     }
 
     bool Seekable() const override {
-        return true;
+        return sink_->seekable();
     }
 
     void ElementStartNotify(mkvmuxer::uint64, mkvmuxer::int64) override {
     }
 
-    const std::vector<uint8_t>& data() const {
-        return data_;
-    }
-
 private:
-    std::vector<uint8_t> data_;
-    size_t position_ = 0;
+    MediaSink* sink_;
 };
 #endif
 
@@ -191,24 +188,6 @@ uint32_t read_u32_le_bytes(const uint8_t* data) {
            (static_cast<uint32_t>(data[3]) << 24);
 }
 
-int stbi_ext_write_png_to_func(stbi_write_func* func,
-                               void* context,
-                               int x,
-                               int y,
-                               int comp,
-                               const void* data,
-                               int stride_bytes,
-                               const char* parameters) {
-    int len            = 0;
-    unsigned char* png = stbi_write_png_to_mem((const unsigned char*)data, stride_bytes, x, y, comp, &len, parameters);
-    if (png == nullptr) {
-        return 0;
-    }
-    func(context, png, len);
-    STBIW_FREE(png);
-    return 1;
-}
-
 bool is_webp_signature(const uint8_t* data, size_t size) {
     return size >= 12 &&
            memcmp(data, "RIFF", 4) == 0 &&
@@ -474,6 +453,80 @@ bool encode_sd_image_to_vp8_frame(const sd_image_t& image, int quality, std::vec
 #endif
 #endif
 
+static int resolve_thread_count(int n_threads) {
+    if (n_threads <= 0) {
+        n_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    return std::max(1, n_threads);
+}
+
+// Runs job(i) for i in [0, count) on up to n_threads threads (<= 0: one per
+// hardware thread); the calling thread is one of them. Stops handing out
+// jobs once any job fails.
+static bool run_parallel(int count, int n_threads, const std::function<bool(int)>& job) {
+    if (count <= 0) {
+        return true;
+    }
+    n_threads = std::min(resolve_thread_count(n_threads), count);
+
+    std::atomic<int> next_job(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            const int i = next_job.fetch_add(1);
+            if (i >= count) {
+                break;
+            }
+            if (!job(i)) {
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(n_threads - 1));
+    for (int t = 1; t < n_threads; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return !failed;
+}
+
+// Box-filter resize of the input images. Output rows are split into strips
+// that stbir_resize_subpixel() resamples independently: the vertical offset
+// places each strip where it sits in the full output, so the pixels match a
+// single stbir_resize() call.
+static bool resize_image_parallel(const uint8_t* src,
+                                  int src_width,
+                                  int src_height,
+                                  int src_stride,
+                                  uint8_t* dst,
+                                  int dst_width,
+                                  int dst_height,
+                                  int channels,
+                                  int n_threads) {
+    n_threads             = resolve_thread_count(n_threads);
+    const float x_scale   = static_cast<float>(dst_width) / static_cast<float>(src_width);
+    const float y_scale   = static_cast<float>(dst_height) / static_cast<float>(src_height);
+    const int strip_rows  = std::max(64, (dst_height + n_threads - 1) / n_threads);
+    const int strip_count = (dst_height + strip_rows - 1) / strip_rows;
+    const size_t dst_row  = static_cast<size_t>(dst_width) * channels;
+    return run_parallel(strip_count, n_threads, [&](int s) {
+        const int y0 = s * strip_rows;
+        const int y1 = std::min(dst_height, y0 + strip_rows);
+        return stbir_resize_subpixel(src, src_width, src_height, src_stride,
+                                     dst + dst_row * y0, dst_width, y1 - y0, 0, STBIR_TYPE_UINT8,
+                                     channels, STBIR_ALPHA_CHANNEL_NONE, 0,
+                                     STBIR_EDGE_CLAMP, STBIR_EDGE_CLAMP,
+                                     STBIR_FILTER_BOX, STBIR_FILTER_BOX,
+                                     STBIR_COLORSPACE_SRGB, nullptr,
+                                     x_scale, y_scale, 0.0f, static_cast<float>(y0)) != 0;
+    });
+}
+
 uint8_t* load_image_common(bool from_memory,
                            const char* image_path_or_bytes,
                            int len,
@@ -481,7 +534,8 @@ uint8_t* load_image_common(bool from_memory,
                            int& height,
                            int expected_width,
                            int expected_height,
-                           int expected_channel) {
+                           int expected_channel,
+                           int n_threads) {
     const char* image_path;
     FreeUniquePtr<uint8_t> image_buffer;
     int source_channel_count = 0;
@@ -573,34 +627,23 @@ uint8_t* load_image_common(bool from_memory,
 
         if (crop_x != 0 || crop_y != 0) {
             LOG_INFO("crop input image from %dx%d to %dx%d, image_path = %s", width, height, crop_w, crop_h, image_path);
-            FreeUniquePtr<uint8_t> cropped_image_buffer((uint8_t*)malloc(crop_w * crop_h * expected_channel));
-            if (cropped_image_buffer == nullptr) {
-                LOG_ERROR("error: allocate memory for crop\n");
-                return nullptr;
-            }
-            for (int row = 0; row < crop_h; row++) {
-                uint8_t* src = image_buffer.get() + ((crop_y + row) * width + crop_x) * expected_channel;
-                uint8_t* dst = cropped_image_buffer.get() + (row * crop_w) * expected_channel;
-                memcpy(dst, src, crop_w * expected_channel);
-            }
-
-            width        = crop_w;
-            height       = crop_h;
-            image_buffer = std::move(cropped_image_buffer);
         }
 
-        LOG_INFO("resize input image from %dx%d to %dx%d", width, height, expected_width, expected_height);
+        LOG_INFO("resize input image from %dx%d to %dx%d", crop_w, crop_h, expected_width, expected_height);
         FreeUniquePtr<uint8_t> resized_image_buffer((uint8_t*)malloc(expected_height * expected_width * expected_channel));
         if (resized_image_buffer == nullptr) {
             LOG_ERROR("error: allocate memory for resize input image\n");
             return nullptr;
         }
-        stbir_resize(image_buffer.get(), width, height, 0,
-                     resized_image_buffer.get(), expected_width, expected_height, 0, STBIR_TYPE_UINT8,
-                     expected_channel, STBIR_ALPHA_CHANNEL_NONE, 0,
-                     STBIR_EDGE_CLAMP, STBIR_EDGE_CLAMP,
-                     STBIR_FILTER_BOX, STBIR_FILTER_BOX,
-                     STBIR_COLORSPACE_SRGB, nullptr);
+        // The crop is only a window into the decoded image: resize reads it
+        // through the source stride instead of copying it out first.
+        const uint8_t* crop_origin = image_buffer.get() + ((size_t)crop_y * width + crop_x) * expected_channel;
+        if (!resize_image_parallel(crop_origin, crop_w, crop_h, width * expected_channel,
+                                   resized_image_buffer.get(), expected_width, expected_height,
+                                   expected_channel, n_threads)) {
+            LOG_ERROR("error: resize input image failed, image_path = %s", image_path);
+            return nullptr;
+        }
         width        = expected_width;
         height       = expected_height;
         image_buffer = std::move(resized_image_buffer);
@@ -640,45 +683,543 @@ void write_u16_le(std::vector<uint8_t>& data, uint16_t val) {
     data.push_back(static_cast<uint8_t>((val >> 8) & 0xFF));
 }
 
-void patch_u32_le(std::vector<uint8_t>& data, size_t offset, uint32_t val) {
-    if (offset + 4 > data.size()) {
-        return;
-    }
-    data[offset + 0] = static_cast<uint8_t>(val & 0xFF);
-    data[offset + 1] = static_cast<uint8_t>((val >> 8) & 0xFF);
-    data[offset + 2] = static_cast<uint8_t>((val >> 16) & 0xFF);
-    data[offset + 3] = static_cast<uint8_t>((val >> 24) & 0xFF);
-}
-
 void write_fourcc(std::vector<uint8_t>& data, const char* fourcc) {
     data.insert(data.end(), fourcc, fourcc + 4);
 }
 
-static std::vector<uint8_t> audio_to_pcm16_bytes(const sd_audio_t* audio) {
-    if (audio == nullptr || audio->data == nullptr || audio->sample_count == 0 || audio->channels == 0 || audio->sample_rate == 0) {
-        return {};
-    }
-
-    const size_t pcm_samples = static_cast<size_t>(audio->sample_count) * static_cast<size_t>(audio->channels);
-    std::vector<uint8_t> bytes(pcm_samples * sizeof(int16_t));
+static std::vector<uint8_t> audio_to_pcm16_bytes(const float* samples, size_t count) {
+    std::vector<uint8_t> bytes(count * sizeof(int16_t));
     auto* pcm = reinterpret_cast<int16_t*>(bytes.data());
-    for (size_t i = 0; i < pcm_samples; ++i) {
-        const float sample = std::clamp(audio->data[i], -1.0f, 1.0f);
+    for (size_t i = 0; i < count; ++i) {
+        const float sample = std::clamp(samples[i], -1.0f, 1.0f);
         pcm[i]             = static_cast<int16_t>(std::lrint(sample * 32767.0f));
     }
     return bytes;
 }
 
-static std::pair<uint64_t, uint64_t> audio_sample_range_for_video_frame(const sd_audio_t* audio, int frame_idx, int num_frames, int fps) {
-    if (audio == nullptr || fps <= 0 || num_frames <= 0) {
-        return {0, 0};
+static bool has_audio_samples(const sd_audio_t* audio) {
+    return audio != nullptr && audio->data != nullptr && audio->sample_count > 0 && audio->channels > 0 && audio->sample_rate > 0;
+}
+
+// Runs encode(i, out) for i in [0, count) on up to n_threads threads (<= 0:
+// one per hardware thread) and keeps the outputs in order. Stops early once
+// any job fails.
+static bool encode_parallel(int count,
+                            int n_threads,
+                            std::vector<std::vector<uint8_t>>& encoded,
+                            const std::function<bool(int, std::vector<uint8_t>&)>& encode) {
+    encoded.resize(static_cast<size_t>(std::max(0, count)));
+    return run_parallel(count, n_threads, [&](int i) {
+        return encode(i, encoded[i]);
+    });
+}
+
+// Raw deflate (RFC 1951) writer for PNG strips. Like stb_image_write it only
+// emits fixed-Huffman blocks, but with hash chains sized by level; level 0
+// writes stored blocks. A strip that is not the last one ends with an empty
+// stored block, so strips compressed independently concatenate into one
+// valid stream.
+class DeflateStripWriter {
+public:
+    DeflateStripWriter(std::vector<uint8_t>& out, int level)
+        : out_(out), level_(std::clamp(level, 0, 9)) {
+    }
+
+    void compress(const uint8_t* data, size_t size, bool last) {
+        if (level_ == 0) {
+            write_stored(data, size, last);
+            return;
+        }
+        put_bits(last ? 1 : 0, 1);
+        put_bits(1, 2);
+        compress_fixed(data, size);
+        put_code(256);
+        if (!last) {
+            put_bits(0, 3);
+            flush_bits();
+            out_.insert(out_.end(), {0x00, 0x00, 0xFF, 0xFF});
+        }
+        flush_bits();
     }
-    const uint64_t total = audio->sample_count;
-    const uint64_t start = static_cast<uint64_t>((static_cast<long double>(frame_idx) * total) / num_frames);
-    const uint64_t end   = frame_idx + 1 == num_frames
-                               ? total
-                               : static_cast<uint64_t>((static_cast<long double>(frame_idx + 1) * total) / num_frames);
-    return {start, std::max(start, end)};
+
+private:
+    static constexpr int WINDOW_SIZE = 32768;
+    static constexpr int HASH_BITS   = 15;
+    static constexpr int MIN_MATCH   = 3;
+    static constexpr int MAX_MATCH   = 258;
+
+    // Like zlib's configuration table: chain length, length that ends the
+    // search, and the longest match still worth a lazy look one byte ahead.
+    struct LevelParams {
+        int max_chain;
+        int nice_length;
+        int max_lazy;
+    };
+
+    static const LevelParams& level_params(int level) {
+        static const LevelParams params[10] = {
+            {0, 0, 0},
+            {2, 8, 0},
+            {4, 16, 0},
+            {8, 16, 0},
+            {4, 16, 4},
+            {8, 16, 8},
+            {8, 32, 8},
+            {16, 32, 16},
+            {16, 64, 16},
+            {32, 128, 32},
+        };
+        return params[level];
+    }
+
+    struct FixedTables {
+        uint16_t lit_code[288];
+        uint8_t lit_bits[288];
+        uint16_t len_sym[MAX_MATCH + 1];
+        uint8_t dist_code[512];
+
+        FixedTables() {
+            for (int sym = 0; sym < 288; ++sym) {
+                int code = 0;
+                int bits = 0;
+                if (sym < 144) {
+                    code = 0x30 + sym;
+                    bits = 8;
+                } else if (sym < 256) {
+                    code = 0x190 + sym - 144;
+                    bits = 9;
+                } else if (sym < 280) {
+                    code = sym - 256;
+                    bits = 7;
+                } else {
+                    code = 0xC0 + sym - 280;
+                    bits = 8;
+                }
+                lit_code[sym] = static_cast<uint16_t>(reverse_bits(code, bits));
+                lit_bits[sym] = static_cast<uint8_t>(bits);
+            }
+            for (int len = MIN_MATCH; len <= MAX_MATCH; ++len) {
+                int sym = 0;
+                while (sym + 1 < 29 && LENGTH_BASE[sym + 1] <= len) {
+                    sym++;
+                }
+                len_sym[len] = static_cast<uint16_t>(sym);
+            }
+            for (int d = 1; d <= 256; ++d) {
+                dist_code[d - 1] = static_cast<uint8_t>(dist_code_slow(d));
+            }
+            for (int d = 257; d <= WINDOW_SIZE; d += 128) {
+                dist_code[256 + ((d - 1) >> 7)] = static_cast<uint8_t>(dist_code_slow(d));
+            }
+        }
+
+        static int dist_code_slow(int dist) {
+            int code = 0;
+            while (code + 1 < 30 && DIST_BASE[code + 1] <= dist) {
+                code++;
+            }
+            return code;
+        }
+
+        int dist_sym(int dist) const {
+            return dist <= 256 ? dist_code[dist - 1] : dist_code[256 + ((dist - 1) >> 7)];
+        }
+    };
+
+    static constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr uint16_t DIST_BASE[30]   = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                                 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                                 6145, 8193, 12289, 16385, 24577};
+    static constexpr uint8_t DIST_EXTRA[30]   = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    static int reverse_bits(int code, int bits) {
+        int reversed = 0;
+        for (int i = 0; i < bits; ++i) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        return reversed;
+    }
+
+    static const FixedTables& tables() {
+        static const FixedTables fixed_tables;
+        return fixed_tables;
+    }
+
+    void put_bits(uint32_t value, int bits) {
+        bit_buf_ |= static_cast<uint64_t>(value) << bit_count_;
+        bit_count_ += bits;
+        while (bit_count_ >= 8) {
+            out_.push_back(static_cast<uint8_t>(bit_buf_));
+            bit_buf_ >>= 8;
+            bit_count_ -= 8;
+        }
+    }
+
+    void flush_bits() {
+        if (bit_count_ > 0) {
+            put_bits(0, 8 - bit_count_);
+        }
+    }
+
+    void put_code(int sym) {
+        put_bits(tables().lit_code[sym], tables().lit_bits[sym]);
+    }
+
+    void put_match(int len, int dist) {
+        const FixedTables& t = tables();
+        const int len_sym    = t.len_sym[len];
+        put_code(257 + len_sym);
+        if (LENGTH_EXTRA[len_sym] > 0) {
+            put_bits(static_cast<uint32_t>(len - LENGTH_BASE[len_sym]), LENGTH_EXTRA[len_sym]);
+        }
+        const int dist_sym = t.dist_sym(dist);
+        put_bits(static_cast<uint32_t>(reverse_bits(dist_sym, 5)), 5);
+        if (DIST_EXTRA[dist_sym] > 0) {
+            put_bits(static_cast<uint32_t>(dist - DIST_BASE[dist_sym]), DIST_EXTRA[dist_sym]);
+        }
+    }
+
+    void write_stored(const uint8_t* data, size_t size, bool last) {
+        size_t offset = 0;
+        do {
+            const size_t block     = std::min<size_t>(size - offset, 65535);
+            const bool final_block = last && offset + block == size;
+            put_bits(final_block ? 1 : 0, 1);
+            put_bits(0, 2);
+            flush_bits();
+            const uint16_t len = static_cast<uint16_t>(block);
+            out_.insert(out_.end(), {static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>(len >> 8),
+                                     static_cast<uint8_t>(~len & 0xFF), static_cast<uint8_t>((~len >> 8) & 0xFF)});
+            out_.insert(out_.end(), data + offset, data + offset + block);
+            offset += block;
+        } while (offset < size);
+    }
+
+    static uint32_t hash3(const uint8_t* p) {
+        const uint32_t v = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void insert_hash(const uint8_t* data, size_t pos) {
+        const uint32_t h               = hash3(data + pos);
+        prev_[pos & (WINDOW_SIZE - 1)] = head_[h];
+        head_[h]                       = static_cast<int32_t>(pos);
+    }
+
+    static int match_length(const uint8_t* a, const uint8_t* b, int max_len) {
+        int len = 0;
+        while (len + 8 <= max_len) {
+            uint64_t wa;
+            uint64_t wb;
+            memcpy(&wa, a + len, sizeof(wa));
+            memcpy(&wb, b + len, sizeof(wb));
+            if (wa != wb) {
+                break;
+            }
+            len += 8;
+        }
+        while (len < max_len && a[len] == b[len]) {
+            len++;
+        }
+        return len;
+    }
+
+    int longest_match(const uint8_t* data, size_t size, size_t pos, int* match_dist) const {
+        const LevelParams& params = level_params(level_);
+        const int max_len         = static_cast<int>(std::min<size_t>(MAX_MATCH, size - pos));
+        int best_len              = MIN_MATCH - 1;
+        int32_t candidate         = head_[hash3(data + pos)];
+        for (int chain = 0; chain < params.max_chain && candidate >= 0; ++chain) {
+            const size_t cand = static_cast<size_t>(candidate);
+            if (pos - cand > WINDOW_SIZE) {
+                break;
+            }
+            if (data[cand + best_len] == data[pos + best_len]) {
+                const int len = match_length(data + cand, data + pos, max_len);
+                if (len > best_len) {
+                    best_len    = len;
+                    *match_dist = static_cast<int>(pos - cand);
+                    if (len >= params.nice_length || len == max_len) {
+                        break;
+                    }
+                }
+            }
+            const int32_t next = prev_[cand & (WINDOW_SIZE - 1)];
+            if (next >= candidate) {
+                break;
+            }
+            candidate = next;
+        }
+        return best_len >= MIN_MATCH ? best_len : 0;
+    }
+
+    void compress_fixed(const uint8_t* data, size_t size) {
+        const int max_lazy = level_params(level_).max_lazy;
+        head_.assign(static_cast<size_t>(1) << HASH_BITS, -1);
+        prev_.assign(WINDOW_SIZE, -1);
+
+        size_t pos = 0;
+        while (pos < size) {
+            int len  = 0;
+            int dist = 0;
+            if (pos + MIN_MATCH <= size) {
+                len = longest_match(data, size, pos, &dist);
+                insert_hash(data, pos);
+            }
+            if (len > 0 && len < max_lazy && pos + 1 + MIN_MATCH <= size) {
+                int next_dist      = 0;
+                const int next_len = longest_match(data, size, pos + 1, &next_dist);
+                if (next_len > len) {
+                    put_code(data[pos]);
+                    pos++;
+                    continue;
+                }
+            }
+            if (len == 0) {
+                put_code(data[pos]);
+                pos++;
+                continue;
+            }
+            put_match(len, dist);
+            const size_t end = pos + static_cast<size_t>(len);
+            for (pos++; pos < end; ++pos) {
+                if (pos + MIN_MATCH <= size) {
+                    insert_hash(data, pos);
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t>& out_;
+    int level_;
+    uint64_t bit_buf_ = 0;
+    int bit_count_    = 0;
+    std::vector<int32_t> head_;
+    std::vector<int32_t> prev_;
+};
+
+constexpr uint16_t DeflateStripWriter::LENGTH_BASE[29];
+constexpr uint8_t DeflateStripWriter::LENGTH_EXTRA[29];
+constexpr uint16_t DeflateStripWriter::DIST_BASE[30];
+constexpr uint8_t DeflateStripWriter::DIST_EXTRA[30];
+
+static uint32_t png_crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32_update(uint32_t adler, const uint8_t* data, size_t size) {
+    const uint32_t BASE = 65521;
+    uint32_t a          = adler & 0xFFFF;
+    uint32_t b          = adler >> 16;
+    while (size > 0) {
+        // 5552 is the largest run that cannot overflow b before the modulo.
+        const size_t run = std::min<size_t>(size, 5552);
+        for (size_t i = 0; i < run; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= BASE;
+        b %= BASE;
+        data += run;
+        size -= run;
+    }
+    return (b << 16) | a;
+}
+
+// adler32 of A||B from adler32(A), adler32(B) and len(B), as in zlib.
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+    const uint64_t BASE = 65521;
+    const uint64_t rem  = len2 % BASE;
+    uint64_t sum1       = adler1 & 0xFFFF;
+    uint64_t sum2       = (rem * sum1) % BASE;
+    sum1 += (adler2 & 0xFFFF) + BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + BASE - rem;
+    sum1 %= BASE;
+    sum2 %= BASE;
+    return static_cast<uint32_t>((sum2 << 16) | sum1);
+}
+
+// Writes one row with the filter stb_image_write would pick: the one with
+// the smallest sum of absolute (signed) residuals. prev is nullptr for the
+// first row. scratch is reused across the rows of a strip: the five
+// residual rows are fully rewritten per row, and the sixth stays the zero
+// row standing in for prev, so it is only cleared when first sized.
+static void png_filter_row(const uint8_t* row, const uint8_t* prev, int row_bytes, int bpp, uint8_t* out, std::vector<uint8_t>& scratch) {
+    if (scratch.size() != static_cast<size_t>(row_bytes) * 6) {
+        scratch.assign(static_cast<size_t>(row_bytes) * 6, 0);
+    }
+    if (prev == nullptr) {
+        prev = scratch.data() + static_cast<size_t>(row_bytes) * 5;
+    }
+    uint8_t* residuals[5];
+    for (int filter = 0; filter < 5; ++filter) {
+        residuals[filter] = scratch.data() + static_cast<size_t>(filter) * row_bytes;
+    }
+    bpp = std::min(bpp, row_bytes);
+
+    memcpy(residuals[0], row, row_bytes);
+    for (int i = 0; i < bpp; ++i) {
+        residuals[1][i] = row[i];
+        residuals[3][i] = static_cast<uint8_t>(row[i] - (prev[i] >> 1));
+        residuals[4][i] = static_cast<uint8_t>(row[i] - prev[i]);
+    }
+    for (int i = bpp; i < row_bytes; ++i) {
+        residuals[1][i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+        residuals[3][i] = static_cast<uint8_t>(row[i] - ((row[i - bpp] + prev[i]) >> 1));
+    }
+    for (int i = 0; i < row_bytes; ++i) {
+        residuals[2][i] = static_cast<uint8_t>(row[i] - prev[i]);
+    }
+    for (int i = bpp; i < row_bytes; ++i) {
+        const int a  = row[i - bpp];
+        const int b  = prev[i];
+        const int c  = prev[i - bpp];
+        const int pa = std::abs(b - c);
+        const int pb = std::abs(a - c);
+        const int pc = std::abs(a + b - 2 * c);
+        const int p  = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+        residuals[4][i] = static_cast<uint8_t>(row[i] - p);
+    }
+
+    int best_filter = 0;
+    int best_value  = INT32_MAX;
+    for (int filter = 0; filter < 5; ++filter) {
+        int value = 0;
+        for (int i = 0; i < row_bytes; ++i) {
+            value += std::abs(static_cast<int>(static_cast<int8_t>(residuals[filter][i])));
+        }
+        if (value < best_value) {
+            best_value  = value;
+            best_filter = filter;
+        }
+    }
+    out[0] = static_cast<uint8_t>(best_filter);
+    memcpy(out + 1, residuals[best_filter], row_bytes);
+}
+
+static void png_write_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+    const uint32_t len = static_cast<uint32_t>(size);
+    out.insert(out.end(), {static_cast<uint8_t>(len >> 24), static_cast<uint8_t>(len >> 16),
+                           static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len)});
+    const size_t type_pos = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size > 0) {
+        out.insert(out.end(), data, data + size);
+    }
+    const uint32_t crc = png_crc32(0, out.data() + type_pos, size + 4);
+    out.insert(out.end(), {static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+                           static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)});
+}
+
+int png_compression_level_from_quality(int quality) {
+    // Capped at 8: on generated images level 9 encodes 25-40% slower for
+    // about 1% smaller files, and 100 is the server's default.
+    return std::min(8, (std::clamp(quality, 0, 100) * 9 + 50) / 100);
+}
+
+bool encode_png_to_vector(const uint8_t* image,
+                          int width,
+                          int height,
+                          int channels,
+                          const std::string& parameters,
+                          int level,
+                          int n_threads,
+                          std::vector<uint8_t>& out) {
+    static const uint8_t color_types[5] = {0, 0, 4, 2, 6};
+    if (image == nullptr || width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        return false;
+    }
+    const int row_bytes       = width * channels;
+    const size_t filtered_row = static_cast<size_t>(row_bytes) + 1;
+    n_threads                 = resolve_thread_count(n_threads);
+
+    // Strips of at least 256 KiB of filtered data, at most one per thread:
+    // each strip restarts the deflate window, which costs a little ratio.
+    const int min_strip_rows = static_cast<int>(std::max<size_t>(1, (256 * 1024 + filtered_row - 1) / filtered_row));
+    const int strip_rows     = std::max(min_strip_rows, (height + n_threads - 1) / n_threads);
+    const int strip_count    = (height + strip_rows - 1) / strip_rows;
+
+    std::vector<uint32_t> strip_adler(static_cast<size_t>(strip_count));
+    std::vector<size_t> strip_size(static_cast<size_t>(strip_count));
+    std::vector<std::vector<uint8_t>> strips;
+    bool ok = encode_parallel(strip_count, n_threads, strips, [&](int s, std::vector<uint8_t>& deflated) {
+        const int y0 = s * strip_rows;
+        const int y1 = std::min(height, y0 + strip_rows);
+        std::vector<uint8_t> filtered(filtered_row * static_cast<size_t>(y1 - y0));
+        std::vector<uint8_t> scratch;
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* row  = image + static_cast<size_t>(y) * row_bytes;
+            const uint8_t* prev = y > 0 ? row - row_bytes : nullptr;
+            png_filter_row(row, prev, row_bytes, channels, filtered.data() + filtered_row * (y - y0), scratch);
+        }
+        strip_adler[s] = adler32_update(1, filtered.data(), filtered.size());
+        strip_size[s]  = filtered.size();
+        deflated.reserve(filtered.size() / 2);
+        DeflateStripWriter(deflated, level).compress(filtered.data(), filtered.size(), s + 1 == strip_count);
+        return true;
+    });
+    if (!ok) {
+        return false;
+    }
+
+    size_t idat_size = 2 + 4;
+    for (const auto& strip : strips) {
+        idat_size += strip.size();
+    }
+    std::vector<uint8_t> idat;
+    idat.reserve(idat_size);
+    const uint8_t flevel = level <= 1 ? 0x01 : (level <= 5 ? 0x5E : (level == 6 ? 0x9C : 0xDA));
+    idat.insert(idat.end(), {0x78, flevel});
+    uint32_t adler = 1;
+    for (int s = 0; s < strip_count; ++s) {
+        idat.insert(idat.end(), strips[s].begin(), strips[s].end());
+        std::vector<uint8_t>().swap(strips[s]);
+        adler = adler32_combine(adler, strip_adler[s], strip_size[s]);
+    }
+    idat.insert(idat.end(), {static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+                             static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)});
+
+    // Same chunk layout as stb_image_write, including the "parameters" tEXt
+    // chunk that image_metadata.cpp reads back.
+    static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.clear();
+    out.reserve(idat.size() + parameters.size() + 64);
+    out.insert(out.end(), signature, signature + 8);
+    const uint8_t ihdr[13] = {
+        static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+        static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+        8, color_types[channels], 0, 0, 0};
+    png_write_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+    if (!parameters.empty()) {
+        std::vector<uint8_t> text;
+        text.reserve(parameters.size() + 11);
+        const char* keyword = "parameters";
+        text.insert(text.end(), keyword, keyword + strlen(keyword) + 1);
+        text.insert(text.end(), parameters.begin(), parameters.end());
+        png_write_chunk(out, "tEXt", text.data(), text.size());
+    }
+    png_write_chunk(out, "IDAT", idat.data(), idat.size());
+    png_write_chunk(out, "IEND", nullptr, 0);
+    return true;
 }
 
 EncodedImageFormat encoded_image_format_from_path(const std::string& path) {
@@ -727,7 +1268,7 @@ std::vector<uint8_t> encode_image_to_vector(EncodedImageFormat format,
             result = stbi_write_jpg_to_func(c_func, &ctx, width, height, channels, image, quality);
             break;
         case EncodedImageFormat::PNG:
-            result = stbi_ext_write_png_to_func(c_func, &ctx, width, height, channels, image, width * channels, parameters.empty() ? nullptr : parameters.c_str());
+            result = encode_png_to_vector(image, width, height, channels, parameters, png_compression_level_from_quality(quality), 0, buffer) ? 1 : 0;
             break;
         case EncodedImageFormat::WEBP:
 #ifdef SD_USE_WEBP
@@ -764,7 +1305,6 @@ bool write_image_to_file(const std::string& path,
         case EncodedImageFormat::JPEG:
             return stbi_write_jpg(path.c_str(), width, height, channels, image, quality, parameters.empty() ? nullptr : parameters.c_str()) != 0;
         case EncodedImageFormat::PNG:
-            return stbi_write_png(path.c_str(), width, height, channels, image, 0, parameters.empty() ? nullptr : parameters.c_str()) != 0;
         case EncodedImageFormat::WEBP: {
             const std::vector<uint8_t> encoded = encode_image_to_vector(format, image, width, height, channels, parameters, quality);
             return !encoded.empty() && write_binary_file_bytes(path, encoded);
@@ -780,7 +1320,7 @@ uint8_t* load_image_from_file(const char* image_path,
                               int expected_width,
                               int expected_height,
                               int expected_channel) {
-    return load_image_common(false, image_path, 0, width, height, expected_width, expected_height, expected_channel);
+    return load_image_common(false, image_path, 0, width, height, expected_width, expected_height, expected_channel, 1);
 }
 
 bool load_sd_image_from_file(sd_image_t* image,
@@ -790,7 +1330,7 @@ bool load_sd_image_from_file(sd_image_t* image,
                              int expected_channel) {
     int width;
     int height;
-    image->data = load_image_common(false, image_path, 0, width, height, expected_width, expected_height, expected_channel);
+    image->data = load_image_common(false, image_path, 0, width, height, expected_width, expected_height, expected_channel, 1);
     if (image->data == nullptr) {
         return false;
     }
@@ -806,524 +1346,988 @@ uint8_t* load_image_from_memory(const char* image_bytes,
                                 int& height,
                                 int expected_width,
                                 int expected_height,
-                                int expected_channel) {
-    return load_image_common(true, image_bytes, len, width, height, expected_width, expected_height, expected_channel);
+                                int expected_channel,
+                                int n_threads) {
+    return load_image_common(true, image_bytes, len, width, height, expected_width, expected_height, expected_channel, n_threads);
 }
 
-std::vector<uint8_t> create_mjpg_avi_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
-    if (num_images == 0) {
-        fprintf(stderr, "Error: Image array is empty.\n");
-        return {};
+void load_images_from_memory(std::vector<ImageLoadJob>& jobs, int n_threads) {
+    if (jobs.empty()) {
+        return;
     }
+    n_threads                = resolve_thread_count(n_threads);
+    const int job_count      = static_cast<int>(jobs.size());
+    const int resize_threads = std::max(1, n_threads / job_count);
+    run_parallel(job_count, n_threads, [&](int i) {
+        ImageLoadJob& job = jobs[i];
+        job.pixels        = nullptr;
+        if (job.bytes != nullptr && job.len > 0) {
+            job.pixels = load_image_common(true,
+                                           job.bytes,
+                                           job.len,
+                                           job.width,
+                                           job.height,
+                                           job.expected_width,
+                                           job.expected_height,
+                                           job.expected_channel,
+                                           resize_threads);
+        }
+        return true;
+    });
+}
 
-    uint32_t width    = images[0].width;
-    uint32_t height   = images[0].height;
-    uint32_t channels = images[0].channel;
-    if (channels != 3 && channels != 4) {
-        fprintf(stderr, "Error: Unsupported channel count: %u\n", channels);
-        return {};
+bool VectorMediaSink::write(const void* data, size_t size) {
+    if (size == 0) {
+        return true;
     }
+    if (data == nullptr) {
+        return false;
+    }
+    const size_t end_pos = position_ + size;
+    if (end_pos > data_.size()) {
+        data_.resize(end_pos);
+    }
+    memcpy(data_.data() + position_, data, size);
+    position_ = end_pos;
+    return true;
+}
 
-    // stb_image_write changes JPEG sampling behavior above quality 90.
-    // MJPG AVI playback is more compatible when we keep the encoder on the
-    // <= 90 path.
-    const int mjpg_quality               = std::clamp(quality, 1, 90);
-    const bool has_audio                 = audio != nullptr && audio->data != nullptr && audio->sample_count > 0 && audio->channels > 0 && audio->sample_rate > 0;
-    const std::vector<uint8_t> audio_pcm = audio_to_pcm16_bytes(audio);
-    const uint16_t audio_bits_per_sample = 16;
-    const uint16_t audio_block_align     = has_audio ? static_cast<uint16_t>(audio->channels * (audio_bits_per_sample / 8)) : 0;
-    const uint32_t audio_byte_rate       = has_audio ? static_cast<uint32_t>(audio->sample_rate * audio_block_align) : 0;
-    const uint32_t audio_data_size       = has_audio ? static_cast<uint32_t>(audio_pcm.size()) : 0;
-
-    std::vector<uint8_t> avi_data;
-    avi_data.reserve(static_cast<size_t>(num_images) * 1024);
-
-    write_fourcc(avi_data, "RIFF");
-    const size_t riff_size_pos = avi_data.size();
-    write_u32_le(avi_data, 0);
-    write_fourcc(avi_data, "AVI ");
-
-    write_fourcc(avi_data, "LIST");
-    uint32_t hdrl_size = 4 + 8 + 56 + 8 + 4 + 8 + 56 + 8 + 40;
-    if (has_audio) {
-        hdrl_size += 8 + (4 + 8 + 56 + 8 + 16);
-    }
-    write_u32_le(avi_data, hdrl_size);
-    write_fourcc(avi_data, "hdrl");
-
-    write_fourcc(avi_data, "avih");
-    write_u32_le(avi_data, 56);
-    write_u32_le(avi_data, 1000000 / fps);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0x110);
-    write_u32_le(avi_data, num_images);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, has_audio ? 2 : 1);
-    write_u32_le(avi_data, width * height * 3);
-    write_u32_le(avi_data, width);
-    write_u32_le(avi_data, height);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-
-    write_fourcc(avi_data, "LIST");
-    write_u32_le(avi_data, 4 + 8 + 56 + 8 + 40);
-    write_fourcc(avi_data, "strl");
-
-    write_fourcc(avi_data, "strh");
-    write_u32_le(avi_data, 56);
-    write_fourcc(avi_data, "vids");
-    write_fourcc(avi_data, "MJPG");
-    write_u32_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 1);
-    write_u32_le(avi_data, fps);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, num_images);
-    write_u32_le(avi_data, width * height * 3);
-    write_u32_le(avi_data, static_cast<uint32_t>(-1));
-    write_u32_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-    write_u16_le(avi_data, 0);
-
-    write_fourcc(avi_data, "strf");
-    write_u32_le(avi_data, 40);
-    write_u32_le(avi_data, 40);
-    write_u32_le(avi_data, width);
-    write_u32_le(avi_data, height);
-    write_u16_le(avi_data, 1);
-    write_u16_le(avi_data, 24);
-    write_fourcc(avi_data, "MJPG");
-    write_u32_le(avi_data, width * height * 3);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-    write_u32_le(avi_data, 0);
-
-    if (has_audio) {
-        write_fourcc(avi_data, "LIST");
-        write_u32_le(avi_data, 4 + 8 + 56 + 8 + 16);
-        write_fourcc(avi_data, "strl");
-
-        write_fourcc(avi_data, "strh");
-        write_u32_le(avi_data, 56);
-        write_fourcc(avi_data, "auds");
-        write_u32_le(avi_data, 0);
-        write_u32_le(avi_data, 0);
-        write_u16_le(avi_data, 0);
-        write_u16_le(avi_data, 0);
-        write_u32_le(avi_data, 0);
-        write_u32_le(avi_data, audio_block_align);
-        write_u32_le(avi_data, audio_byte_rate);
-        write_u32_le(avi_data, 0);
-        write_u32_le(avi_data, static_cast<uint32_t>(audio->sample_count));
-        write_u32_le(avi_data, audio_data_size);
-        write_u32_le(avi_data, static_cast<uint32_t>(-1));
-        write_u32_le(avi_data, audio_block_align);
-        write_u16_le(avi_data, 0);
-        write_u16_le(avi_data, 0);
-        write_u16_le(avi_data, 0);
-        write_u16_le(avi_data, 0);
-
-        write_fourcc(avi_data, "strf");
-        write_u32_le(avi_data, 16);
-        write_u16_le(avi_data, 1);
-        write_u16_le(avi_data, static_cast<uint16_t>(audio->channels));
-        write_u32_le(avi_data, audio->sample_rate);
-        write_u32_le(avi_data, audio_byte_rate);
-        write_u16_le(avi_data, audio_block_align);
-        write_u16_le(avi_data, audio_bits_per_sample);
-    }
-
-    write_fourcc(avi_data, "LIST");
-    const size_t movi_size_pos = avi_data.size();
-    write_u32_le(avi_data, 0);
-    write_fourcc(avi_data, "movi");
-
-    std::vector<avi_chunk_index_entry> index;
-    index.reserve(static_cast<size_t>(num_images) + (has_audio ? 1 : 0));
-    std::vector<uint8_t> jpeg_data;
-
-    for (int i = 0; i < num_images; i++) {
-        jpeg_data.clear();
-
-        auto write_to_buf = [](void* context, void* data, int size) {
-            auto* buffer       = reinterpret_cast<std::vector<uint8_t>*>(context);
-            const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
-            buffer->insert(buffer->end(), src, src + size);
-        };
-
-        if (!stbi_write_jpg_to_func(write_to_buf, &jpeg_data, images[i].width, images[i].height, channels, images[i].data, mjpg_quality)) {
-            fprintf(stderr, "Error: Failed to encode JPEG frame.\n");
-            return {};
-        }
+bool VectorMediaSink::seek(uint64_t position) {
+    const size_t target = static_cast<size_t>(position);
+    if (target > data_.size()) {
+        data_.resize(target);
+    }
+    position_ = target;
+    return true;
+}
 
-        avi_chunk_index_entry video_entry = {};
-        memcpy(video_entry.fourcc, "00dc", 4);
-        video_entry.flags  = 0x10;
-        video_entry.offset = static_cast<uint32_t>(avi_data.size());
-        write_fourcc(avi_data, "00dc");
-        write_u32_le(avi_data, static_cast<uint32_t>(jpeg_data.size()));
-        video_entry.size = static_cast<uint32_t>(jpeg_data.size());
-        avi_data.insert(avi_data.end(), jpeg_data.begin(), jpeg_data.end());
-        index.push_back(video_entry);
+FdMediaSink::FdMediaSink(int fd)
+    : fd_(fd) {
+    if (fd_ < 0) {
+        return;
+    }
+#ifdef _WIN32
+    const int64_t offset = _lseeki64(fd_, 0, SEEK_CUR);
+#else
+    const int64_t offset = static_cast<int64_t>(lseek(fd_, 0, SEEK_CUR));
+#endif
+    if (offset >= 0) {
+        seekable_ = true;
+        position_ = static_cast<uint64_t>(offset);
+    }
+}
 
-        if (jpeg_data.size() % 2) {
-            avi_data.push_back(0);
+bool FdMediaSink::write(const void* data, size_t size) {
+    if (fd_ < 0 || (data == nullptr && size > 0)) {
+        return false;
+    }
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t remaining   = size;
+    while (remaining > 0) {
+        // Keep single writes below 1 GiB; Windows takes an unsigned int count.
+        const size_t chunk = std::min<size_t>(remaining, 1u << 30);
+#ifdef _WIN32
+        const int written = _write(fd_, src, static_cast<unsigned int>(chunk));
+#else
+        const ssize_t written = ::write(fd_, src, chunk);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
         }
+        src += written;
+        remaining -= static_cast<size_t>(written);
+        position_ += static_cast<uint64_t>(written);
     }
+    return true;
+}
 
-    if (has_audio && !audio_pcm.empty()) {
-        avi_chunk_index_entry audio_entry = {};
-        memcpy(audio_entry.fourcc, "01wb", 4);
-        audio_entry.flags  = 0;
-        audio_entry.offset = static_cast<uint32_t>(avi_data.size());
-        audio_entry.size   = static_cast<uint32_t>(audio_pcm.size());
-        write_fourcc(avi_data, "01wb");
-        write_u32_le(avi_data, static_cast<uint32_t>(audio_pcm.size()));
-        avi_data.insert(avi_data.end(), audio_pcm.begin(), audio_pcm.end());
-        index.push_back(audio_entry);
-        if (audio_pcm.size() % 2 != 0) {
-            avi_data.push_back(0);
-        }
+bool FdMediaSink::seek(uint64_t position) {
+    if (!seekable_) {
+        return false;
+    }
+#ifdef _WIN32
+    const int64_t offset = _lseeki64(fd_, static_cast<int64_t>(position), SEEK_SET);
+#else
+    const int64_t offset = static_cast<int64_t>(lseek(fd_, static_cast<off_t>(position), SEEK_SET));
+#endif
+    if (offset < 0) {
+        return false;
     }
+    position_ = position;
+    return true;
+}
 
-    const size_t movi_size = avi_data.size() - movi_size_pos - 4;
-    patch_u32_le(avi_data, movi_size_pos, static_cast<uint32_t>(movi_size));
+static int open_output_file_fd(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
 
-    write_fourcc(avi_data, "idx1");
-    write_u32_le(avi_data, static_cast<uint32_t>(index.size() * 16));
-    for (const auto& entry : index) {
-        write_fourcc(avi_data, entry.fourcc);
-        write_u32_le(avi_data, entry.flags);
-        write_u32_le(avi_data, entry.offset);
-        write_u32_le(avi_data, entry.size);
-    }
+FileMediaSink::FileMediaSink(const std::string& path)
+    : FdMediaSink(open_output_file_fd(path)) {
+}
 
-    const size_t file_size = avi_data.size() - riff_size_pos - 4;
-    patch_u32_le(avi_data, riff_size_pos, static_cast<uint32_t>(file_size));
+FileMediaSink::~FileMediaSink() {
+    if (fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+    }
+}
 
-    return avi_data;
+bool CallbackMediaSink::write(const void* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    if (data == nullptr || !write_cb_) {
+        return false;
+    }
+    if (!write_cb_(static_cast<const uint8_t*>(data), size)) {
+        return false;
+    }
+    position_ += size;
+    return true;
 }
 
-int create_mjpg_avi_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
-    std::vector<uint8_t> avi_data = create_mjpg_avi_from_sd_images_to_vector(images, num_images, fps, quality, audio);
-    if (avi_data.empty()) {
-        return -1;
+static bool check_video_frame(const sd_image_t& frame, const VideoWriterOptions& options) {
+    if (frame.data == nullptr) {
+        fprintf(stderr, "Error: Video frame has no data.\n");
+        return false;
     }
-    if (!write_binary_file_bytes(filename, avi_data)) {
-        perror("Error opening file for writing");
-        return -1;
+    if (static_cast<int>(frame.width) != options.width || static_cast<int>(frame.height) != options.height) {
+        fprintf(stderr, "Error: Frame dimensions do not match.\n");
+        return false;
     }
-    return 0;
+    return true;
 }
 
-#ifdef SD_USE_WEBP
-std::vector<uint8_t> create_animated_webp_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality) {
-    if (num_images == 0) {
-        fprintf(stderr, "Error: Image array is empty.\n");
-        return {};
+// The RIFF and movi sizes are unknown until finalize(). They start out as
+// 0xFFFFFFFF ("open-ended") and are patched on seekable sinks; non-seekable
+// output keeps the placeholders, with the frame counts taken from
+// options.expected_frames, and relies on players rebuilding the sizes from
+// the chunks and idx1.
+class MjpgAviWriter : public VideoWriter {
+public:
+    MjpgAviWriter(MediaSink* sink, const VideoWriterOptions& options)
+        : sink_(sink), options_(options) {
+    }
+
+    bool open() {
+        const int width       = options_.width;
+        const int height      = options_.height;
+        const bool has_audio  = options_.audio_channels > 0 && options_.audio_sample_rate > 0;
+        const uint32_t frames = static_cast<uint32_t>(std::max(0, options_.expected_frames));
+        audio_block_align_    = has_audio ? static_cast<uint16_t>(options_.audio_channels * sizeof(int16_t)) : 0;
+        // stb_image_write changes JPEG sampling behavior above quality 90.
+        // MJPG AVI playback is more compatible when we keep the encoder on the
+        // <= 90 path.
+        mjpg_quality_ = std::clamp(options_.quality, 1, 90);
+        base_         = sink_->position();
+
+        std::vector<uint8_t> header;
+        write_fourcc(header, "RIFF");
+        riff_size_pos_ = header.size();
+        write_u32_le(header, UNKNOWN_SIZE);
+        write_fourcc(header, "AVI ");
+
+        write_fourcc(header, "LIST");
+        uint32_t hdrl_size = 4 + 8 + 56 + 8 + 4 + 8 + 56 + 8 + 40;
+        if (has_audio) {
+            hdrl_size += 8 + (4 + 8 + 56 + 8 + 16);
+        }
+        write_u32_le(header, hdrl_size);
+        write_fourcc(header, "hdrl");
+
+        write_fourcc(header, "avih");
+        write_u32_le(header, 56);
+        write_u32_le(header, 1000000 / options_.fps);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0x110);
+        avih_frames_pos_ = header.size();
+        write_u32_le(header, frames);
+        write_u32_le(header, 0);
+        write_u32_le(header, has_audio ? 2 : 1);
+        write_u32_le(header, width * height * 3);
+        write_u32_le(header, width);
+        write_u32_le(header, height);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+
+        write_fourcc(header, "LIST");
+        write_u32_le(header, 4 + 8 + 56 + 8 + 40);
+        write_fourcc(header, "strl");
+
+        write_fourcc(header, "strh");
+        write_u32_le(header, 56);
+        write_fourcc(header, "vids");
+        write_fourcc(header, "MJPG");
+        write_u32_le(header, 0);
+        write_u16_le(header, 0);
+        write_u16_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 1);
+        write_u32_le(header, options_.fps);
+        write_u32_le(header, 0);
+        video_length_pos_ = header.size();
+        write_u32_le(header, frames);
+        write_u32_le(header, width * height * 3);
+        write_u32_le(header, static_cast<uint32_t>(-1));
+        write_u32_le(header, 0);
+        write_u16_le(header, 0);
+        write_u16_le(header, 0);
+        write_u16_le(header, 0);
+        write_u16_le(header, 0);
+
+        write_fourcc(header, "strf");
+        write_u32_le(header, 40);
+        write_u32_le(header, 40);
+        write_u32_le(header, width);
+        write_u32_le(header, height);
+        write_u16_le(header, 1);
+        write_u16_le(header, 24);
+        write_fourcc(header, "MJPG");
+        write_u32_le(header, width * height * 3);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+        write_u32_le(header, 0);
+
+        if (has_audio) {
+            const uint32_t audio_byte_rate = options_.audio_sample_rate * audio_block_align_;
+
+            write_fourcc(header, "LIST");
+            write_u32_le(header, 4 + 8 + 56 + 8 + 16);
+            write_fourcc(header, "strl");
+
+            write_fourcc(header, "strh");
+            write_u32_le(header, 56);
+            write_fourcc(header, "auds");
+            write_u32_le(header, 0);
+            write_u32_le(header, 0);
+            write_u16_le(header, 0);
+            write_u16_le(header, 0);
+            write_u32_le(header, 0);
+            write_u32_le(header, audio_block_align_);
+            write_u32_le(header, audio_byte_rate);
+            write_u32_le(header, 0);
+            audio_length_pos_ = header.size();
+            write_u32_le(header, 0);
+            write_u32_le(header, 0);
+            write_u32_le(header, static_cast<uint32_t>(-1));
+            write_u32_le(header, audio_block_align_);
+            write_u16_le(header, 0);
+            write_u16_le(header, 0);
+            write_u16_le(header, 0);
+            write_u16_le(header, 0);
+
+            write_fourcc(header, "strf");
+            write_u32_le(header, 16);
+            write_u16_le(header, 1);
+            write_u16_le(header, static_cast<uint16_t>(options_.audio_channels));
+            write_u32_le(header, options_.audio_sample_rate);
+            write_u32_le(header, audio_byte_rate);
+            write_u16_le(header, audio_block_align_);
+            write_u16_le(header, 16);
+        }
+
+        write_fourcc(header, "LIST");
+        movi_size_pos_ = header.size();
+        write_u32_le(header, UNKNOWN_SIZE);
+        write_fourcc(header, "movi");
+
+        return sink_->write(header.data(), header.size());
     }
-    if (fps <= 0) {
-        fprintf(stderr, "Error: FPS must be positive.\n");
-        return {};
+
+    bool add_frame(const sd_image_t& frame) override {
+        if (!encode_frame(frame, jpeg_data_)) {
+            return false;
+        }
+        return write_frame(jpeg_data_);
     }
 
-    const int width    = static_cast<int>(images[0].width);
-    const int height   = static_cast<int>(images[0].height);
-    const int channels = static_cast<int>(images[0].channel);
-    if (channels != 1 && channels != 3 && channels != 4) {
-        fprintf(stderr, "Error: Unsupported channel count: %d\n", channels);
-        return {};
+    bool add_frames(const sd_image_t* frames, int count) override {
+        if (count <= 1) {
+            return count <= 0 || add_frame(frames[0]);
+        }
+        std::vector<std::vector<uint8_t>> encoded;
+        if (!encode_parallel(count, options_.n_threads, encoded, [&](int i, std::vector<uint8_t>& out) {
+                return encode_frame(frames[i], out);
+            })) {
+            return false;
+        }
+        for (const auto& jpeg : encoded) {
+            if (!write_frame(jpeg)) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    WebPAnimEncoderOptions anim_options;
-    WebPConfig config;
-    if (!WebPAnimEncoderOptionsInit(&anim_options) || !WebPConfigInit(&config)) {
-        fprintf(stderr, "Error: Failed to initialize WebP animation encoder.\n");
-        return {};
+    bool add_audio(const float* samples, uint64_t sample_count) override {
+        if (audio_block_align_ == 0) {
+            fprintf(stderr, "Error: AVI writer was opened without an audio track.\n");
+            return false;
+        }
+        if (samples == nullptr || sample_count == 0) {
+            return true;
+        }
+        const std::vector<uint8_t> pcm = audio_to_pcm16_bytes(samples, static_cast<size_t>(sample_count) * options_.audio_channels);
+        if (!write_chunk("01wb", 0, pcm.data(), pcm.size())) {
+            return false;
+        }
+        audio_samples_ += sample_count;
+        audio_bytes_ += pcm.size();
+        return true;
     }
 
-    config.quality      = static_cast<float>(quality);
-    config.method       = 4;
-    config.thread_level = 1;
-    if (channels == 4) {
-        config.exact = 1;
+    bool finalize() override {
+        const uint64_t movi_end = sink_->position() - base_;
+
+        std::vector<uint8_t> trailer;
+        trailer.reserve(8 + index_.size() * 16);
+        write_fourcc(trailer, "idx1");
+        write_u32_le(trailer, static_cast<uint32_t>(index_.size() * 16));
+        for (const auto& entry : index_) {
+            write_fourcc(trailer, entry.fourcc);
+            write_u32_le(trailer, entry.flags);
+            write_u32_le(trailer, entry.offset);
+            write_u32_le(trailer, entry.size);
+        }
+        if (!sink_->write(trailer.data(), trailer.size())) {
+            return false;
+        }
+        if (!sink_->seekable()) {
+            // Streamed output keeps the 0xFFFFFFFF sizes and expected_frames.
+            return true;
+        }
+
+        const uint64_t end = sink_->position();
+        bool ok            = patch_u32(riff_size_pos_, static_cast<uint32_t>(end - base_ - riff_size_pos_ - 4)) &&
+                  patch_u32(movi_size_pos_, static_cast<uint32_t>(movi_end - movi_size_pos_ - 4)) &&
+                  patch_u32(avih_frames_pos_, static_cast<uint32_t>(frame_count_)) &&
+                  patch_u32(video_length_pos_, static_cast<uint32_t>(frame_count_));
+        if (ok && audio_length_pos_ != 0) {
+            ok = patch_u32(audio_length_pos_, static_cast<uint32_t>(audio_samples_)) &&
+                 patch_u32(audio_length_pos_ + 4, static_cast<uint32_t>(audio_bytes_));
+        }
+        return ok && sink_->seek(end);
     }
-    if (!WebPValidateConfig(&config)) {
-        fprintf(stderr, "Error: Invalid WebP encoder configuration.\n");
-        return {};
+
+private:
+    static constexpr uint32_t UNKNOWN_SIZE = 0xFFFFFFFFu;
+
+    bool encode_frame(const sd_image_t& frame, std::vector<uint8_t>& jpeg) const {
+        if (!check_video_frame(frame, options_)) {
+            return false;
+        }
+        if (frame.channel != 3 && frame.channel != 4) {
+            fprintf(stderr, "Error: Unsupported channel count: %u\n", frame.channel);
+            return false;
+        }
+
+        jpeg.clear();
+        auto write_to_buf = [](void* context, void* data, int size) {
+            auto* buffer       = reinterpret_cast<std::vector<uint8_t>*>(context);
+            const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+            buffer->insert(buffer->end(), src, src + size);
+        };
+        if (!stbi_write_jpg_to_func(write_to_buf, &jpeg, frame.width, frame.height, frame.channel, frame.data, mjpg_quality_)) {
+            fprintf(stderr, "Error: Failed to encode JPEG frame.\n");
+            return false;
+        }
+        return true;
     }
 
-    WebPAnimEncoderPtr enc(WebPAnimEncoderNew(width, height, &anim_options));
-    if (enc == nullptr) {
-        fprintf(stderr, "Error: Could not create WebPAnimEncoder object.\n");
-        return {};
+    bool write_frame(const std::vector<uint8_t>& jpeg) {
+        if (!write_chunk("00dc", 0x10, jpeg.data(), jpeg.size())) {
+            return false;
+        }
+        frame_count_++;
+        return true;
+    }
+
+    bool write_chunk(const char* fourcc, uint32_t flags, const uint8_t* data, size_t size) {
+        avi_chunk_index_entry entry = {};
+        memcpy(entry.fourcc, fourcc, 4);
+        entry.flags  = flags;
+        entry.offset = static_cast<uint32_t>(sink_->position() - base_);
+        entry.size   = static_cast<uint32_t>(size);
+
+        uint8_t chunk_header[8];
+        memcpy(chunk_header, fourcc, 4);
+        for (int i = 0; i < 4; ++i) {
+            chunk_header[4 + i] = static_cast<uint8_t>((entry.size >> (8 * i)) & 0xFF);
+        }
+        const uint8_t pad = 0;
+        if (!sink_->write(chunk_header, sizeof(chunk_header)) ||
+            !sink_->write(data, size) ||
+            (size % 2 != 0 && !sink_->write(&pad, 1))) {
+            fprintf(stderr, "Error: Failed to write AVI chunk.\n");
+            return false;
+        }
+        index_.push_back(entry);
+        return true;
     }
 
-    const int frame_duration_ms = std::max(1, static_cast<int>(std::lround(1000.0 / static_cast<double>(fps))));
-    int timestamp_ms            = 0;
+    bool patch_u32(size_t offset, uint32_t val) {
+        uint8_t bytes[4];
+        for (int i = 0; i < 4; ++i) {
+            bytes[i] = static_cast<uint8_t>((val >> (8 * i)) & 0xFF);
+        }
+        return sink_->seek(base_ + offset) && sink_->write(bytes, sizeof(bytes));
+    }
+
+    MediaSink* sink_;
+    VideoWriterOptions options_;
+    uint64_t base_              = 0;
+    int mjpg_quality_           = 90;
+    uint16_t audio_block_align_ = 0;
+    size_t riff_size_pos_       = 0;
+    size_t avih_frames_pos_     = 0;
+    size_t video_length_pos_    = 0;
+    size_t audio_length_pos_    = 0;
+    size_t movi_size_pos_       = 0;
+    uint64_t audio_samples_     = 0;
+    uint64_t audio_bytes_       = 0;
+    std::vector<avi_chunk_index_entry> index_;
+    std::vector<uint8_t> jpeg_data_;
+};
+
+#ifdef SD_USE_WEBP
+// WebPAnimEncoder only assembles the file at the end, but it keeps frames
+// compressed, so the raw frames still do not pile up. There is no audio track.
+class AnimatedWebpWriter : public VideoWriter {
+public:
+    AnimatedWebpWriter(MediaSink* sink, const VideoWriterOptions& options)
+        : sink_(sink), options_(options) {
+    }
 
-    for (int i = 0; i < num_images; ++i) {
-        const sd_image_t& image = images[i];
-        if (static_cast<int>(image.width) != width || static_cast<int>(image.height) != height) {
-            fprintf(stderr, "Error: Frame dimensions do not match.\n");
-            return {};
+    bool open() {
+        WebPAnimEncoderOptions anim_options;
+        if (!WebPAnimEncoderOptionsInit(&anim_options) || !WebPConfigInit(&config_)) {
+            fprintf(stderr, "Error: Failed to initialize WebP animation encoder.\n");
+            return false;
+        }
+        config_.quality      = static_cast<float>(options_.quality);
+        config_.method       = 4;
+        config_.thread_level = 1;
+        if (!WebPValidateConfig(&config_)) {
+            fprintf(stderr, "Error: Invalid WebP encoder configuration.\n");
+            return false;
+        }
+        enc_.reset(WebPAnimEncoderNew(options_.width, options_.height, &anim_options));
+        if (enc_ == nullptr) {
+            fprintf(stderr, "Error: Could not create WebPAnimEncoder object.\n");
+            return false;
+        }
+        frame_duration_ms_ = std::max(1, static_cast<int>(std::lround(1000.0 / static_cast<double>(options_.fps))));
+        return true;
+    }
+
+    bool add_frame(const sd_image_t& image) override {
+        if (!check_video_frame(image, options_)) {
+            return false;
+        }
+        const int width  = options_.width;
+        const int height = options_.height;
+        if (image.channel != 1 && image.channel != 3 && image.channel != 4) {
+            fprintf(stderr, "Error: Unsupported channel count: %u\n", image.channel);
+            return false;
         }
 
         WebPPictureGuard picture;
         if (!picture.initialized) {
             fprintf(stderr, "Error: Failed to initialize WebPPicture.\n");
-            return {};
+            return false;
         }
         picture.picture.use_argb = 1;
         picture.picture.width    = width;
         picture.picture.height   = height;
 
         bool picture_ok = false;
-        std::vector<uint8_t> rgb_buffer;
         if (image.channel == 1) {
-            rgb_buffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 3);
+            rgb_buffer_.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 3);
             for (int p = 0; p < width * height; ++p) {
-                rgb_buffer[p * 3 + 0] = image.data[p];
-                rgb_buffer[p * 3 + 1] = image.data[p];
-                rgb_buffer[p * 3 + 2] = image.data[p];
+                rgb_buffer_[p * 3 + 0] = image.data[p];
+                rgb_buffer_[p * 3 + 1] = image.data[p];
+                rgb_buffer_[p * 3 + 2] = image.data[p];
             }
-            picture_ok = WebPPictureImportRGB(&picture.picture, rgb_buffer.data(), width * 3) != 0;
+            picture_ok = WebPPictureImportRGB(&picture.picture, rgb_buffer_.data(), width * 3) != 0;
         } else if (image.channel == 4) {
             picture_ok = WebPPictureImportRGBA(&picture.picture, image.data, width * 4) != 0;
         } else {
             picture_ok = WebPPictureImportRGB(&picture.picture, image.data, width * 3) != 0;
         }
-
         if (!picture_ok) {
             fprintf(stderr, "Error: Failed to import frame into WebPPicture.\n");
-            return {};
+            return false;
         }
 
-        if (!WebPAnimEncoderAdd(enc.get(), &picture.picture, timestamp_ms, &config)) {
-            fprintf(stderr, "Error: Failed to add frame to animated WebP: %s\n", WebPAnimEncoderGetError(enc.get()));
-            return {};
+        WebPConfig config = config_;
+        config.exact      = image.channel == 4 ? 1 : 0;
+        if (!WebPAnimEncoderAdd(enc_.get(), &picture.picture, timestamp_ms_, &config)) {
+            fprintf(stderr, "Error: Failed to add frame to animated WebP: %s\n", WebPAnimEncoderGetError(enc_.get()));
+            return false;
         }
-
-        timestamp_ms += frame_duration_ms;
+        timestamp_ms_ += frame_duration_ms_;
+        frame_count_++;
+        return true;
     }
 
-    if (!WebPAnimEncoderAdd(enc.get(), nullptr, timestamp_ms, nullptr)) {
-        fprintf(stderr, "Error: Failed to finalize animated WebP frames: %s\n", WebPAnimEncoderGetError(enc.get()));
-        return {};
+    bool add_audio(const float* samples, uint64_t sample_count) override {
+        (void)samples;
+        (void)sample_count;
+        return true;
     }
 
-    WebPDataGuard webp_data;
-    if (!WebPAnimEncoderAssemble(enc.get(), &webp_data.data)) {
-        fprintf(stderr, "Error: Failed to assemble animated WebP: %s\n", WebPAnimEncoderGetError(enc.get()));
-        return {};
+    bool finalize() override {
+        if (!WebPAnimEncoderAdd(enc_.get(), nullptr, timestamp_ms_, nullptr)) {
+            fprintf(stderr, "Error: Failed to finalize animated WebP frames: %s\n", WebPAnimEncoderGetError(enc_.get()));
+            return false;
+        }
+        WebPDataGuard webp_data;
+        if (!WebPAnimEncoderAssemble(enc_.get(), &webp_data.data)) {
+            fprintf(stderr, "Error: Failed to assemble animated WebP: %s\n", WebPAnimEncoderGetError(enc_.get()));
+            return false;
+        }
+        return sink_->write(webp_data.data.bytes, webp_data.data.size);
     }
 
-    return std::vector<uint8_t>(webp_data.data.bytes, webp_data.data.bytes + webp_data.data.size);
-}
-
-int create_animated_webp_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality) {
-    std::vector<uint8_t> webp_data = create_animated_webp_from_sd_images_to_vector(images, num_images, fps, quality);
-    if (webp_data.empty()) {
-        return -1;
-    }
-    if (!write_binary_file_bytes(filename, webp_data)) {
-        perror("Error opening file for writing");
-        return -1;
-    }
-    return 0;
-}
+private:
+    MediaSink* sink_;
+    VideoWriterOptions options_;
+    WebPConfig config_;
+    WebPAnimEncoderPtr enc_;
+    int frame_duration_ms_ = 1;
+    int timestamp_ms_      = 0;
+    std::vector<uint8_t> rgb_buffer_;
+};
 #endif
 
 #ifdef SD_USE_WEBM
-std::vector<uint8_t> create_webm_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
-    if (num_images == 0) {
-        fprintf(stderr, "Error: Image array is empty.\n");
-        return {};
-    }
-    if (fps <= 0) {
-        fprintf(stderr, "Error: FPS must be positive.\n");
-        return {};
-    }
-
-    const int width  = static_cast<int>(images[0].width);
-    const int height = static_cast<int>(images[0].height);
-    if (width <= 0 || height <= 0) {
-        fprintf(stderr, "Error: Invalid frame dimensions.\n");
-        return {};
+// Seekable sinks get a regular file with cues; other sinks get a live-mode
+// stream with open-ended element sizes.
+class WebmWriter : public VideoWriter {
+public:
+    WebmWriter(MediaSink* sink, const VideoWriterOptions& options)
+        : mkv_writer_(sink), options_(options) {
     }
 
-    MemoryMkvWriter writer;
-
-    const int ret = [&]() -> int {
-        mkvmuxer::Segment segment;
-        if (!segment.Init(&writer)) {
+    bool open() {
+        const bool seekable = mkv_writer_.Seekable();
+        if (!segment_.Init(&mkv_writer_)) {
             fprintf(stderr, "Error: Failed to initialize WebM muxer.\n");
-            return -1;
+            return false;
         }
+        segment_.set_mode(seekable ? mkvmuxer::Segment::kFile : mkvmuxer::Segment::kLive);
+        segment_.OutputCues(seekable);
 
-        segment.set_mode(mkvmuxer::Segment::kFile);
-        segment.OutputCues(true);
-
-        const uint64_t track_number = segment.AddVideoTrack(width, height, 0);
-        if (track_number == 0) {
+        video_track_ = segment_.AddVideoTrack(options_.width, options_.height, 0);
+        if (video_track_ == 0) {
             fprintf(stderr, "Error: Failed to add VP8 video track.\n");
-            return -1;
+            return false;
         }
-        if (!segment.CuesTrack(track_number)) {
+        if (seekable && !segment_.CuesTrack(video_track_)) {
             fprintf(stderr, "Error: Failed to set WebM cues track.\n");
-            return -1;
+            return false;
         }
 
-        mkvmuxer::VideoTrack* video_track = static_cast<mkvmuxer::VideoTrack*>(segment.GetTrackByNumber(track_number));
+        mkvmuxer::VideoTrack* video_track = static_cast<mkvmuxer::VideoTrack*>(segment_.GetTrackByNumber(video_track_));
         if (video_track != nullptr) {
-            video_track->set_display_width(static_cast<uint64_t>(width));
-            video_track->set_display_height(static_cast<uint64_t>(height));
-            video_track->set_frame_rate(static_cast<double>(fps));
+            video_track->set_display_width(static_cast<uint64_t>(options_.width));
+            video_track->set_display_height(static_cast<uint64_t>(options_.height));
+            video_track->set_frame_rate(static_cast<double>(options_.fps));
         }
 
-        uint64_t audio_track_number    = 0;
-        std::vector<uint8_t> audio_pcm = audio_to_pcm16_bytes(audio);
-        if (audio != nullptr && !audio_pcm.empty()) {
-            audio_track_number = segment.AddAudioTrack(static_cast<int32_t>(audio->sample_rate), static_cast<int32_t>(audio->channels), 0);
-            if (audio_track_number == 0) {
+        if (options_.audio_channels > 0 && options_.audio_sample_rate > 0) {
+            audio_track_ = segment_.AddAudioTrack(static_cast<int32_t>(options_.audio_sample_rate), static_cast<int32_t>(options_.audio_channels), 0);
+            if (audio_track_ == 0) {
                 fprintf(stderr, "Error: Failed to add audio track.\n");
-                return -1;
+                return false;
             }
-            auto* audio_track = static_cast<mkvmuxer::AudioTrack*>(segment.GetTrackByNumber(audio_track_number));
+            auto* audio_track = static_cast<mkvmuxer::AudioTrack*>(segment_.GetTrackByNumber(audio_track_));
             if (audio_track == nullptr) {
                 fprintf(stderr, "Error: Failed to get audio track.\n");
-                return -1;
+                return false;
             }
             audio_track->set_codec_id("A_PCM/INT/LIT");
             audio_track->set_bit_depth(16);
-            audio_track->set_sample_rate(static_cast<double>(audio->sample_rate));
-            audio_track->set_channels(audio->channels);
+            audio_track->set_sample_rate(static_cast<double>(options_.audio_sample_rate));
+            audio_track->set_channels(options_.audio_channels);
         }
-        segment.GetSegmentInfo()->set_writing_app("stable-diffusion.cpp");
-        segment.GetSegmentInfo()->set_muxing_app("stable-diffusion.cpp");
-
-        const uint64_t frame_duration_ns = std::max<uint64_t>(
-            1, static_cast<uint64_t>(std::llround(1000000000.0 / static_cast<double>(fps))));
-        uint64_t timestamp_ns = 0;
-
-        for (int i = 0; i < num_images; ++i) {
-            const sd_image_t& image = images[i];
-            if (static_cast<int>(image.width) != width || static_cast<int>(image.height) != height) {
-                fprintf(stderr, "Error: Frame dimensions do not match.\n");
-                return -1;
-            }
+        segment_.GetSegmentInfo()->set_writing_app("stable-diffusion.cpp");
+        segment_.GetSegmentInfo()->set_muxing_app("stable-diffusion.cpp");
 
-            std::vector<uint8_t> vp8_frame;
-            if (!encode_sd_image_to_vp8_frame(image, quality, vp8_frame)) {
-                fprintf(stderr, "Error: Failed to encode frame %d as VP8.\n", i);
-                return -1;
-            }
+        frame_duration_ns_ = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::llround(1000000000.0 / static_cast<double>(options_.fps))));
+        return true;
+    }
 
-            if (!segment.AddFrame(vp8_frame.data(),
-                                  static_cast<uint64_t>(vp8_frame.size()),
-                                  track_number,
-                                  timestamp_ns,
-                                  true)) {
-                fprintf(stderr, "Error: Failed to mux frame %d into WebM.\n", i);
-                return -1;
-            }
+    bool add_frame(const sd_image_t& image) override {
+        if (!encode_frame(image, frame_count_, vp8_frame_)) {
+            return false;
+        }
+        return write_frame(vp8_frame_);
+    }
 
-            if (audio_track_number != 0) {
-                auto [audio_begin, audio_end] = audio_sample_range_for_video_frame(audio, i, num_images, fps);
-                const uint64_t frame_samples  = audio_end - audio_begin;
-                if (frame_samples > 0) {
-                    const uint64_t frame_bytes = frame_samples * audio->channels * sizeof(int16_t);
-                    const uint8_t* frame_ptr   = audio_pcm.data() + audio_begin * audio->channels * sizeof(int16_t);
-                    if (!segment.AddFrame(frame_ptr,
-                                          frame_bytes,
-                                          audio_track_number,
-                                          timestamp_ns,
-                                          true)) {
-                        fprintf(stderr, "Error: Failed to mux audio chunk %d into WebM.\n", i);
-                        return -1;
-                    }
-                }
+    bool add_frames(const sd_image_t* frames, int count) override {
+        if (count <= 1) {
+            return count <= 0 || add_frame(frames[0]);
+        }
+        const int first_frame = frame_count_;
+        std::vector<std::vector<uint8_t>> encoded;
+        if (!encode_parallel(count, options_.n_threads, encoded, [&](int i, std::vector<uint8_t>& out) {
+                return encode_frame(frames[i], first_frame + i, out);
+            })) {
+            return false;
+        }
+        for (const auto& vp8_frame : encoded) {
+            if (!write_frame(vp8_frame)) {
+                return false;
             }
+        }
+        return true;
+    }
 
-            timestamp_ns += frame_duration_ns;
+    bool add_audio(const float* samples, uint64_t sample_count) override {
+        if (audio_track_ == 0) {
+            fprintf(stderr, "Error: WebM writer was opened without an audio track.\n");
+            return false;
         }
+        if (samples == nullptr || sample_count == 0) {
+            return true;
+        }
+        const std::vector<uint8_t> pcm = audio_to_pcm16_bytes(samples, static_cast<size_t>(sample_count) * options_.audio_channels);
+        pending_audio_.insert(pending_audio_.end(), pcm.begin(), pcm.end());
+        return true;
+    }
 
-        if (!segment.Finalize()) {
+    bool finalize() override {
+        if (!mux_pending_audio(true)) {
+            return false;
+        }
+        if (!segment_.Finalize()) {
             fprintf(stderr, "Error: Failed to finalize WebM output.\n");
-            return -1;
+            return false;
         }
-        return 0;
-    }();
-    if (ret != 0) {
-        return {};
+        return true;
     }
-    return writer.data();
-}
 
-int create_webm_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
-    std::vector<uint8_t> webm_data = create_webm_from_sd_images_to_vector(images, num_images, fps, quality, audio);
-    if (webm_data.empty()) {
-        return -1;
+private:
+    bool encode_frame(const sd_image_t& image, int frame_idx, std::vector<uint8_t>& vp8_frame) const {
+        if (!check_video_frame(image, options_)) {
+            return false;
+        }
+        if (!encode_sd_image_to_vp8_frame(image, options_.quality, vp8_frame)) {
+            fprintf(stderr, "Error: Failed to encode frame %d as VP8.\n", frame_idx);
+            return false;
+        }
+        return true;
     }
-    if (!write_binary_file_bytes(filename, webm_data)) {
-        perror("Error opening file for writing");
-        return -1;
+
+    bool write_frame(const std::vector<uint8_t>& vp8_frame) {
+        const uint64_t timestamp_ns = static_cast<uint64_t>(frame_count_) * frame_duration_ns_;
+        if (!segment_.AddFrame(vp8_frame.data(),
+                               static_cast<uint64_t>(vp8_frame.size()),
+                               video_track_,
+                               timestamp_ns,
+                               true)) {
+            fprintf(stderr, "Error: Failed to mux frame %d into WebM.\n", frame_count_);
+            return false;
+        }
+        frame_count_++;
+        return mux_pending_audio(false);
     }
-    return 0;
-}
+
+    // Audio is muxed in blocks that end on frame boundaries, and only once
+    // the frame a block plays under has been added (mkvmuxer needs the video
+    // to lead). On finalize whatever is left follows the last frame.
+    bool mux_pending_audio(bool flush) {
+        if (audio_track_ == 0) {
+            return true;
+        }
+        const uint64_t rate           = options_.audio_sample_rate;
+        const uint64_t fps            = static_cast<uint64_t>(options_.fps);
+        const size_t bytes_per_sample = options_.audio_channels * sizeof(int16_t);
+        while (pending_audio_offset_ < pending_audio_.size()) {
+            const uint64_t frame_idx = (audio_samples_muxed_ * fps) / rate;
+            if (!flush && frame_idx >= static_cast<uint64_t>(frame_count_)) {
+                break;
+            }
+            const uint64_t frame_end_sample = ((frame_idx + 1) * rate + fps - 1) / fps;
+            const uint64_t available        = (pending_audio_.size() - pending_audio_offset_) / bytes_per_sample;
+            const uint64_t block_samples    = std::min(available, frame_end_sample - audio_samples_muxed_);
+            if (block_samples == 0) {
+                break;
+            }
+            const size_t block_bytes = static_cast<size_t>(block_samples) * bytes_per_sample;
+            if (!segment_.AddFrame(pending_audio_.data() + pending_audio_offset_,
+                                   block_bytes,
+                                   audio_track_,
+                                   (audio_samples_muxed_ * 1000000000ull) / rate,
+                                   true)) {
+                fprintf(stderr, "Error: Failed to mux audio chunk %llu into WebM.\n", (unsigned long long)frame_idx);
+                return false;
+            }
+            pending_audio_offset_ += block_bytes;
+            audio_samples_muxed_ += block_samples;
+        }
+        if (pending_audio_offset_ == pending_audio_.size()) {
+            pending_audio_.clear();
+            pending_audio_offset_ = 0;
+        }
+        return true;
+    }
+
+    MediaSinkMkvWriter mkv_writer_;
+    mkvmuxer::Segment segment_;
+    VideoWriterOptions options_;
+    uint64_t video_track_       = 0;
+    uint64_t audio_track_       = 0;
+    uint64_t frame_duration_ns_ = 1;
+    std::vector<uint8_t> vp8_frame_;
+    std::vector<uint8_t> pending_audio_;
+    size_t pending_audio_offset_  = 0;
+    uint64_t audio_samples_muxed_ = 0;
+};
 #endif
 
-std::vector<uint8_t> create_video_from_sd_images_to_vector(const std::string& output_format,
-                                                           sd_image_t* images,
-                                                           int num_images,
-                                                           int fps,
-                                                           int quality,
-                                                           const sd_audio_t* audio) {
+static std::string normalize_video_format(const std::string& output_format) {
     std::string format = output_format;
     std::transform(format.begin(), format.end(), format.begin(),
                    [](unsigned char c) { return static_cast<char>(tolower(c)); });
     if (!format.empty() && format[0] == '.') {
         format.erase(format.begin());
     }
+    return format;
+}
+
+std::unique_ptr<VideoWriter> open_video_writer(const std::string& output_format,
+                                               MediaSink* sink,
+                                               const VideoWriterOptions& options) {
+    if (sink == nullptr) {
+        return nullptr;
+    }
+    if (options.fps <= 0) {
+        fprintf(stderr, "Error: FPS must be positive.\n");
+        return nullptr;
+    }
+    if (options.width <= 0 || options.height <= 0) {
+        fprintf(stderr, "Error: Invalid frame dimensions.\n");
+        return nullptr;
+    }
+    const std::string format = normalize_video_format(output_format);
 
 #ifdef SD_USE_WEBM
     if (format == "webm") {
-        return create_webm_from_sd_images_to_vector(images, num_images, fps, quality, audio);
+        auto writer = std::make_unique<WebmWriter>(sink, options);
+        return writer->open() ? std::move(writer) : nullptr;
     }
 #endif
 
 #ifdef SD_USE_WEBP
     if (format == "webp") {
-        return create_animated_webp_from_sd_images_to_vector(images, num_images, fps, quality);
+        auto writer = std::make_unique<AnimatedWebpWriter>(sink, options);
+        return writer->open() ? std::move(writer) : nullptr;
     }
 #endif
 
-    return create_mjpg_avi_from_sd_images_to_vector(images, num_images, fps, quality, audio);
+    auto writer = std::make_unique<MjpgAviWriter>(sink, options);
+    return writer->open() ? std::move(writer) : nullptr;
 }
 
-int create_video_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
-    std::string path                = filename ? filename : "";
-    auto pos                        = path.find_last_of('.');
-    std::string ext                 = pos == std::string::npos ? "" : path.substr(pos);
-    std::vector<uint8_t> video_data = create_video_from_sd_images_to_vector(ext, images, num_images, fps, quality, audio);
-    if (video_data.empty()) {
-        return -1;
+// Runs a whole frame array through a writer. Audio goes in first so the
+// writers can interleave it with the frames.
+static bool write_sd_images_to_sink(const std::string& output_format,
+                                    MediaSink* sink,
+                                    sd_image_t* images,
+                                    int num_images,
+                                    int fps,
+                                    int quality,
+                                    const sd_audio_t* audio) {
+    if (images == nullptr || num_images <= 0) {
+        fprintf(stderr, "Error: Image array is empty.\n");
+        return false;
+    }
+    const std::string format = normalize_video_format(output_format);
+    const bool mux_audio     = has_audio_samples(audio) && format != "webp";
+
+    VideoWriterOptions options;
+    options.width             = static_cast<int>(images[0].width);
+    options.height            = static_cast<int>(images[0].height);
+    options.fps               = fps;
+    options.quality           = quality;
+    options.audio_sample_rate = mux_audio ? audio->sample_rate : 0;
+    options.audio_channels    = mux_audio ? audio->channels : 0;
+    options.expected_frames   = num_images;
+
+    std::unique_ptr<VideoWriter> writer = open_video_writer(format, sink, options);
+    if (writer == nullptr) {
+        return false;
+    }
+    if (mux_audio && !writer->add_audio(audio->data, audio->sample_count)) {
+        return false;
+    }
+    if (!writer->add_frames(images, num_images)) {
+        return false;
+    }
+    return writer->finalize();
+}
+
+StreamingVideoOutput::StreamingVideoOutput(const std::string& output_format,
+                                           MediaSink* sink,
+                                           const VideoWriterOptions& options)
+    : format_(normalize_video_format(output_format)), sink_(sink), options_(options) {
+}
+
+void StreamingVideoOutput::attach(sd_vid_gen_params_t* params) {
+    params->frame_sink      = &StreamingVideoOutput::on_frames;
+    params->audio_sink      = &StreamingVideoOutput::on_audio;
+    params->frame_sink_data = this;
+}
+
+bool StreamingVideoOutput::on_frames(const sd_image_t* frames, int first_frame, int frame_count, void* data) {
+    (void)first_frame;
+    return static_cast<StreamingVideoOutput*>(data)->add_frames(frames, frame_count);
+}
+
+bool StreamingVideoOutput::on_audio(const sd_audio_t* audio, void* data) {
+    auto* self = static_cast<StreamingVideoOutput*>(data);
+    if (!has_audio_samples(audio)) {
+        return true;
+    }
+    self->audio_samples_.assign(audio->data, audio->data + audio->sample_count * audio->channels);
+    self->audio_      = *audio;
+    self->audio_.data = self->audio_samples_.data();
+    return true;
+}
+
+bool StreamingVideoOutput::add_frames(const sd_image_t* frames, int frame_count) {
+    if (failed_) {
+        return false;
     }
-    if (!write_binary_file_bytes(filename, video_data)) {
-        perror("Error opening file for writing");
+    if (writer_ == nullptr) {
+        const bool mux_audio = audio_.data != nullptr && format_ != "webp";
+
+        VideoWriterOptions options = options_;
+        options.width              = static_cast<int>(frames[0].width);
+        options.height             = static_cast<int>(frames[0].height);
+        options.audio_sample_rate  = mux_audio ? audio_.sample_rate : 0;
+        options.audio_channels     = mux_audio ? audio_.channels : 0;
+
+        writer_ = open_video_writer(format_, sink_, options);
+        if (writer_ == nullptr ||
+            (mux_audio && !writer_->add_audio(audio_.data, audio_.sample_count))) {
+            failed_ = true;
+            return false;
+        }
+        audio_muxed_ = mux_audio;
+    }
+    if (!writer_->add_frames(frames, frame_count)) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool StreamingVideoOutput::finalize() {
+    if (failed_ || writer_ == nullptr) {
+        return false;
+    }
+    return writer_->finalize();
+}
+
+static std::vector<uint8_t> write_sd_images_to_vector(const std::string& output_format,
+                                                      sd_image_t* images,
+                                                      int num_images,
+                                                      int fps,
+                                                      int quality,
+                                                      const sd_audio_t* audio) {
+    VectorMediaSink sink;
+    if (!write_sd_images_to_sink(output_format, &sink, images, num_images, fps, quality, audio)) {
+        return {};
+    }
+    return std::move(sink.data());
+}
+
+static int write_sd_images_to_file(const std::string& output_format,
+                                   const char* filename,
+                                   sd_image_t* images,
+                                   int num_images,
+                                   int fps,
+                                   int quality,
+                                   const sd_audio_t* audio) {
+    bool ok = false;
+    {
+        FileMediaSink sink(filename);
+        if (!sink.is_open()) {
+            perror("Error opening file for writing");
+            return -1;
+        }
+        ok = write_sd_images_to_sink(output_format, &sink, images, num_images, fps, quality, audio);
+    }
+    if (!ok) {
+        std::error_code ec;
+        fs::remove(filename, ec);
         return -1;
     }
     return 0;
 }
 
+std::vector<uint8_t> create_mjpg_avi_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
+    return write_sd_images_to_vector("avi", images, num_images, fps, quality, audio);
+}
+
+int create_mjpg_avi_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
+    return write_sd_images_to_file("avi", filename, images, num_images, fps, quality, audio);
+}
+
+#ifdef SD_USE_WEBP
+std::vector<uint8_t> create_animated_webp_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality) {
+    return write_sd_images_to_vector("webp", images, num_images, fps, quality, nullptr);
+}
+
+int create_animated_webp_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality) {
+    return write_sd_images_to_file("webp", filename, images, num_images, fps, quality, nullptr);
+}
+#endif
+
+#ifdef SD_USE_WEBM
+std::vector<uint8_t> create_webm_from_sd_images_to_vector(sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
+    return write_sd_images_to_vector("webm", images, num_images, fps, quality, audio);
+}
+
+int create_webm_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
+    return write_sd_images_to_file("webm", filename, images, num_images, fps, quality, audio);
+}
+#endif
+
+std::vector<uint8_t> create_video_from_sd_images_to_vector(const std::string& output_format,
+                                                           sd_image_t* images,
+                                                           int num_images,
+                                                           int fps,
+                                                           int quality,
+                                                           const sd_audio_t* audio) {
+    return write_sd_images_to_vector(output_format, images, num_images, fps, quality, audio);
+}
+
+int create_video_from_sd_images(const char* filename, sd_image_t* images, int num_images, int fps, int quality, const sd_audio_t* audio) {
+    std::string path = filename ? filename : "";
+    auto pos         = path.find_last_of('.');
+    std::string ext  = pos == std::string::npos ? "" : path.substr(pos);
+    return write_sd_images_to_file(ext, filename, images, num_images, fps, quality, audio);
+}
+
 bool write_wav_to_file(const std::string& path,
                        const float* interleaved_samples,
                        uint64_t sample_count,
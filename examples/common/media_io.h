@@ -1,7 +1,10 @@
 #ifndef __MEDIA_IO_H__
 #define __MEDIA_IO_H__
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +27,23 @@ std::vector<uint8_t> encode_image_to_vector(EncodedImageFormat format,
                                             const std::string& parameters = "",
                                             int quality                   = 90);
 
+// Deflate effort for PNG output (0 = stored .. 8) from an output_compression
+// / quality value in 0..100; 90 and above give stb_image_write's default
+// level 8.
+int png_compression_level_from_quality(int quality);
+
+// PNG encoder behind encode_image_to_vector(): rows are filtered and deflated
+// in independent strips on up to n_threads threads (<= 0: one per hardware
+// thread). A non-empty parameters string goes into a "parameters" tEXt chunk.
+bool encode_png_to_vector(const uint8_t* image,
+                          int width,
+                          int height,
+                          int channels,
+                          const std::string& parameters,
+                          int level,
+                          int n_threads,
+                          std::vector<uint8_t>& out);
+
 bool write_image_to_file(const std::string& path,
                          const uint8_t* image,
                          int width,
@@ -45,13 +65,215 @@ bool load_sd_image_from_file(sd_image_t* image,
                              int expected_height  = 0,
                              int expected_channel = 3);
 
+// Like load_image_from_file(); the crop/resize to expected_width x
+// expected_height runs on up to n_threads threads (<= 0: one per hardware
+// thread).
 uint8_t* load_image_from_memory(const char* image_bytes,
                                 int len,
                                 int& width,
                                 int& height,
                                 int expected_width   = 0,
                                 int expected_height  = 0,
-                                int expected_channel = 3);
+                                int expected_channel = 3,
+                                int n_threads        = 1);
+
+// One encoded image for load_images_from_memory(); pixels, width and height
+// are outputs (pixels is malloc'ed, nullptr if the image failed to load).
+struct ImageLoadJob {
+    const char* bytes    = nullptr;
+    int len              = 0;
+    int expected_width   = 0;
+    int expected_height  = 0;
+    int expected_channel = 3;
+    uint8_t* pixels      = nullptr;
+    int width            = 0;
+    int height           = 0;
+};
+
+// load_image_from_memory() for several images: they decode concurrently on up
+// to n_threads threads (<= 0: one per hardware thread), and threads left over
+// when there are fewer images than threads help with the resizes.
+void load_images_from_memory(std::vector<ImageLoadJob>& jobs, int n_threads);
+
+// Byte destination of a VideoWriter. Seeking is only used to patch container
+// headers on finalize(); non-seekable sinks (pipes, chunked HTTP responses)
+// get headers with the sizes left open instead.
+class MediaSink {
+public:
+    virtual ~MediaSink() = default;
+
+    virtual bool write(const void* data, size_t size) = 0;
+    virtual uint64_t position() const                 = 0;
+    virtual bool seekable() const {
+        return false;
+    }
+    virtual bool seek(uint64_t position) {
+        (void)position;
+        return false;
+    }
+};
+
+class VectorMediaSink : public MediaSink {
+public:
+    bool write(const void* data, size_t size) override;
+    uint64_t position() const override {
+        return position_;
+    }
+    bool seekable() const override {
+        return true;
+    }
+    bool seek(uint64_t position) override;
+
+    std::vector<uint8_t>& data() {
+        return data_;
+    }
+
+private:
+    std::vector<uint8_t> data_;
+    size_t position_ = 0;
+};
+
+// Writes to an already open file descriptor, which stays owned by the caller.
+class FdMediaSink : public MediaSink {
+public:
+    explicit FdMediaSink(int fd);
+
+    bool write(const void* data, size_t size) override;
+    uint64_t position() const override {
+        return position_;
+    }
+    bool seekable() const override {
+        return seekable_;
+    }
+    bool seek(uint64_t position) override;
+
+protected:
+    int fd_            = -1;
+    uint64_t position_ = 0;
+    bool seekable_     = false;
+};
+
+class FileMediaSink : public FdMediaSink {
+public:
+    explicit FileMediaSink(const std::string& path);
+    ~FileMediaSink() override;
+
+    bool is_open() const {
+        return fd_ >= 0;
+    }
+};
+
+// Hands every write straight to a callback, e.g. httplib::DataSink::write of
+// a chunked response. Not seekable.
+class CallbackMediaSink : public MediaSink {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t size)> write_cb_t;
+
+    explicit CallbackMediaSink(write_cb_t write_cb)
+        : write_cb_(std::move(write_cb)) {
+    }
+
+    bool write(const void* data, size_t size) override;
+    uint64_t position() const override {
+        return position_;
+    }
+
+private:
+    write_cb_t write_cb_;
+    uint64_t position_ = 0;
+};
+
+struct VideoWriterOptions {
+    int width   = 0;
+    int height  = 0;
+    int fps     = 16;
+    int quality = 90;
+    // Audio track layout; 0 channels means no audio track.
+    uint32_t audio_sample_rate = 0;
+    uint32_t audio_channels    = 0;
+    // Frame count put in the headers of non-seekable sinks; 0 if unknown.
+    // Their AVI RIFF and movi sizes stay 0xFFFFFFFF.
+    int expected_frames = 0;
+    // Threads for add_frames(); <= 0 uses one per hardware thread.
+    int n_threads = 0;
+};
+
+// Incremental video container writer: frames are encoded and written as they
+// are added, so neither the raw frames nor the whole file have to be kept.
+// Audio should be added before (or along with) the frames it plays under.
+class VideoWriter {
+public:
+    virtual ~VideoWriter() = default;
+
+    virtual bool add_frame(const sd_image_t& frame) = 0;
+    // Adds consecutive frames; AVI and WebM encode them in parallel and
+    // write them in order.
+    virtual bool add_frames(const sd_image_t* frames, int count) {
+        for (int i = 0; i < count; ++i) {
+            if (!add_frame(frames[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Interleaved samples in [-1, 1]; sample_count counts per-channel samples.
+    virtual bool add_audio(const float* samples, uint64_t sample_count) = 0;
+    virtual bool finalize()                                             = 0;
+
+    int frame_count() const {
+        return frame_count_;
+    }
+
+protected:
+    int frame_count_ = 0;
+};
+
+// output_format is "avi", "webm" or "webp" (a leading '.' is accepted); like
+// create_video_from_sd_images_to_vector(), unknown formats fall back to MJPG
+// AVI. The sink must outlive the writer. Returns nullptr on failure.
+std::unique_ptr<VideoWriter> open_video_writer(const std::string& output_format,
+                                               MediaSink* sink,
+                                               const VideoWriterOptions& options);
+
+// Encodes generate_video() output as it is decoded: attach() points the
+// request's frame_sink / audio_sink at a VideoWriter. The writer opens on the
+// first frames, whose size sets the video size, with an audio track if the
+// audio was handed over before them and the format can carry it. options
+// supplies fps, quality, expected_frames and n_threads.
+class StreamingVideoOutput {
+public:
+    StreamingVideoOutput(const std::string& output_format,
+                         MediaSink* sink,
+                         const VideoWriterOptions& options);
+
+    void attach(sd_vid_gen_params_t* params);
+    // False if no frame arrived or any write failed.
+    bool finalize();
+
+    int frame_count() const {
+        return writer_ ? writer_->frame_count() : 0;
+    }
+    // Audio that is not in the container (animated WebP), e.g. for a .wav
+    // sidecar; nullptr if there is none.
+    const sd_audio_t* unmuxed_audio() const {
+        return audio_.data != nullptr && !audio_muxed_ ? &audio_ : nullptr;
+    }
+
+private:
+    static bool on_frames(const sd_image_t* frames, int first_frame, int frame_count, void* data);
+    static bool on_audio(const sd_audio_t* audio, void* data);
+
+    bool add_frames(const sd_image_t* frames, int frame_count);
+
+    std::string format_;
+    MediaSink* sink_ = nullptr;
+    VideoWriterOptions options_;
+    std::unique_ptr<VideoWriter> writer_;
+    std::vector<float> audio_samples_;
+    sd_audio_t audio_ = {};
+    bool audio_muxed_ = false;
+    bool failed_      = false;
+};
 
 int create_mjpg_avi_from_sd_images(const char* filename,
                                    sd_image_t* images,
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/media_io.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#include "stb_image_write.h"
+
+// Times PNG encoding of generated images with stb_image_write (the old
+// output path) and with encode_png_to_vector() on one and on several
+// threads, and checks that every encoded image decodes back unchanged.
+
+struct BenchParams {
+    std::vector<double> megapixels = {1, 2, 4, 8};
+    int n_threads                  = 0;
+    int level                      = -1;
+    int repeat                     = 3;
+    int channels                   = 3;
+    uint32_t seed                  = 42;
+};
+
+static void print_usage(const char* argv0) {
+    printf("usage: %s [options]\n", argv0);
+    printf("  -m, --megapixels LIST  comma separated image sizes in megapixels (default: 1,2,4,8)\n");
+    printf("  -t, --threads N        encoder threads for the parallel run (default: hardware threads)\n");
+    printf("  -l, --level N          deflate level 0..9 (default: %d, the level for quality 90)\n", png_compression_level_from_quality(90));
+    printf("  -c, --channels N       channels per pixel, 3 or 4 (default: 3)\n");
+    printf("  -r, --repeat N         timed runs per case, the best one is reported (default: 3)\n");
+    printf("  -s, --seed N           image generator seed (default: 42)\n");
+    printf("  -h, --help             show this help\n");
+}
+
+static bool parse_args(int argc, char** argv, BenchParams& params) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next       = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* value = nullptr;
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            exit(0);
+        } else if (arg == "-m" || arg == "--megapixels") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.megapixels.clear();
+            std::string list = value;
+            size_t start     = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos) {
+                    end = list.size();
+                }
+                if (end > start) {
+                    params.megapixels.push_back(atof(list.substr(start, end - start).c_str()));
+                }
+                start = end + 1;
+            }
+        } else if (arg == "-t" || arg == "--threads") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.n_threads = atoi(value);
+        } else if (arg == "-l" || arg == "--level") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.level = std::clamp(atoi(value), 0, 9);
+        } else if (arg == "-c" || arg == "--channels") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.channels = atoi(value) == 4 ? 4 : 3;
+        } else if (arg == "-r" || arg == "--repeat") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.repeat = std::max(1, atoi(value));
+        } else if (arg == "-s" || arg == "--seed") {
+            if ((value = next()) == nullptr) {
+                return false;
+            }
+            params.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Smooth color fields with a little grain, closer to generated images than
+// pure noise (incompressible) or flat gradients (trivially compressible).
+static std::vector<uint8_t> make_image(int width, int height, int channels, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+    std::vector<float> phases(static_cast<size_t>(channels) * 3);
+    for (auto& p : phases) {
+        p = phase(rng);
+    }
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * channels);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const float fx = static_cast<float>(x) / width;
+            const float fy = static_cast<float>(y) / height;
+            for (int c = 0; c < channels; ++c) {
+                const float* p = &phases[static_cast<size_t>(c) * 3];
+                float v        = 0.5f + 0.25f * std::sin(fx * 7.0f + p[0]) + 0.2f * std::sin(fy * 5.0f + p[1]) +
+                          0.05f * std::sin((fx + fy) * 40.0f + p[2]);
+                v += (static_cast<int>(rng() % 9) - 4) / 255.0f;
+                image[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+            }
+        }
+    }
+    return image;
+}
+
+static double best_ms(int repeat, const std::function<bool()>& run) {
+    double best = -1.0;
+    for (int i = 0; i < repeat; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!run()) {
+            return -1.0;
+        }
+        auto t1         = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        best            = best < 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+static bool decodes_to(const std::vector<uint8_t>& png, const std::vector<uint8_t>& image, int width, int height, int channels) {
+    int w            = 0;
+    int h            = 0;
+    uint8_t* decoded = load_image_from_memory(reinterpret_cast<const char*>(png.data()), static_cast<int>(png.size()), w, h, 0, 0, channels);
+    const bool same  = decoded != nullptr && w == width && h == height && memcmp(decoded, image.data(), image.size()) == 0;
+    free(decoded);
+    return same;
+}
+
+int main(int argc, char** argv) {
+    BenchParams params;
+    if (!parse_args(argc, argv, params)) {
+        return 1;
+    }
+    const int level     = params.level >= 0 ? params.level : png_compression_level_from_quality(90);
+    const int n_threads = params.n_threads > 0 ? params.n_threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    printf("level %d, %d channels, %d threads, best of %d\n", level, params.channels, n_threads, params.repeat);
+    printf("%10s %12s | %10s %10s | %10s %10s | %10s %10s %8s\n",
+           "MP", "size", "stb ms", "stb KiB", "1t ms", "1t KiB", "Nt ms", "Nt KiB", "speedup");
+
+    bool all_ok = true;
+    for (double mp : params.megapixels) {
+        const double pixels = mp * 1000000.0;
+        const int width     = std::max(1, static_cast<int>(std::lround(std::sqrt(pixels * 16.0 / 9.0))));
+        const int height    = std::max(1, static_cast<int>(std::lround(pixels / width)));
+        std::vector<uint8_t> image = make_image(width, height, params.channels, params.seed);
+
+        std::vector<uint8_t> stb_png;
+        const double stb_ms = best_ms(params.repeat, [&]() {
+            int len            = 0;
+            unsigned char* png = stbi_write_png_to_mem(image.data(), width * params.channels, width, height, params.channels, &len, nullptr);
+            if (png == nullptr) {
+                return false;
+            }
+            stb_png.assign(png, png + len);
+            STBIW_FREE(png);
+            return true;
+        });
+
+        std::vector<uint8_t> single_png;
+        const double single_ms = best_ms(params.repeat, [&]() {
+            return encode_png_to_vector(image.data(), width, height, params.channels, "", level, 1, single_png);
+        });
+
+        std::vector<uint8_t> multi_png;
+        const double multi_ms = best_ms(params.repeat, [&]() {
+            return encode_png_to_vector(image.data(), width, height, params.channels, "", level, n_threads, multi_png);
+        });
+
+        const bool ok = stb_ms >= 0 && single_ms >= 0 && multi_ms >= 0 &&
+                        decodes_to(single_png, image, width, height, params.channels) &&
+                        decodes_to(multi_png, image, width, height, params.channels);
+        all_ok = all_ok && ok;
+
+        char size_str[32];
+        snprintf(size_str, sizeof(size_str), "%dx%d", width, height);
+        printf("%10.1f %12s | %10.1f %10.1f | %10.1f %10.1f | %10.1f %10.1f %7.2fx%s\n",
+               mp,
+               size_str,
+               stb_ms,
+               stb_png.size() / 1024.0,
+               single_ms,
+               single_png.size() / 1024.0,
+               multi_ms,
+               multi_png.size() / 1024.0,
+               multi_ms > 0 ? stb_ms / multi_ms : 0.0,
+               ok ? "" : "  DECODE MISMATCH");
+    }
+    return all_ok ? 0 : 1;
+}
@@ -237,42 +237,46 @@ bool execute_vid_gen_job(ServerRuntime& runtime,
                          int& output_fps,
                          std::string& error_message) {
     sd_vid_gen_params_t params = job.vid_gen.to_sd_vid_gen_params_t();
+    AsyncJobManager& manager   = *runtime.async_job_manager;
 
-    SDImageVec results;
-    int num_results             = 0;
-    sd_audio_t* generated_audio = nullptr;
-
+    // The container is encoded while the frames decode; each write is
+    // appended to job.media_stream for the streaming media route.
+    CallbackMediaSink sink([&](const uint8_t* data, size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            job.media_stream.insert(job.media_stream.end(), data, data + size);
+        }
+        manager.media_cv.notify_all();
+        return true;
+    });
+    VideoWriterOptions options;
+    options.fps             = job.vid_gen.gen_params.fps;
+    options.quality         = job.vid_gen.output_compression;
+    options.expected_frames = job.vid_gen.gen_params.video_frames;
+    StreamingVideoOutput output(job.vid_gen.output_format, &sink, options);
+    output.attach(&params);
+
+    bool generated = false;
     {
         std::lock_guard<std::mutex> lock(*runtime.sd_ctx_mutex);
-        sd_image_t* raw_results = nullptr;
-        if (!generate_video(runtime.sd_ctx, &params, &raw_results, &num_results, &generated_audio)) {
-            raw_results = nullptr;
-        }
-        results.adopt(raw_results, num_results);
+        generated = generate_video(runtime.sd_ctx, &params, nullptr, nullptr, nullptr);
     }
 
-    num_results = results.count();
-    if (num_results <= 0) {
-        free_sd_audio(generated_audio);
+    if (!generated && output.frame_count() <= 0) {
         error_message = "generate_video returned no results";
         return false;
     }
-
-    std::vector<uint8_t> video_bytes = create_video_from_sd_images_to_vector(job.vid_gen.output_format,
-                                                                             results.data(),
-                                                                             num_results,
-                                                                             job.vid_gen.gen_params.fps,
-                                                                             job.vid_gen.output_compression,
-                                                                             generated_audio);
-    free_sd_audio(generated_audio);
-    if (video_bytes.empty()) {
+    if (!generated || !output.finalize()) {
         error_message = "failed to encode generated video container";
         return false;
     }
 
-    output_media_b64       = base64_encode(video_bytes);
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        output_media_b64 = base64_encode(job.media_stream);
+    }
     output_media_mime_type = video_mime_type(job.vid_gen.output_format);
-    output_frame_count     = num_results;
+    output_frame_count     = output.frame_count();
     output_fps             = job.vid_gen.gen_params.fps;
     return true;
 }
@@ -354,11 +358,13 @@ void async_job_worker(ServerRuntime& runtime) {
                 job->result_images_b64.clear();
                 job->result_media_b64.clear();
                 job->result_media_mime_type.clear();
+                job->media_stream.clear();
                 job->result_frame_count = 0;
                 job->result_fps         = 0;
             }
 
             purge_expired_jobs(manager);
         }
+        manager.media_cv.notify_all();
     }
 }
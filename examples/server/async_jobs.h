@@ -40,6 +40,9 @@ struct AsyncGenerationJob {
     std::vector<std::string> result_images_b64;
     std::string result_media_b64;
     std::string result_media_mime_type;
+    // Video container bytes written so far. GET /sdcpp/v1/jobs/{id}/media
+    // streams them while the job is generating; guarded by the manager mutex.
+    std::vector<uint8_t> media_stream;
     int result_frame_count = 0;
     int result_fps         = 0;
     std::string error_code;
@@ -49,6 +52,8 @@ struct AsyncGenerationJob {
 struct AsyncJobManager {
     std::mutex mutex;
     std::condition_variable cv;
+    // Signalled when a job's media_stream grows or the job finishes.
+    std::condition_variable media_cv;
     std::unordered_map<std::string, std::shared_ptr<AsyncGenerationJob>> jobs;
     std::unordered_map<std::string, int64_t> expired_jobs;
     std::deque<std::string> queue;
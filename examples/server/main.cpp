@@ -113,6 +113,8 @@ int main(int argc, const char** argv) {
         &async_job_manager,
     };
 
+    preload_loras(runtime);
+
     std::thread async_worker(async_job_worker, std::ref(runtime));
 
     httplib::Server svr;
@@ -157,19 +157,22 @@ static bool build_openai_edit_request(const httplib::Request& req,
     request.gen_params.height      = height;
     request.gen_params.batch_count = n;
 
-    for (auto& bytes : images_bytes) {
-        int img_w           = 0;
-        int img_h           = 0;
-        uint8_t* raw_pixels = load_image_from_memory(
-            reinterpret_cast<const char*>(bytes.data()),
-            static_cast<int>(bytes.size()),
-            img_w, img_h,
-            width, height, 3);
-        if (raw_pixels == nullptr) {
+    std::vector<ImageLoadJob> image_jobs(images_bytes.size());
+    for (size_t i = 0; i < images_bytes.size(); ++i) {
+        image_jobs[i].bytes            = reinterpret_cast<const char*>(images_bytes[i].data());
+        image_jobs[i].len              = static_cast<int>(images_bytes[i].size());
+        image_jobs[i].expected_width   = width;
+        image_jobs[i].expected_height  = height;
+        image_jobs[i].expected_channel = 3;
+    }
+    load_images_from_memory(image_jobs, runtime.svr_params->image_decode_threads);
+
+    for (const ImageLoadJob& job : image_jobs) {
+        if (job.pixels == nullptr) {
             continue;
         }
 
-        SDImageOwner image_owner({(uint32_t)img_w, (uint32_t)img_h, 3, raw_pixels});
+        SDImageOwner image_owner({(uint32_t)job.width, (uint32_t)job.height, 3, job.pixels});
         request.gen_params.set_width_and_height_if_unset(image_owner.get().width, image_owner.get().height);
         request.gen_params.ref_images.push_back(std::move(image_owner));
     }
@@ -192,7 +195,8 @@ static bool build_openai_edit_request(const httplib::Request& req,
             reinterpret_cast<const char*>(mask_bytes.data()),
             static_cast<int>(mask_bytes.size()),
             mask_w, mask_h,
-            expected_width, expected_height, 1);
+            expected_width, expected_height, 1,
+            runtime.svr_params->image_decode_threads);
         request.gen_params.mask_image.reset({(uint32_t)mask_w, (uint32_t)mask_h, 1, mask_raw});
         const sd_image_t& mask_image = request.gen_params.mask_image.get();
         request.gen_params.set_width_and_height_if_unset(mask_image.width, mask_image.height);
@@ -197,26 +197,34 @@ static bool build_sdapi_img_gen_request(const json& j,
         const int expected_width  = request.gen_params.width_and_height_are_set() ? request.gen_params.width : 0;
         const int expected_height = request.gen_params.width_and_height_are_set() ? request.gen_params.height : 0;
 
-        if (j.contains("init_images") && j["init_images"].is_array() && !j["init_images"].empty()) {
-            if (decode_base64_image(j["init_images"][0].get<std::string>(),
-                                    3,
-                                    expected_width,
-                                    expected_height,
-                                    request.gen_params.init_image)) {
-                const sd_image_t& image = request.gen_params.init_image.get();
+        // The init image and the mask decode together; both are only sized
+        // by the request, not by each other.
+        const bool has_init_image = j.contains("init_images") && j["init_images"].is_array() && !j["init_images"].empty();
+        const bool has_mask       = j.contains("mask") && j["mask"].is_string();
+        std::vector<Base64ImageJob> image_jobs;
+        if (has_init_image) {
+            image_jobs.push_back({&j.at("init_images").at(0).get_ref<const std::string&>(),
+                                  3,
+                                  expected_width,
+                                  expected_height,
+                                  &request.gen_params.init_image});
+        }
+        if (has_mask) {
+            image_jobs.push_back({&j.at("mask").get_ref<const std::string&>(),
+                                  1,
+                                  expected_width,
+                                  expected_height,
+                                  &request.gen_params.mask_image});
+        }
+        decode_base64_images(image_jobs, runtime.svr_params->image_decode_threads);
+        for (const Base64ImageJob& job : image_jobs) {
+            if (job.decoded) {
+                const sd_image_t& image = job.out_image->get();
                 request.gen_params.set_width_and_height_if_unset(image.width, image.height);
             }
         }
 
-        if (j.contains("mask") && j["mask"].is_string()) {
-            if (decode_base64_image(j["mask"].get<std::string>(),
-                                    1,
-                                    expected_width,
-                                    expected_height,
-                                    request.gen_params.mask_image)) {
-                const sd_image_t& image = request.gen_params.mask_image.get();
-                request.gen_params.set_width_and_height_if_unset(image.width, image.height);
-            }
+        if (has_mask) {
             sd_image_t& mask_image      = request.gen_params.mask_image.get();
             bool inpainting_mask_invert = j.value("inpainting_mask_invert", 0) != 0;
             if (inpainting_mask_invert && mask_image.data != nullptr) {
@@ -237,20 +245,36 @@ static bool build_sdapi_img_gen_request(const json& j,
     }
 
     if (j.contains("extra_images") && j["extra_images"].is_array()) {
+        std::vector<const std::string*> extra_images_b64;
         for (const auto& extra_image : j["extra_images"]) {
-            if (!extra_image.is_string()) {
-                continue;
+            if (extra_image.is_string()) {
+                extra_images_b64.push_back(&extra_image.get_ref<const std::string&>());
             }
-            SDImageOwner image_owner;
-            if (decode_base64_image(extra_image.get<std::string>(),
-                                    3,
-                                    request.gen_params.width_and_height_are_set() ? request.gen_params.width : 0,
-                                    request.gen_params.width_and_height_are_set() ? request.gen_params.height : 0,
-                                    image_owner)) {
-                const sd_image_t& image = image_owner.get();
+        }
+
+        // Without a size yet, the first decoded image sets it for the rest,
+        // so those wait for it; everything else decodes in one batch.
+        std::vector<SDImageOwner> extra_images(extra_images_b64.size());
+        size_t next = 0;
+        while (next < extra_images_b64.size()) {
+            const bool sized  = request.gen_params.width_and_height_are_set();
+            const size_t end  = sized ? extra_images_b64.size() : next + 1;
+            const int extra_w = sized ? request.gen_params.width : 0;
+            const int extra_h = sized ? request.gen_params.height : 0;
+            std::vector<Base64ImageJob> image_jobs;
+            for (size_t i = next; i < end; ++i) {
+                image_jobs.push_back({extra_images_b64[i], 3, extra_w, extra_h, &extra_images[i]});
+            }
+            decode_base64_images(image_jobs, runtime.svr_params->image_decode_threads);
+            for (const Base64ImageJob& job : image_jobs) {
+                if (!job.decoded) {
+                    continue;
+                }
+                const sd_image_t& image = job.out_image->get();
                 request.gen_params.set_width_and_height_if_unset(image.width, image.height);
-                request.gen_params.ref_images.push_back(std::move(image_owner));
+                request.gen_params.ref_images.push_back(std::move(*job.out_image));
             }
+            next = end;
         }
     }
 
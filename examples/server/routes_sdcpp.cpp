@@ -1,6 +1,7 @@
 #include "routes.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 
@@ -356,9 +357,12 @@ static bool parse_img_gen_request(const json& body,
     request.gen_params = *runtime.default_gen_params;
 
     refresh_lora_cache(runtime);
-    if (!request.gen_params.from_json_str(body.dump(), [&](const std::string& path) {
-            return get_lora_full_path(runtime, path);
-        })) {
+    if (!request.gen_params.from_json_str(
+            body.dump(),
+            [&](const std::string& path) {
+                return get_lora_full_path(runtime, path);
+            },
+            runtime.svr_params->image_decode_threads)) {
         error_message = "invalid generation parameters";
         return false;
     }
@@ -383,9 +387,12 @@ static bool parse_vid_gen_request(const json& body,
     request.gen_params = *runtime.default_gen_params;
 
     refresh_lora_cache(runtime);
-    if (!request.gen_params.from_json_str(body.dump(), [&](const std::string& path) {
-            return get_lora_full_path(runtime, path);
-        })) {
+    if (!request.gen_params.from_json_str(
+            body.dump(),
+            [&](const std::string& path) {
+                return get_lora_full_path(runtime, path);
+            },
+            runtime.svr_params->image_decode_threads)) {
         error_message = "invalid generation parameters";
         return false;
     }
@@ -557,6 +564,77 @@ void register_sdcpp_api_endpoints(httplib::Server& svr, ServerRuntime& rt) {
         res.set_content(make_async_job_json(manager, *it->second).dump(), "application/json");
     });
 
+    // Streams a vid_gen job's container as it is encoded: chunks go out as
+    // frames are decoded, and the response ends when the job completes (or is
+    // cut off if it fails). Also serves finished jobs.
+    svr.Get(R"(/sdcpp/v1/jobs/([A-Za-z0-9_\-]+)/media)", [runtime](const httplib::Request& req, httplib::Response& res) {
+        AsyncJobManager& manager = *runtime->async_job_manager;
+        std::shared_ptr<AsyncGenerationJob> job;
+        {
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            purge_expired_jobs(manager);
+
+            std::string job_id = req.matches[1];
+            auto it            = manager.jobs.find(job_id);
+            if (it == manager.jobs.end()) {
+                if (manager.expired_jobs.find(job_id) != manager.expired_jobs.end()) {
+                    res.status = 410;
+                    res.set_content(R"({"error":"job expired"})", "application/json");
+                } else {
+                    res.status = 404;
+                    res.set_content(R"({"error":"job not found"})", "application/json");
+                }
+                return;
+            }
+            job = it->second;
+            if (job->kind != AsyncJobKind::VidGen) {
+                res.status = 400;
+                res.set_content(R"({"error":"job has no video stream"})", "application/json");
+                return;
+            }
+            if (job->status == AsyncJobStatus::Failed || job->status == AsyncJobStatus::Cancelled) {
+                res.status = 409;
+                res.set_content(make_async_job_json(manager, *job).dump(), "application/json");
+                return;
+            }
+        }
+
+        res.status = 200;
+        res.set_chunked_content_provider(
+            video_mime_type(job->vid_gen.output_format),
+            [runtime, job](size_t offset, httplib::DataSink& sink) {
+                AsyncJobManager& manager = *runtime->async_job_manager;
+                std::vector<uint8_t> chunk;
+                bool finished = false;
+                {
+                    std::unique_lock<std::mutex> lock(manager.mutex);
+                    manager.media_cv.wait_for(lock, std::chrono::seconds(1), [&]() {
+                        return manager.stop ||
+                               job->media_stream.size() > offset ||
+                               job->status == AsyncJobStatus::Completed ||
+                               job->status == AsyncJobStatus::Failed ||
+                               job->status == AsyncJobStatus::Cancelled;
+                    });
+                    if (manager.stop ||
+                        job->status == AsyncJobStatus::Failed ||
+                        job->status == AsyncJobStatus::Cancelled) {
+                        return false;
+                    }
+                    if (job->media_stream.size() > offset) {
+                        chunk.assign(job->media_stream.begin() + offset, job->media_stream.end());
+                    }
+                    finished = job->status == AsyncJobStatus::Completed;
+                }
+                if (!chunk.empty() && !sink.write(reinterpret_cast<const char*>(chunk.data()), chunk.size())) {
+                    return false;
+                }
+                if (finished) {
+                    sink.done();
+                }
+                return true;
+            });
+    });
+
     svr.Post(R"(/sdcpp/v1/jobs/([A-Za-z0-9_\-]+)/cancel)", [runtime](const httplib::Request& req, httplib::Response& res) {
         AsyncJobManager& manager = *runtime->async_job_manager;
         std::lock_guard<std::mutex> lock(manager.mutex);
@@ -192,10 +192,21 @@ ArgOptions SDSvrParams::get_options() {
     options.string_options = {
         {"-l", "--listen-ip", "server listen ip (default: 127.0.0.1)", 0, &listen_ip},
         {"", "--serve-html-path", "path to HTML file to serve at root (optional)", 0, &serve_html_path},
+        {"",
+         "--preload-loras",
+         "comma-separated LoRA paths (relative to --lora-model-dir) to parse into the LoRA cache at startup "
+         "(at_runtime LoRA apply mode with --lora-cache-size only)",
+         0,
+         &preload_loras},
     };
 
     options.int_options = {
         {"", "--listen-port", "server listen port (default: 1234)", &listen_port},
+        {"",
+         "--image-decode-threads",
+         "threads for decoding and resizing uploaded images, outside the generation lock "
+         "(default: 0, one per hardware thread)",
+         &image_decode_threads},
     };
 
     options.bool_options = {
@@ -246,6 +257,8 @@ std::string SDSvrParams::to_string() const {
         << "  listen_ip: " << listen_ip << ",\n"
         << "  listen_port: \"" << listen_port << "\",\n"
         << "  serve_html_path: \"" << serve_html_path << "\",\n"
+        << "  preload_loras: \"" << preload_loras << "\",\n"
+        << "  image_decode_threads: " << image_decode_threads << ",\n"
         << "}";
     return oss.str();
 }
@@ -292,6 +305,38 @@ std::string get_lora_full_path(ServerRuntime& rt, const std::string& path) {
     return it != rt.lora_cache->end() ? it->fullpath : "";
 }
 
+void preload_loras(ServerRuntime& rt) {
+    if (rt.svr_params->preload_loras.empty()) {
+        return;
+    }
+    refresh_lora_cache(rt);
+
+    std::vector<std::string> fullpaths;
+    std::stringstream ss(rt.svr_params->preload_loras);
+    std::string path;
+    while (std::getline(ss, path, ',')) {
+        if (path.empty()) {
+            continue;
+        }
+        std::string fullpath = get_lora_full_path(rt, path);
+        if (fullpath.empty()) {
+            LOG_WARN("preload lora not found in lora model dir: %s", path.c_str());
+            continue;
+        }
+        fullpaths.push_back(std::move(fullpath));
+    }
+
+    std::vector<sd_lora_t> loras;
+    loras.reserve(fullpaths.size());
+    for (const auto& fullpath : fullpaths) {
+        loras.push_back({false, 1.0f, fullpath.c_str()});
+    }
+    std::lock_guard<std::mutex> lock(*rt.sd_ctx_mutex);
+    if (!sd_ctx_preload_loras(rt.sd_ctx, loras.data(), (uint32_t)loras.size())) {
+        LOG_WARN("preloading loras failed");
+    }
+}
+
 void refresh_upscaler_cache(ServerRuntime& rt) {
     std::vector<UpscalerEntry> new_cache;
 
@@ -21,9 +21,11 @@ struct SDSvrParams {
     std::string listen_ip = "127.0.0.1";
     int listen_port       = 1234;
     std::string serve_html_path;
-    bool normal_exit = false;
-    bool verbose     = false;
-    bool color       = false;
+    std::string preload_loras;
+    int image_decode_threads = 0;
+    bool normal_exit         = false;
+    bool verbose             = false;
+    bool color               = false;
 
     ArgOptions get_options();
     bool validate();
@@ -96,5 +98,6 @@ bool runtime_supports_generation_mode(const ServerRuntime& runtime, SDMode mode)
 std::string unsupported_generation_mode_error(SDMode mode);
 void refresh_lora_cache(ServerRuntime& rt);
 std::string get_lora_full_path(ServerRuntime& rt, const std::string& path);
+void preload_loras(ServerRuntime& rt);
 void refresh_upscaler_cache(ServerRuntime& rt);
 int64_t unix_timestamp_now();
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tokenizers/clip_tokenizer.h"
+#include "tokenizers/gemma_tokenizer.h"
+#include "tokenizers/gpt_oss_tokenizer.h"
+#include "tokenizers/mistral_tokenizer.h"
+#include "tokenizers/qwen2_tokenizer.h"
+#include "tokenizers/t5_unigram_tokenizer.h"
+
+// Measures construction time and encode throughput of the built-in
+// tokenizers, and records / checks the produced ids so tokenizer changes
+// can be verified to be output-preserving.
+
+struct TokenizerEntry {
+    const char* name;
+    std::function<std::unique_ptr<Tokenizer>()> create;
+};
+
+static const std::vector<TokenizerEntry>& tokenizer_entries() {
+    static const std::vector<TokenizerEntry> entries = {
+        {"clip", []() { return std::unique_ptr<Tokenizer>(new CLIPTokenizer()); }},
+        {"t5", []() { return std::unique_ptr<Tokenizer>(new T5UniGramTokenizer(false)); }},
+        {"umt5", []() { return std::unique_ptr<Tokenizer>(new T5UniGramTokenizer(true)); }},
+        {"qwen2", []() { return std::unique_ptr<Tokenizer>(new Qwen2Tokenizer()); }},
+        {"mistral", []() { return std::unique_ptr<Tokenizer>(new MistralTokenizer()); }},
+        {"gemma", []() { return std::unique_ptr<Tokenizer>(new GemmaTokenizer()); }},
+        {"gemma2", []() { return std::unique_ptr<Tokenizer>(new Gemma2Tokenizer()); }},
+        {"gpt-oss", []() { return std::unique_ptr<Tokenizer>(new GPTOSSTokenizer()); }},
+    };
+    return entries;
+}
+
+static const char* builtin_prompts[] = {
+    "a photo of an astronaut riding a horse on mars",
+    "masterpiece, best quality, 1girl, solo, long hair, looking at viewer, smile, (detailed eyes:1.2), [blurry]",
+    "A cinematic shot of a red fox in a snowy forest at golden hour, shallow depth of field, 35mm film grain",
+    "It's what they've done; I'll say it ISN'T what we'd planned.",
+    "<lora:detail_tweaker:0.8> ultra detailed, 8k, HDR, trending on artstation",
+    "<|im_start|>system\nDescribe the image by detailing the color, shape, size, texture, quantity, text, spatial relationships of the objects and background:<|im_end|>\n<|im_start|>user\n",
+    "Ein Foto von einem Hund, der über die Straße läuft. Café au lait, crème brûlée, naïve façade.",
+    "東京の夜景、ネオンの光、雨に濡れた路面、映画のようなシーン",
+    "Красивый закат над морем, высокое качество",
+    "emoji 😀🚀🌈 test ... ??? !!! ///\\\\ ,,, 12,345.67 e=mc^2 0x1F600",
+    "   leading and trailing whitespace\t\twith tabs\n\nand newlines   ",
+    "def main():\n    print(\"hello, world\")\n    return 0\n",
+};
+
+static std::vector<std::string> fuzz_prompts(int count, uint32_t seed) {
+    static const char* pieces[] = {
+        "a", "the", "photo", "of", "cat", "Dog", "HORSE", "riding", "astronaut", "detailed",
+        "it's", "they'll", "WE'D", "don't", "'re", "'", "''", "\"", "quoted\"text\"",
+        "0", "7", "42", "1024", "3.14", "1,000", "2x", "v1.5",
+        ",", ".", ";", ":", "!", "?", "(", ")", "[", "]", "{", "}", "<", ">", "/", "\\", "-", "_", "+", "=", "*",
+        " ", "  ", "\t", "\n", "\r\n", "\n\n", " \n ",
+        "é", "ü", "ß", "ñ", "ø", "naïve", "日本", "語", "한국어", "中文", "Ελληνικά", "русский", "עברית", "العربية",
+        "😀", "🚀", "👍🏽", "❤️", "\xE2\x96\x81",
+        "<|endoftext|>", "<|im_start|>", "<|im_end|>", "<|startoftext|>", "</s>", "<pad>", "<SPECIAL_20>",
+    };
+    const int n_pieces = static_cast<int>(sizeof(pieces) / sizeof(pieces[0]));
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> length_dist(1, 48);
+    std::uniform_int_distribution<int> piece_dist(0, n_pieces - 1);
+    std::uniform_int_distribution<int> space_dist(0, 3);
+
+    std::vector<std::string> prompts;
+    prompts.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; i++) {
+        std::string prompt;
+        int length = length_dist(rng);
+        for (int j = 0; j < length; j++) {
+            if (j > 0 && space_dist(rng) != 0) {
+                prompt += ' ';
+            }
+            prompt += pieces[piece_dist(rng)];
+        }
+        prompts.push_back(prompt);
+    }
+    return prompts;
+}
+
+static bool read_corpus(const std::string& path, std::vector<std::string>* prompts) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        fprintf(stderr, "failed to open corpus '%s'\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            prompts->push_back(line);
+        }
+    }
+    return true;
+}
+
+static std::string ids_to_string(const std::vector<int>& ids) {
+    std::string result;
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i > 0) {
+            result += ' ';
+        }
+        result += std::to_string(ids[i]);
+    }
+    return result;
+}
+
+// Reference file: one "<tokenizer>\t<prompt index>\t<ids>" line per prompt.
+static bool read_reference(const std::string& path, std::map<std::string, std::vector<std::string>>* reference) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        fprintf(stderr, "failed to open reference '%s'\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t tab0 = line.find('\t');
+        size_t tab1 = tab0 == std::string::npos ? std::string::npos : line.find('\t', tab0 + 1);
+        if (tab1 == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, tab0);
+        size_t index     = static_cast<size_t>(std::strtoull(line.c_str() + tab0 + 1, nullptr, 10));
+        auto& ids        = (*reference)[name];
+        if (ids.size() <= index) {
+            ids.resize(index + 1);
+        }
+        ids[index] = line.substr(tab1 + 1);
+    }
+    return true;
+}
+
+static void print_usage(const char* argv0) {
+    printf("usage: %s [options]\n", argv0);
+    printf("\n");
+    printf("options:\n");
+    printf("  -h, --help               show this help message and exit\n");
+    printf("  --tokenizers <list>      comma separated subset of: ");
+    for (const auto& entry : tokenizer_entries()) {
+        printf("%s ", entry.name);
+    }
+    printf("(default: all)\n");
+    printf("  --corpus <path>          prompts file, one prompt per line (default: built-in prompts)\n");
+    printf("  --fuzz <n>               add n generated prompts mixing words, punctuation, whitespace,\n");
+    printf("                           non-ASCII text and special tokens (default: 256)\n");
+    printf("  --seed <n>               seed of the generated prompts (default: 42)\n");
+    printf("  --iters <n>              encode passes over the corpus for timing (default: 5)\n");
+    printf("  --save <path>            write the produced ids as a reference file\n");
+    printf("  --check <path>           compare the produced ids against a reference file;\n");
+    printf("                           exits with status 1 on any difference or missing tokenizer\n");
+}
+
+int main(int argc, const char* argv[]) {
+    std::string tokenizer_list;
+    std::string corpus_path;
+    std::string save_path;
+    std::string check_path;
+    int fuzz_count = 256;
+    uint32_t seed  = 42;
+    int iters      = 5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next_value = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", name);
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--tokenizers") {
+            tokenizer_list = next_value("--tokenizers");
+        } else if (arg == "--corpus") {
+            corpus_path = next_value("--corpus");
+        } else if (arg == "--fuzz") {
+            fuzz_count = std::atoi(next_value("--fuzz"));
+        } else if (arg == "--seed") {
+            seed = static_cast<uint32_t>(std::strtoul(next_value("--seed"), nullptr, 10));
+        } else if (arg == "--iters") {
+            iters = std::atoi(next_value("--iters"));
+        } else if (arg == "--save") {
+            save_path = next_value("--save");
+        } else if (arg == "--check") {
+            check_path = next_value("--check");
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    iters = std::max(1, iters);
+
+    std::vector<std::string> prompts;
+    if (!corpus_path.empty()) {
+        if (!read_corpus(corpus_path, &prompts)) {
+            return 1;
+        }
+    } else {
+        prompts.assign(std::begin(builtin_prompts), std::end(builtin_prompts));
+    }
+    if (fuzz_count > 0) {
+        auto fuzzed = fuzz_prompts(fuzz_count, seed);
+        prompts.insert(prompts.end(), fuzzed.begin(), fuzzed.end());
+    }
+    size_t corpus_bytes = 0;
+    for (const auto& prompt : prompts) {
+        corpus_bytes += prompt.size();
+    }
+
+    std::map<std::string, std::vector<std::string>> reference;
+    if (!check_path.empty() && !read_reference(check_path, &reference)) {
+        return 1;
+    }
+    std::ofstream save_file;
+    if (!save_path.empty()) {
+        save_file.open(save_path);
+        if (!save_file.is_open()) {
+            fprintf(stderr, "failed to open '%s' for writing\n", save_path.c_str());
+            return 1;
+        }
+    }
+
+    printf("corpus: %zu prompts, %zu bytes\n", prompts.size(), corpus_bytes);
+    printf("%-10s %12s %12s %14s %14s %12s\n", "tokenizer", "construct ms", "tokens", "cold tokens/s", "warm tokens/s", "warm MB/s");
+
+    using clock     = std::chrono::steady_clock;
+    size_t mismatch = 0;
+    for (const auto& entry : tokenizer_entries()) {
+        if (!tokenizer_list.empty() && ("," + tokenizer_list + ",").find(std::string(",") + entry.name + ",") == std::string::npos) {
+            continue;
+        }
+
+        auto t0                              = clock::now();
+        std::unique_ptr<Tokenizer> tokenizer = entry.create();
+        auto t1                              = clock::now();
+
+        // The first pass runs on the freshly constructed tokenizer, so it
+        // includes filling per-word caches; it also produces the ids that
+        // are saved / checked. The following passes are timed on their own
+        // with warm caches.
+        std::vector<std::vector<int>> ids(prompts.size());
+        size_t cold_tokens = 0;
+        for (size_t i = 0; i < prompts.size(); i++) {
+            ids[i] = tokenizer->tokenize(prompts[i]);
+            cold_tokens += ids[i].size();
+        }
+        auto t2         = clock::now();
+        size_t n_tokens = 0;
+        for (int iter = 0; iter < iters; iter++) {
+            for (const auto& prompt : prompts) {
+                n_tokens += tokenizer->tokenize(prompt).size();
+            }
+        }
+        auto t3 = clock::now();
+
+        double construct_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double cold_s       = std::chrono::duration<double>(t2 - t1).count();
+        double encode_s     = std::chrono::duration<double>(t3 - t2).count();
+        printf("%-10s %12.1f %12zu %14.0f %14.0f %12.2f\n",
+               entry.name,
+               construct_ms,
+               cold_tokens,
+               cold_s > 0 ? cold_tokens / cold_s : 0.0,
+               encode_s > 0 ? n_tokens / encode_s : 0.0,
+               encode_s > 0 ? corpus_bytes * iters / encode_s / 1e6 : 0.0);
+
+        if (save_file.is_open()) {
+            for (size_t i = 0; i < ids.size(); i++) {
+                save_file << entry.name << '\t' << i << '\t' << ids_to_string(ids[i]) << '\n';
+            }
+        }
+        if (!check_path.empty()) {
+            auto it = reference.find(entry.name);
+            if (it == reference.end()) {
+                printf("  %s: no reference ids\n", entry.name);
+                mismatch += ids.size();
+                continue;
+            }
+            size_t tokenizer_mismatch = 0;
+            for (size_t i = 0; i < ids.size(); i++) {
+                std::string got = ids_to_string(ids[i]);
+                if (i < it->second.size() && it->second[i] == got) {
+                    continue;
+                }
+                if (tokenizer_mismatch < 5) {
+                    printf("  %s: prompt %zu differs\n    prompt:   \"%s\"\n    expected: %s\n    got:      %s\n",
+                           entry.name,
+                           i,
+                           prompts[i].c_str(),
+                           i < it->second.size() ? it->second[i].c_str() : "(missing)",
+                           got.c_str());
+                }
+                tokenizer_mismatch++;
+            }
+            if (tokenizer_mismatch > 0) {
+                printf("  %s: %zu / %zu prompts differ\n", entry.name, tokenizer_mismatch, ids.size());
+            }
+            mismatch += tokenizer_mismatch;
+        }
+    }
+
+    if (!check_path.empty()) {
+        printf(mismatch == 0 ? "check passed\n" : "check FAILED\n");
+    }
+    return mismatch == 0 ? 0 : 1;
+}
@@ -159,6 +159,14 @@ enum lora_apply_mode_t {
     LORA_APPLY_MODE_COUNT,
 };
 
+enum sd_numa_mode_t {
+    SD_NUMA_DISABLED,
+    SD_NUMA_DISTRIBUTE,  // spread CPU threads over all nodes, interleave CPU params across nodes
+    SD_NUMA_ISOLATE,     // keep CPU threads and CPU params on the node the process started on
+    SD_NUMA_NUMACTL,     // follow the CPU/memory binding set up by numactl
+    SD_NUMA_MODE_COUNT,
+};
+
 typedef struct {
     bool enabled;
     bool temporal_tiling;
@@ -229,6 +237,10 @@ typedef struct {
     bool auto_fit;
     const char* rpc_servers;
     const char* model_args;
+    enum sd_numa_mode_t numa;
+    int lora_cache_size;  // MiB for recently used LoRAs: merged params (immediately mode) or parsed LoRAs (at_runtime mode); 0 = disabled
+    const char* f8_weight_type;  // load-time type of FP8 weights: f16 (default), q8_0, or per-module assignments e.g. "diffusion=q8_0,te=f16"
+    int encode_cache_size;       // MiB for VAE latents and vision embeddings of recently used input images; 0 = disabled
 } sd_ctx_params_t;
 
 typedef struct {
@@ -385,6 +397,16 @@ typedef struct {
     bool circular_y;
 } sd_img_gen_params_t;
 
+// Receives decoded video frames [first_frame, first_frame + frame_count) in
+// order while generate_video() is still decoding. The frames are owned by the
+// library and freed after the call; return false to stop the generation.
+typedef bool (*sd_frame_sink_t)(const sd_image_t* frames, int first_frame, int frame_count, void* data);
+
+// Receives the generated audio track (LTX-AV) when generate_video() streams
+// to a frame sink. Owned by the library and freed after the call; return
+// false to stop the generation.
+typedef bool (*sd_audio_sink_t)(const sd_audio_t* audio, void* data);
+
 typedef struct {
     const sd_lora_t* loras;
     uint32_t lora_count;
@@ -410,6 +432,14 @@ typedef struct {
     sd_hires_params_t hires;
     bool circular_x;
     bool circular_y;
+    // When set, frames go to frame_sink instead of frames_out (which stays
+    // NULL; num_frames_out counts the delivered frames).
+    sd_frame_sink_t frame_sink;
+    void* frame_sink_data;
+    // Used with frame_sink: the audio track is handed over once, before the
+    // first frame, so a streaming muxer can write it ahead of the video;
+    // audio_out then stays NULL. Gets frame_sink_data.
+    sd_audio_sink_t audio_sink;
 } sd_vid_gen_params_t;
 
 typedef struct sd_ctx_t sd_ctx_t;
@@ -423,6 +453,14 @@ typedef bool (*sd_graph_eval_callback_t)(struct ggml_tensor* t, bool ask, void*
 SD_API void sd_set_log_callback(sd_log_cb_t sd_log_cb, void* data);
 SD_API void sd_set_progress_callback(sd_progress_cb_t cb, void* data);
 SD_API void sd_set_preview_callback(sd_preview_cb_t cb, enum preview_t mode, int interval, bool denoised, bool noisy, void* data);
+// PREVIEW_VAE / PREVIEW_TAE decodes run on a worker thread when the preview
+// decoder has a backend of its own, so sampling does not wait for them. The
+// worker always decodes the newest latent and skips older ones, and calls the
+// preview callback from its thread. n_threads: 0 uses the context's thread
+// count (synchronous if that would compete with CPU sampling), > 0 sets the
+// worker's threads, < 0 keeps previews on the sampling thread. downscale > 1
+// shrinks the latent by that factor before decoding.
+SD_API void sd_set_preview_decode_options(int n_threads, int downscale);
 SD_API void sd_set_backend_eval_callback(sd_graph_eval_callback_t cb, void* data);
 SD_API int32_t sd_get_num_physical_cores();
 SD_API const char* sd_get_system_info();
@@ -433,6 +471,9 @@ SD_API bool sd_ctx_supports_video_generation(const sd_ctx_t* sd_ctx);
 SD_API bool sd_ctx_load_control_net(sd_ctx_t* sd_ctx, const char* path);
 SD_API bool sd_ctx_unload_control_net(sd_ctx_t* sd_ctx);
 SD_API bool sd_ctx_has_control_net(const sd_ctx_t* sd_ctx);
+// Parses LoRAs into the context's LoRA cache (sd_ctx_params_t::lora_cache_size)
+// so later requests naming them skip the file load. at_runtime apply mode only.
+SD_API bool sd_ctx_preload_loras(sd_ctx_t* sd_ctx, const sd_lora_t* loras, uint32_t lora_count);
 
 SD_API const char* sd_type_name(enum sd_type_t type);
 SD_API enum sd_type_t str_to_sd_type(const char* str);
@@ -448,6 +489,8 @@ SD_API const char* sd_preview_name(enum preview_t preview);
 SD_API enum preview_t str_to_preview(const char* str);
 SD_API const char* sd_lora_apply_mode_name(enum lora_apply_mode_t mode);
 SD_API enum lora_apply_mode_t str_to_lora_apply_mode(const char* str);
+SD_API const char* sd_numa_mode_name(enum sd_numa_mode_t mode);
+SD_API enum sd_numa_mode_t str_to_sd_numa_mode(const char* str);
 SD_API const char* sd_hires_upscaler_name(enum sd_hires_upscaler_t upscaler);
 SD_API enum sd_hires_upscaler_t str_to_sd_hires_upscaler(const char* str);
 
@@ -550,6 +593,39 @@ SD_API bool convert_with_components(const char* model_path,
                                     bool convert_name,
                                     int n_threads);
 
+// convert_with_components() with execution_order: tensors are written in
+// forward order (text encoders, diffusion model, VAE; blocks by index) so a
+// model's weights are read front to back while it runs.
+SD_API bool convert_with_components_ex(const char* model_path,
+                                       const char* clip_l_path,
+                                       const char* clip_g_path,
+                                       const char* t5xxl_path,
+                                       const char* diffusion_model_path,
+                                       const char* vae_path,
+                                       const char* output_path,
+                                       enum sd_type_t output_type,
+                                       const char* tensor_type_rules,
+                                       bool convert_name,
+                                       int n_threads,
+                                       bool execution_order);
+
+// Searches a quantization type per tensor group (block indices wildcarded)
+// so that the searched tensors average target_bpw bits per weight with the
+// least imatrix-weighted error. candidate_types is a comma-separated list of
+// type names (e.g. "q4_K,q5_K,q6_K,q8_0"). Returns a tensor_type_rules
+// string for convert_with_components / sd_ctx_params_t, or NULL on failure;
+// free it with free().
+SD_API char* search_tensor_type_rules(const char* model_path,
+                                      const char* clip_l_path,
+                                      const char* clip_g_path,
+                                      const char* t5xxl_path,
+                                      const char* diffusion_model_path,
+                                      const char* vae_path,
+                                      const char* candidate_types,
+                                      float target_bpw,
+                                      bool convert_name,
+                                      int n_threads);
+
 SD_API bool preprocess_canny(sd_image_t image,
                              float high_threshold,
                              float low_threshold,
@@ -12,6 +12,7 @@
 #include "model/te/llm.hpp"
 #include "model/te/t5.hpp"
 #include "model_loader.h"
+#include "runtime/encode-cache.h"
 
 struct SDCondition {
     sd::Tensor<float> c_crossattn;
@@ -108,6 +109,7 @@ struct ConditionerParams {
     bool zero_out_masked                             = false;
     const std::vector<sd::Tensor<float>>* ref_images = nullptr;  // for qwen image edit
     RefImageParams ref_image_params;
+    EncodeCache* encode_cache = nullptr;  // reuses vision embeddings of repeated ref images
 };
 
 struct Conditioner {
@@ -2044,6 +2046,25 @@ struct LLMEmbedder : public Conditioner {
         return new_hidden_states;
     }
 
+    sd::Tensor<float> encode_ref_image(int n_threads, const sd::Tensor<float>& image, EncodeCache* encode_cache) {
+        std::string cache_key;
+        sd::Tensor<float> image_embed;
+        EncodeCache::InputId input_id;
+        if (encode_cache != nullptr && encode_cache->enabled()) {
+            input_id  = EncodeCache::identify(image);
+            cache_key = sd_format("llm_vision|%016llx", (unsigned long long)input_id.hash);
+            if (encode_cache->lookup(cache_key, input_id, &image_embed)) {
+                LOG_DEBUG("using cached vision embedding");
+                return image_embed;
+            }
+        }
+        image_embed = llm->encode_image(n_threads, image, false, true, true);
+        if (!cache_key.empty() && !image_embed.empty()) {
+            encode_cache->insert(cache_key, input_id, image_embed);
+        }
+        return image_embed;
+    }
+
     void resize_image_dims(int height, int width, int& h_bar, int& w_bar, int factor, int min_size, int max_size, RefImageResizeMode mode) {
         if (min_size > 0 && min_size == max_size) {
             if (mode == RefImageResizeMode::AREA) {
@@ -2189,7 +2210,7 @@ struct LLMEmbedder : public Conditioner {
 
                     LOG_DEBUG("resize LingBotVideo ref image %d from %dx%d to %dx%d", i, height, width, h_bar, w_bar);
                     auto resized_image = clip_preprocess(image, w_bar, h_bar);
-                    auto image_embed   = llm->encode_image(n_threads, resized_image, false, true, true);
+                    auto image_embed   = encode_ref_image(n_threads, resized_image, conditioner_params.encode_cache);
                     GGML_ASSERT(!image_embed.empty());
 
                     std::string image_prefix = prompt + img_prompt + "<|vision_start|>";
@@ -2248,7 +2269,7 @@ struct LLMEmbedder : public Conditioner {
 
                     auto resized_image = clip_preprocess(image, w_bar, h_bar);
 
-                    auto image_embed = llm->encode_image(n_threads, resized_image, false, true, true);
+                    auto image_embed = encode_ref_image(n_threads, resized_image, conditioner_params.encode_cache);
                     GGML_ASSERT(!image_embed.empty());
                     image_embeds.emplace_back(image_embed_idx, image_embed);
                     image_embed_idx += 1 + static_cast<int>(image_embed.shape()[1]) + 6;
@@ -2331,7 +2352,7 @@ struct LLMEmbedder : public Conditioner {
                     LOG_DEBUG("resize conditioner ref image %d from %dx%d to %dx%d", i, height, width, h_bar, w_bar);
 
                     auto resized_image = clip_preprocess(image, w_bar, h_bar);
-                    auto image_embed   = llm->encode_image(n_threads, resized_image, false, true, true);
+                    auto image_embed   = encode_ref_image(n_threads, resized_image, conditioner_params.encode_cache);
                     GGML_ASSERT(!image_embed.empty());
 
                     std::string image_prefix = prompt_prefix + img_prompt + "<|vision_start|>";
@@ -2399,7 +2420,7 @@ struct LLMEmbedder : public Conditioner {
                     LOG_DEBUG("resize conditioner ref image %d from %dx%d to %dx%d", i, height, width, h_bar, w_bar);
 
                     auto resized_image = clip_preprocess(image, w_bar, h_bar);
-                    auto image_embed   = llm->encode_image(n_threads, resized_image, false, true, true);
+                    auto image_embed   = encode_ref_image(n_threads, resized_image, conditioner_params.encode_cache);
                     GGML_ASSERT(!image_embed.empty());
 
                     std::string image_prefix = prompt + img_prompt + "Picture " + std::to_string(i + 1) + ": <|vision_start|>";
@@ -2462,7 +2483,7 @@ struct LLMEmbedder : public Conditioner {
                     LOG_DEBUG("resize conditioner ref image %d from %dx%d to %dx%d", i, height, width, h_bar, w_bar);
 
                     auto resized_image = clip_preprocess(image, w_bar, h_bar);
-                    auto image_embed   = llm->encode_image(n_threads, resized_image, false, true, true);
+                    auto image_embed   = encode_ref_image(n_threads, resized_image, conditioner_params.encode_cache);
                     GGML_ASSERT(!image_embed.empty());
                     image_embeds.emplace_back(image_embed_idx, image_embed);
                     image_embed_idx += 1 + static_cast<int>(image_embed.shape()[1]) + 6;
@@ -1,12 +1,13 @@
 #include <algorithm>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <regex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -16,6 +17,8 @@
 #include "model_io/safetensors_io.h"
 #include "model_io/streaming_writer.h"
 #include "model_loader.h"
+#include "name_conversion.h"
+#include "runtime/imatrix.h"
 
 struct TensorExportInfo {
     TensorStorage storage;
@@ -32,18 +35,9 @@ struct TensorExportJob {
 static ggml_type get_export_tensor_type(ModelLoader& model_loader,
                                         const TensorStorage& tensor_storage,
                                         ggml_type type,
-                                        const TensorTypeRules& tensor_type_rules) {
-    const std::string& name = tensor_storage.name;
-    ggml_type tensor_type   = tensor_storage.type;
-    ggml_type dst_type      = type;
-
-    for (const auto& tensor_type_rule : tensor_type_rules) {
-        std::regex pattern(tensor_type_rule.first);
-        if (std::regex_search(name, pattern)) {
-            dst_type = tensor_type_rule.second;
-            break;
-        }
-    }
+                                        const TensorTypeRuleMatcher& type_rule_matcher) {
+    ggml_type tensor_type = tensor_storage.type;
+    ggml_type dst_type    = type_rule_matcher.match(tensor_storage.name, type);
 
     if (model_loader.tensor_should_be_converted(tensor_storage, dst_type)) {
         tensor_type = dst_type;
@@ -52,19 +46,127 @@ static ggml_type get_export_tensor_type(ModelLoader& model_loader,
     return tensor_type;
 }
 
+// Execution-order layout: the forward pass runs text encoders, then the
+// diffusion model, then the VAE, and inside each model goes input layers ->
+// blocks in the order they run (index order, except the VAE decoder's up
+// blocks, which run in reverse) -> output layers. Sorting names on that key
+// puts the weights of one block (and thus one graph-cut segment) next to each
+// other in the file, so streaming them is a sequential read.
+static int tensor_module_rank(const std::string& name) {
+    if (starts_with(name, "text_encoders.") || starts_with(name, "cond_stage_model.") || starts_with(name, "conditioner.")) {
+        return 0;
+    }
+    if (starts_with(name, "model.diffusion_model.")) {
+        return 1;
+    }
+    if (starts_with(name, "first_stage_model.") || starts_with(name, "vae.")) {
+        return 2;
+    }
+    return 3;
+}
+
+static bool is_index_part(const std::string& part) {
+    return !part.empty() && std::all_of(part.begin(), part.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+static int tensor_part_stage_rank(const std::string& part) {
+    if (ends_with(part, "_in") || starts_with(part, "input") || starts_with(part, "patch") || contains(part, "embed")) {
+        return 0;
+    }
+    if (part == "out" || ends_with(part, "_out") || starts_with(part, "final") || part == "head") {
+        return 2;
+    }
+    return 1;
+}
+
+// The LDM VAE decoder runs its up blocks from the highest index down
+// (decoder.up.3 first, decoder.up.0 last), the reverse of their numbering.
+static bool is_reversed_index_part(const std::vector<std::string>& parts, size_t i) {
+    return i >= 2 && parts[i - 1] == "up" && parts[i - 2] == "decoder";
+}
+
+static bool tensor_execution_order_less(const std::string& a, const std::string& b) {
+    int a_module = tensor_module_rank(a);
+    int b_module = tensor_module_rank(b);
+    if (a_module != b_module) {
+        return a_module < b_module;
+    }
+    std::vector<std::string> a_parts = split_string(a, '.');
+    std::vector<std::string> b_parts = split_string(b, '.');
+    for (size_t i = 0; i < a_parts.size() && i < b_parts.size(); i++) {
+        const std::string& a_part = a_parts[i];
+        const std::string& b_part = b_parts[i];
+        if (a_part == b_part) {
+            continue;
+        }
+        if (is_index_part(a_part) && is_index_part(b_part)) {
+            bool less = a_part.size() != b_part.size() ? a_part.size() < b_part.size() : a_part < b_part;
+            return is_reversed_index_part(a_parts, i) ? !less : less;
+        }
+        int a_stage = tensor_part_stage_rank(a_part);
+        int b_stage = tensor_part_stage_rank(b_part);
+        if (a_stage != b_stage) {
+            return a_stage < b_stage;
+        }
+        return a_part < b_part;
+    }
+    return a_parts.size() < b_parts.size();
+}
+
+// The unit the layout metadata is recorded in: everything up to the first
+// block index ("model.diffusion_model.double_blocks.3."), or the parent
+// module for tensors outside of blocks ("model.diffusion_model.img_in.").
+static std::string tensor_layout_group(const std::string& name) {
+    std::vector<std::string> parts = split_string(name, '.');
+    std::string group;
+    for (size_t i = 0; i + 1 < parts.size(); i++) {
+        group += parts[i] + ".";
+        if (is_index_part(parts[i])) {
+            return group;
+        }
+    }
+    return group;
+}
+
+static std::string tensor_layout_groups(const std::vector<TensorExportInfo>& tensors) {
+    std::string groups;
+    std::string last_group;
+    for (const TensorExportInfo& info : tensors) {
+        std::string group = tensor_layout_group(info.storage.name);
+        if (group == last_group) {
+            continue;
+        }
+        if (!groups.empty()) {
+            groups += ",";
+        }
+        groups += group;
+        last_group = std::move(group);
+    }
+    return groups;
+}
+
 static bool collect_tensors_for_export(ModelLoader& model_loader,
                                        ggml_type type,
                                        const TensorTypeRules& tensor_type_rules,
+                                       bool execution_order,
                                        std::vector<TensorExportInfo>& tensors) {
+    int64_t t_start = ggml_time_us();
+    TensorTypeRuleMatcher type_rule_matcher(tensor_type_rules);
     tensors.clear();
     tensors.reserve(model_loader.get_tensor_storage_map().size());
     for (const auto& kv : model_loader.get_tensor_storage_map()) {
         const TensorStorage& tensor_storage = kv.second;
         TensorExportInfo info;
         info.storage = tensor_storage;
-        info.type    = get_export_tensor_type(model_loader, tensor_storage, type, tensor_type_rules);
+        info.type    = get_export_tensor_type(model_loader, tensor_storage, type, type_rule_matcher);
         tensors.push_back(std::move(info));
     }
+    LOG_DEBUG("resolved export types of %zu tensors in %.2f ms", tensors.size(), (ggml_time_us() - t_start) / 1000.0);
+    if (execution_order) {
+        std::stable_sort(tensors.begin(), tensors.end(), [](const TensorExportInfo& a, const TensorExportInfo& b) {
+            return tensor_execution_order_less(a.storage.name, b.storage.name);
+        });
+    }
     LOG_INFO("collected %zu tensors for export", tensors.size());
     return true;
 }
@@ -326,13 +428,14 @@ static bool export_loaded_model(ModelLoader& model_loader,
                                 const char* output_path,
                                 sd_type_t output_type,
                                 const char* tensor_type_rules,
+                                bool execution_order,
                                 int n_threads) {
     ggml_type type             = sd_type_to_ggml_type(output_type);
     bool output_is_safetensors = ends_with(output_path, ".safetensors");
     TensorTypeRules type_rules = parse_tensor_type_rules(tensor_type_rules);
 
     std::vector<TensorExportInfo> tensors;
-    bool success = collect_tensors_for_export(model_loader, type, type_rules, tensors);
+    bool success = collect_tensors_for_export(model_loader, type, type_rules, execution_order, tensors);
     std::string error;
     if (success) {
         std::unique_ptr<StreamingModelWriter> writer;
@@ -341,6 +444,14 @@ static bool export_loaded_model(ModelLoader& model_loader,
         } else {
             writer = std::make_unique<GGUFStreamingWriter>();
         }
+        if (execution_order) {
+            std::string groups = tensor_layout_groups(tensors);
+            writer->set_kv_metadata({
+                {SD_TENSOR_LAYOUT_KEY, SD_TENSOR_LAYOUT_EXECUTION},
+                {SD_TENSOR_LAYOUT_GROUPS_KEY, groups},
+            });
+            LOG_INFO("writing tensors in execution order (%zu groups)", split_string(groups, ',').size());
+        }
         success = write_model_file_streaming(model_loader, output_path, tensors, *writer, n_threads, &error);
     }
 
@@ -351,18 +462,376 @@ static bool export_loaded_model(ModelLoader& model_loader,
     return success;
 }
 
-bool convert_with_components(const char* model_path,
-                             const char* clip_l_path,
-                             const char* clip_g_path,
-                             const char* t5xxl_path,
-                             const char* diffusion_model_path,
-                             const char* vae_path,
-                             const char* output_path,
-                             sd_type_t output_type,
-                             const char* tensor_type_rules,
-                             bool convert_name,
-                             int n_threads) {
-    ModelLoader model_loader;
+// Mixed-precision search: pick a type per tensor group so that the
+// quantized model meets a bits-per-weight budget with the least weighted
+// reconstruction error. The error of a row is sum_j im[j] * (w[j] - q[j])^2
+// with im the imatrix (mean squared activation of input j), i.e. the
+// expected squared matmul output error on the calibration prompts the
+// imatrix was collected on; without an imatrix it degrades to plain MSE.
+
+struct QuantSearchGroup {
+    std::string pattern;
+    std::vector<const TensorStorage*> tensors;
+    int64_t nelements = 0;
+    std::vector<ggml_type> types;  // candidates valid for every tensor, cheapest first
+    std::vector<uint64_t> nbytes;
+    std::vector<double> error;
+    size_t choice = 0;
+};
+
+static const int QUANT_SEARCH_MAX_ROWS = 256;
+
+static ggml_type parse_ggml_type_name(const std::string& type_name) {
+    if (type_name == "f32") {
+        return GGML_TYPE_F32;
+    }
+    for (int i = 0; i < GGML_TYPE_COUNT; i++) {
+        auto trait = ggml_get_type_traits((ggml_type)i);
+        if (trait->to_float && trait->type_size && type_name == trait->type_name) {
+            return (ggml_type)i;
+        }
+    }
+    return GGML_TYPE_COUNT;
+}
+
+static const char* ggml_type_rule_name(ggml_type type) {
+    return type == GGML_TYPE_F32 ? "f32" : ggml_get_type_traits(type)->type_name;
+}
+
+// Turns a tensor name into an anchored rule pattern with the block indices
+// wildcarded, so all blocks of the same role share one group.
+static std::string quant_search_group_pattern(const std::string& name) {
+    static const std::string special = "\\^$.|?*+()[]{}";
+    std::string pattern = "^";
+    for (const auto& part : split_string(name, '.')) {
+        if (pattern.size() > 1) {
+            pattern += "\\.";
+        }
+        if (is_index_part(part)) {
+            pattern += "[0-9]+";
+            continue;
+        }
+        for (char c : part) {
+            if (special.find(c) != std::string::npos) {
+                pattern += '\\';
+            }
+            pattern += c;
+        }
+    }
+    return pattern + "$";
+}
+
+// Relative weighted error of every candidate type for one tensor, measured
+// on up to QUANT_SEARCH_MAX_ROWS evenly spaced rows.
+static bool measure_quant_error(ModelLoader& model_loader,
+                                const TensorStorage& tensor_storage,
+                                const std::vector<ggml_type>& types,
+                                std::vector<double>& error,
+                                bool& has_imatrix) {
+    const int64_t n_per_row = tensor_storage.ne[0];
+    const int64_t nrows     = tensor_storage.nelements() / n_per_row;
+
+    const int64_t stride   = std::max<int64_t>(1, nrows / QUANT_SEARCH_MAX_ROWS);
+    const int64_t n_sample = (nrows + stride - 1) / stride;
+    std::vector<float> rows(n_sample * n_per_row);
+    // Only the sampled rows are read, so a worker holds at most
+    // QUANT_SEARCH_MAX_ROWS rows instead of the whole tensor in f32. Tensors
+    // inside zip archives can't be read partially and are loaded whole.
+    if (!model_loader.load_tensor_rows_f32(tensor_storage, stride, n_sample, rows.data())) {
+        if (tensor_storage.index_in_zip < 0) {
+            return false;
+        }
+        size_t mem_size        = ggml_tensor_overhead() + tensor_storage.nelements() * sizeof(float) + 1024;
+        ggml_context* ggml_ctx = ggml_init({mem_size, nullptr, false});
+        if (ggml_ctx == nullptr) {
+            return false;
+        }
+        ggml_tensor* tensor = ggml_new_tensor(ggml_ctx, GGML_TYPE_F32, tensor_storage.n_dims, tensor_storage.ne);
+        if (!model_loader.load_tensor(tensor_storage, tensor)) {
+            ggml_free(ggml_ctx);
+            return false;
+        }
+        for (int64_t i = 0; i < n_sample; i++) {
+            memcpy(rows.data() + i * n_per_row, (float*)tensor->data + i * stride * n_per_row, n_per_row * sizeof(float));
+        }
+        ggml_free(ggml_ctx);
+    }
+
+    SDVersion version          = model_loader.get_sd_version();
+    std::vector<float> imatrix = get_imatrix_collector().get_values(convert_tensor_name(tensor_storage.name, version));
+    has_imatrix                = imatrix.size() == (size_t)n_per_row;
+    if (!has_imatrix) {
+        imatrix.assign(n_per_row, 1.0f);
+    }
+
+    double signal = 0.0;
+    for (int64_t i = 0; i < n_sample; i++) {
+        for (int64_t j = 0; j < n_per_row; j++) {
+            double w = rows[i * n_per_row + j];
+            signal += imatrix[j] * w * w;
+        }
+    }
+
+    std::vector<uint8_t> quantized;
+    std::vector<float> dequantized(rows.size());
+    error.assign(types.size(), 0.0);
+    for (size_t t = 0; t < types.size(); t++) {
+        ggml_type type = types[t];
+        if (type == GGML_TYPE_F32) {
+            continue;
+        }
+        quantized.resize(ggml_row_size(type, n_per_row) * n_sample);
+        if (type == GGML_TYPE_F16) {
+            ggml_fp32_to_fp16_row(rows.data(), (ggml_fp16_t*)quantized.data(), (int64_t)rows.size());
+        } else {
+            ggml_quantize_chunk(type, rows.data(), quantized.data(), 0, n_sample, n_per_row, imatrix.data());
+        }
+        ggml_get_type_traits(type)->to_float(quantized.data(), dequantized.data(), (int64_t)rows.size());
+
+        double err = 0.0;
+        for (int64_t i = 0; i < n_sample; i++) {
+            for (int64_t j = 0; j < n_per_row; j++) {
+                double d = (double)rows[i * n_per_row + j] - dequantized[i * n_per_row + j];
+                err += imatrix[j] * d * d;
+            }
+        }
+        error[t] = signal > 0.0 ? err / signal : 0.0;
+    }
+    return true;
+}
+
+static bool collect_quant_search_groups(ModelLoader& model_loader,
+                                        const std::vector<ggml_type>& types,
+                                        std::vector<QuantSearchGroup>& groups) {
+    std::map<std::string, size_t> group_index;
+    for (const auto& kv : model_loader.get_tensor_storage_map()) {
+        const TensorStorage& tensor_storage = kv.second;
+        if (tensor_storage.n_dims < 2 || tensor_storage.ne[0] <= 0 ||
+            !model_loader.tensor_should_be_converted(tensor_storage, types.back())) {
+            continue;
+        }
+        std::string pattern = quant_search_group_pattern(tensor_storage.name);
+        auto it             = group_index.find(pattern);
+        if (it == group_index.end()) {
+            it = group_index.emplace(pattern, groups.size()).first;
+            groups.emplace_back();
+            groups.back().pattern = pattern;
+            groups.back().types   = types;
+        }
+        QuantSearchGroup& group = groups[it->second];
+        group.tensors.push_back(&tensor_storage);
+        group.nelements += tensor_storage.nelements();
+        group.types.erase(std::remove_if(group.types.begin(), group.types.end(), [&](ggml_type type) {
+                              return ggml_is_quantized(type) && tensor_storage.ne[0] % ggml_blck_size(type) != 0;
+                          }),
+                          group.types.end());
+    }
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [](const QuantSearchGroup& group) {
+                     return group.types.empty();
+                 }),
+                 groups.end());
+    return !groups.empty();
+}
+
+static bool measure_quant_search_groups(ModelLoader& model_loader,
+                                        std::vector<QuantSearchGroup>& groups,
+                                        int n_threads) {
+    std::vector<std::pair<size_t, size_t>> jobs;
+    for (size_t g = 0; g < groups.size(); g++) {
+        QuantSearchGroup& group = groups[g];
+        group.nbytes.assign(group.types.size(), 0);
+        group.error.assign(group.types.size(), 0.0);
+        for (size_t t = 0; t < group.tensors.size(); t++) {
+            const TensorStorage& tensor_storage = *group.tensors[t];
+            for (size_t k = 0; k < group.types.size(); k++) {
+                group.nbytes[k] += ggml_row_size(group.types[k], tensor_storage.ne[0]) *
+                                   (tensor_storage.nelements() / tensor_storage.ne[0]);
+            }
+            jobs.emplace_back(g, t);
+        }
+    }
+
+    n_threads = n_threads > 0 ? n_threads : sd_get_num_physical_cores();
+    n_threads = std::max(1, n_threads);
+
+    int64_t start_time  = ggml_time_ms();
+    size_t next_job     = 0;
+    size_t jobs_done    = 0;
+    size_t with_imatrix = 0;
+    bool failed         = false;
+    std::string failure;
+    std::mutex mutex;
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < n_threads; worker++) {
+        workers.emplace_back([&]() {
+            while (true) {
+                size_t job_index = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failed || next_job >= jobs.size()) {
+                        return;
+                    }
+                    job_index = next_job++;
+                }
+                QuantSearchGroup& group             = groups[jobs[job_index].first];
+                const TensorStorage& tensor_storage = *group.tensors[jobs[job_index].second];
+
+                std::vector<double> error;
+                bool has_imatrix = false;
+                bool success     = false;
+                try {
+                    success = measure_quant_error(model_loader, tensor_storage, group.types, error, has_imatrix);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("%s", e.what());
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!success) {
+                    failed  = true;
+                    failure = "failed to measure quantization error of tensor '" + tensor_storage.name + "'";
+                    return;
+                }
+                for (size_t k = 0; k < error.size(); k++) {
+                    group.error[k] += error[k];
+                }
+                with_imatrix += has_imatrix ? 1 : 0;
+                jobs_done++;
+                pretty_progress(static_cast<int>(jobs_done),
+                                static_cast<int>(jobs.size()),
+                                (ggml_time_ms() - start_time) / 1000.0f / jobs_done);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    printf("\n");
+    if (failed) {
+        LOG_ERROR("%s", failure.c_str());
+        return false;
+    }
+    if (with_imatrix == 0) {
+        LOG_WARN("no imatrix loaded, quantization search falls back to unweighted error");
+    } else if (with_imatrix < jobs.size()) {
+        LOG_INFO("imatrix covers %zu/%zu searched tensors", with_imatrix, jobs.size());
+    }
+    LOG_INFO("measured quantization error of %zu tensors, taking %.2fs",
+             jobs.size(),
+             (ggml_time_ms() - start_time) / 1000.f);
+    return true;
+}
+
+// Greedy allocation: start every group at its cheapest type and keep taking
+// the upgrade with the largest error reduction per extra byte that still
+// fits in the budget.
+static void allocate_quant_search_groups(std::vector<QuantSearchGroup>& groups, uint64_t budget_bytes) {
+    uint64_t used_bytes = 0;
+    for (auto& group : groups) {
+        group.choice = 0;
+        used_bytes += group.nbytes[0];
+    }
+    if (used_bytes > budget_bytes) {
+        LOG_WARN("target is below the cheapest candidate type, using it for every tensor");
+    }
+
+    while (true) {
+        QuantSearchGroup* best = nullptr;
+        size_t best_choice     = 0;
+        double best_gain       = 0.0;
+        for (auto& group : groups) {
+            for (size_t k = group.choice + 1; k < group.types.size(); k++) {
+                uint64_t extra = group.nbytes[k] - group.nbytes[group.choice];
+                double reduced = group.error[group.choice] - group.error[k];
+                if (reduced <= 0.0 || used_bytes + extra > budget_bytes) {
+                    continue;
+                }
+                double gain = reduced / std::max<uint64_t>(1, extra);
+                if (gain > best_gain) {
+                    best        = &group;
+                    best_choice = k;
+                    best_gain   = gain;
+                }
+            }
+        }
+        if (best == nullptr) {
+            break;
+        }
+        used_bytes += best->nbytes[best_choice] - best->nbytes[best->choice];
+        best->choice = best_choice;
+    }
+}
+
+static std::string search_loaded_model_type_rules(ModelLoader& model_loader,
+                                                  const char* candidate_types,
+                                                  float target_bpw,
+                                                  int n_threads) {
+    std::vector<ggml_type> types;
+    for (const auto& type_name : split_string(candidate_types != nullptr ? candidate_types : "", ',')) {
+        if (type_name.empty()) {
+            continue;
+        }
+        ggml_type type = parse_ggml_type_name(type_name);
+        if (type == GGML_TYPE_COUNT) {
+            LOG_WARN("ignoring invalid candidate type \"%s\"", type_name.c_str());
+        } else if (ggml_quantize_requires_imatrix(type)) {
+            LOG_WARN("ignoring candidate type \"%s\", it requires an imatrix for every tensor", type_name.c_str());
+        } else {
+            types.push_back(type);
+        }
+    }
+    if (types.empty()) {
+        LOG_ERROR("no valid candidate types for quantization search");
+        return "";
+    }
+    std::sort(types.begin(), types.end(), [](ggml_type a, ggml_type b) {
+        double a_bpw = 8.0 * ggml_type_size(a) / ggml_blck_size(a);
+        double b_bpw = 8.0 * ggml_type_size(b) / ggml_blck_size(b);
+        return a_bpw < b_bpw;
+    });
+    types.erase(std::unique(types.begin(), types.end()), types.end());
+
+    std::vector<QuantSearchGroup> groups;
+    if (!collect_quant_search_groups(model_loader, types, groups)) {
+        LOG_ERROR("no quantizable tensors found for quantization search");
+        return "";
+    }
+    model_loader.process_model_files(false, false);
+    if (!measure_quant_search_groups(model_loader, groups, n_threads)) {
+        return "";
+    }
+
+    int64_t nelements = 0;
+    for (const auto& group : groups) {
+        nelements += group.nelements;
+    }
+    allocate_quant_search_groups(groups, static_cast<uint64_t>(target_bpw / 8.0 * nelements));
+
+    std::string rules;
+    uint64_t nbytes = 0;
+    for (const auto& group : groups) {
+        ggml_type type = group.types[group.choice];
+        nbytes += group.nbytes[group.choice];
+        LOG_DEBUG("%s: %s (relative error %.3e)", group.pattern.c_str(), ggml_type_rule_name(type), group.error[group.choice]);
+        if (!rules.empty()) {
+            rules += ",";
+        }
+        rules += group.pattern + "=" + ggml_type_rule_name(type);
+    }
+    LOG_INFO("quantization search: %zu groups, %.2f bits per weight (target %.2f)",
+             groups.size(),
+             8.0 * nbytes / std::max<int64_t>(1, nelements),
+             target_bpw);
+    return rules;
+}
+
+static bool init_convert_components(ModelLoader& model_loader,
+                                    const char* model_path,
+                                    const char* clip_l_path,
+                                    const char* clip_g_path,
+                                    const char* t5xxl_path,
+                                    const char* diffusion_model_path,
+                                    const char* vae_path,
+                                    bool convert_name) {
     bool loaded_any = false;
 
     if (!init_convert_path(model_loader, model_path, "", loaded_any) ||
@@ -382,8 +851,96 @@ bool convert_with_components(const char* model_path,
     if (convert_name) {
         model_loader.convert_tensors_name();
     }
+    return true;
+}
 
-    return export_loaded_model(model_loader, output_path, output_type, tensor_type_rules, n_threads);
+bool convert_with_components_ex(const char* model_path,
+                                const char* clip_l_path,
+                                const char* clip_g_path,
+                                const char* t5xxl_path,
+                                const char* diffusion_model_path,
+                                const char* vae_path,
+                                const char* output_path,
+                                sd_type_t output_type,
+                                const char* tensor_type_rules,
+                                bool convert_name,
+                                int n_threads,
+                                bool execution_order) {
+    ModelLoader model_loader;
+    if (!init_convert_components(model_loader,
+                                 model_path,
+                                 clip_l_path,
+                                 clip_g_path,
+                                 t5xxl_path,
+                                 diffusion_model_path,
+                                 vae_path,
+                                 convert_name)) {
+        return false;
+    }
+
+    return export_loaded_model(model_loader, output_path, output_type, tensor_type_rules, execution_order, n_threads);
+}
+
+bool convert_with_components(const char* model_path,
+                             const char* clip_l_path,
+                             const char* clip_g_path,
+                             const char* t5xxl_path,
+                             const char* diffusion_model_path,
+                             const char* vae_path,
+                             const char* output_path,
+                             sd_type_t output_type,
+                             const char* tensor_type_rules,
+                             bool convert_name,
+                             int n_threads) {
+    return convert_with_components_ex(model_path,
+                                      clip_l_path,
+                                      clip_g_path,
+                                      t5xxl_path,
+                                      diffusion_model_path,
+                                      vae_path,
+                                      output_path,
+                                      output_type,
+                                      tensor_type_rules,
+                                      convert_name,
+                                      n_threads,
+                                      false);
+}
+
+char* search_tensor_type_rules(const char* model_path,
+                               const char* clip_l_path,
+                               const char* clip_g_path,
+                               const char* t5xxl_path,
+                               const char* diffusion_model_path,
+                               const char* vae_path,
+                               const char* candidate_types,
+                               float target_bpw,
+                               bool convert_name,
+                               int n_threads) {
+    if (target_bpw <= 0.f) {
+        LOG_ERROR("invalid target bits per weight %.2f", target_bpw);
+        return nullptr;
+    }
+    ModelLoader model_loader;
+    if (!init_convert_components(model_loader,
+                                 model_path,
+                                 clip_l_path,
+                                 clip_g_path,
+                                 t5xxl_path,
+                                 diffusion_model_path,
+                                 vae_path,
+                                 convert_name)) {
+        return nullptr;
+    }
+
+    std::string rules = search_loaded_model_type_rules(model_loader, candidate_types, target_bpw, n_threads);
+    if (rules.empty()) {
+        return nullptr;
+    }
+    char* buf = (char*)malloc(rules.size() + 1);
+    if (buf != nullptr) {
+        memcpy(buf, rules.c_str(), rules.size() + 1);
+    }
+    return buf;
 }
 
 bool convert(const char* input_path,
@@ -0,0 +1,133 @@
+#include "core/file_readahead.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "core/util.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sd {
+
+    bool FileReadahead::supported() {
+#ifdef __linux__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    FileReadahead::FileReadahead(size_t max_inflight_bytes, int n_workers)
+        : max_inflight_bytes_(max_inflight_bytes) {
+        if (!supported() || max_inflight_bytes_ == 0) {
+            return;
+        }
+        n_workers = std::max(1, n_workers);
+        workers_.reserve(static_cast<size_t>(n_workers));
+        for (int i = 0; i < n_workers; ++i) {
+            workers_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    FileReadahead::~FileReadahead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            queue_.clear();
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    size_t FileReadahead::submit(std::vector<FileReadRange> ranges) {
+        if (workers_.empty() || ranges.empty()) {
+            return 0;
+        }
+        size_t accepted = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& range : ranges) {
+                if (range.size == 0) {
+                    continue;
+                }
+                if (inflight_bytes_ + range.size > max_inflight_bytes_) {
+                    break;
+                }
+                inflight_bytes_ += range.size;
+                accepted += range.size;
+                queue_.push_back(std::move(range));
+            }
+        }
+        if (accepted > 0) {
+            cv_.notify_all();
+        }
+        return accepted;
+    }
+
+    void FileReadahead::cancel_pending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& range : queue_) {
+            inflight_bytes_ -= range.size;
+        }
+        queue_.clear();
+    }
+
+    size_t FileReadahead::inflight_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inflight_bytes_;
+    }
+
+    void FileReadahead::worker_loop() {
+#ifdef __linux__
+        std::unordered_map<std::string, int> fds;
+        while (true) {
+            FileReadRange range;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+                if (stop_) {
+                    break;
+                }
+                range = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            int fd     = -1;
+            auto fd_it = fds.find(range.path);
+            if (fd_it != fds.end()) {
+                fd = fd_it->second;
+            } else {
+                fd = open(range.path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    LOG_DEBUG("readahead: failed to open '%s'", range.path.c_str());
+                }
+                fds[range.path] = fd;
+            }
+            if (fd >= 0) {
+                // fadvise only queues the I/O; readahead() additionally blocks
+                // this worker until the pages are submitted, which keeps the
+                // in-flight accounting honest.
+                posix_fadvise(fd, (off_t)range.offset, (off_t)range.size, POSIX_FADV_WILLNEED);
+                readahead(fd, (off64_t)range.offset, (size_t)range.size);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            inflight_bytes_ -= range.size;
+        }
+        for (const auto& pair : fds) {
+            if (pair.second >= 0) {
+                close(pair.second);
+            }
+        }
+#endif
+    }
+
+}  // namespace sd
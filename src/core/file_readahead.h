@@ -0,0 +1,59 @@
+#ifndef __SD_CORE_FILE_READAHEAD_H__
+#define __SD_CORE_FILE_READAHEAD_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sd {
+
+    struct FileReadRange {
+        std::string path;
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    // Background page cache warm-up for byte ranges of model files.
+    //
+    // Ranges are handed to a small pool of worker threads which issue
+    // posix_fadvise(WILLNEED) + readahead() on Linux, so a later read()/mmap
+    // access of the same bytes is served from the page cache. The number of
+    // queued-but-not-yet-issued bytes is bounded by max_inflight_bytes; ranges
+    // beyond the budget are dropped rather than blocking the caller. On
+    // platforms without these hints submit() is a no-op.
+    class FileReadahead {
+    public:
+        FileReadahead(size_t max_inflight_bytes, int n_workers = 2);
+        ~FileReadahead();
+
+        FileReadahead(const FileReadahead&)            = delete;
+        FileReadahead& operator=(const FileReadahead&) = delete;
+
+        static bool supported();
+
+        // Returns the number of bytes accepted into the queue.
+        size_t submit(std::vector<FileReadRange> ranges);
+        // Drops all queued ranges that have not been picked up by a worker.
+        void cancel_pending();
+        size_t inflight_bytes() const;
+        size_t max_inflight_bytes() const { return max_inflight_bytes_; }
+
+    private:
+        void worker_loop();
+
+        size_t max_inflight_bytes_ = 0;
+        size_t inflight_bytes_     = 0;
+        bool stop_                 = false;
+        std::deque<FileReadRange> queue_;
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::thread> workers_;
+    };
+
+}  // namespace sd
+
+#endif  // __SD_CORE_FILE_READAHEAD_H__
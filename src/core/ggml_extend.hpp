@@ -745,31 +745,62 @@ __STATIC_INLINE__ int64_t sd_tensor_plane_size(const sd::Tensor<float>& tensor)
     return tensor.shape()[0] * tensor.shape()[1];
 }
 
+// Copies the (wrapping) width x height window at (x, y) of every plane of input
+// into dst, starting at plane dst_plane_offset. dst must already have the tile
+// shape, so one buffer can be refilled for every tile.
+__STATIC_INLINE__ void sd_tensor_split_2d_into(const sd::Tensor<float>& input,
+                                               sd::Tensor<float>* dst,
+                                               int x,
+                                               int y,
+                                               int64_t dst_plane_offset = 0) {
+    GGML_ASSERT(dst != nullptr);
+    const int64_t width        = dst->shape()[0];
+    const int64_t height       = dst->shape()[1];
+    const int64_t input_width  = input.shape()[0];
+    const int64_t input_height = input.shape()[1];
+    const int64_t input_plane  = sd_tensor_plane_size(input);
+    const int64_t output_plane = width * height;
+    const int64_t plane_count  = input.numel() / input_plane;
+    GGML_ASSERT((dst_plane_offset + plane_count) * output_plane <= dst->numel());
+
+    const int64_t x0    = x % input_width;
+    const int64_t first = std::min(width, input_width - x0);
+    const float* src    = input.data();
+    float* out          = dst->data() + dst_plane_offset * output_plane;
+    for (int64_t plane = 0; plane < plane_count; ++plane) {
+        for (int64_t iy = 0; iy < height; iy++) {
+            const float* src_row = src + plane * input_plane + input_width * ((iy + y) % input_height);
+            float* dst_row       = out + plane * output_plane + width * iy;
+            std::copy(src_row + x0, src_row + x0 + first, dst_row);
+            std::copy(src_row, src_row + (width - first), dst_row + first);
+        }
+    }
+}
+
 __STATIC_INLINE__ sd::Tensor<float> sd_tensor_split_2d(const sd::Tensor<float>& input, int width, int height, int x, int y) {
     GGML_ASSERT(input.dim() >= 4);
     std::vector<int64_t> output_shape = input.shape();
     output_shape[0]                   = width;
     output_shape[1]                   = height;
     sd::Tensor<float> output(std::move(output_shape));
-    int64_t input_width  = input.shape()[0];
-    int64_t input_height = input.shape()[1];
-    int64_t input_plane  = sd_tensor_plane_size(input);
-    int64_t output_plane = sd_tensor_plane_size(output);
-    int64_t plane_count  = input.numel() / input_plane;
-    for (int iy = 0; iy < height; iy++) {
-        for (int ix = 0; ix < width; ix++) {
-            int64_t src_xy = (ix + x) % input_width + input_width * ((iy + y) % input_height);
-            int64_t dst_xy = ix + width * iy;
-            for (int64_t plane = 0; plane < plane_count; ++plane) {
-                output[plane * output_plane + dst_xy] = input[plane * input_plane + src_xy];
-            }
-        }
-    }
+    sd_tensor_split_2d_into(input, &output, x, y);
     return output;
 }
 
-__STATIC_INLINE__ void sd_tensor_merge_2d(const sd::Tensor<float>& input,
-                                          sd::Tensor<float>* output,
+// Blends plane_count width x height planes starting at src into the image at
+// (x, y). out holds rows [out_y0, out_y0 + out_rows) of the img_width x
+// img_height image, one plane after another. The blend weight is separable, so
+// it is computed once per column and once per row and the inner loop is a
+// plain multiply-add over a row.
+__STATIC_INLINE__ void sd_tensor_merge_2d(const float* src,
+                                          int64_t width,
+                                          int64_t height,
+                                          int64_t plane_count,
+                                          float* out,
+                                          int64_t img_width,
+                                          int64_t img_height,
+                                          int64_t out_y0,
+                                          int64_t out_rows,
                                           int x,
                                           int y,
                                           int overlap_x,
@@ -778,15 +809,9 @@ __STATIC_INLINE__ void sd_tensor_merge_2d(const sd::Tensor<float>& input,
                                           bool circular_y,
                                           int x_skip = 0,
                                           int y_skip = 0) {
-    GGML_ASSERT(output != nullptr);
-    int64_t width        = input.shape()[0];
-    int64_t height       = input.shape()[1];
-    int64_t img_width    = output->shape()[0];
-    int64_t img_height   = output->shape()[1];
-    int64_t input_plane  = sd_tensor_plane_size(input);
-    int64_t output_plane = sd_tensor_plane_size(*output);
-    int64_t plane_count  = input.numel() / input_plane;
-    GGML_ASSERT(output->numel() / output_plane == plane_count);
+    GGML_ASSERT(out != nullptr);
+    int64_t input_plane  = width * height;
+    int64_t output_plane = img_width * out_rows;
 
     // unclamped -> expects x in the range [0-1]
     auto smootherstep_f32 = [](const float x) -> float {
@@ -794,45 +819,122 @@ __STATIC_INLINE__ void sd_tensor_merge_2d(const sd::Tensor<float>& input,
         return x * x * x * (x * (6.0f * x - 15.0f) + 10.0f);
     };
 
-    for (int iy = y_skip; iy < height; iy++) {
-        for (int ix = x_skip; ix < width; ix++) {
-            int64_t src_xy = ix + width * iy;
-            int64_t ox     = (x + ix) % img_width;
-            int64_t oy     = (y + iy) % img_height;
-            int64_t dst_xy = ox + img_width * oy;
-            for (int64_t plane = 0; plane < plane_count; ++plane) {
-                float new_value = input[plane * input_plane + src_xy];
-                if (overlap_x > 0 || overlap_y > 0) {
-                    float old_value   = (*output)[plane * output_plane + dst_xy];
-                    const float x_f_0 = (circular_x || (overlap_x > 0 && x > 0)) ? (ix - x_skip) / float(overlap_x) : 1.f;
-                    const float x_f_1 = (circular_x || (overlap_x > 0 && x < (img_width - width))) ? (width - ix) / float(overlap_x) : 1.f;
-                    const float y_f_0 = (circular_y || (overlap_y > 0 && y > 0)) ? (iy - y_skip) / float(overlap_y) : 1.f;
-                    const float y_f_1 = (circular_y || (overlap_y > 0 && y < (img_height - height))) ? (height - iy) / float(overlap_y) : 1.f;
-                    const float x_f   = std::min(std::min(x_f_0, x_f_1), 1.f);
-                    const float y_f   = std::min(std::min(y_f_0, y_f_1), 1.f);
-                    (*output)[plane * output_plane + dst_xy] =
-                        old_value + new_value * smootherstep_f32(y_f) * smootherstep_f32(x_f);
-                } else {
-                    (*output)[plane * output_plane + dst_xy] = new_value;
+    const bool blend  = overlap_x > 0 || overlap_y > 0;
+    const int64_t n_x = width - x_skip;
+    const int64_t n_y = height - y_skip;
+    if (n_x <= 0 || n_y <= 0) {
+        return;
+    }
+    std::vector<float> x_weights;
+    std::vector<float> y_weights;
+    if (blend) {
+        x_weights.resize(static_cast<size_t>(n_x));
+        y_weights.resize(static_cast<size_t>(n_y));
+        for (int64_t ix = x_skip; ix < width; ix++) {
+            const float x_f_0      = (circular_x || (overlap_x > 0 && x > 0)) ? (ix - x_skip) / float(overlap_x) : 1.f;
+            const float x_f_1      = (circular_x || (overlap_x > 0 && x < (img_width - width))) ? (width - ix) / float(overlap_x) : 1.f;
+            x_weights[ix - x_skip] = smootherstep_f32(std::min(std::min(x_f_0, x_f_1), 1.f));
+        }
+        for (int64_t iy = y_skip; iy < height; iy++) {
+            const float y_f_0      = (circular_y || (overlap_y > 0 && y > 0)) ? (iy - y_skip) / float(overlap_y) : 1.f;
+            const float y_f_1      = (circular_y || (overlap_y > 0 && y < (img_height - height))) ? (height - iy) / float(overlap_y) : 1.f;
+            y_weights[iy - y_skip] = smootherstep_f32(std::min(std::min(y_f_0, y_f_1), 1.f));
+        }
+    }
+
+    // A circular tile wraps at most once, so each row is at most two runs.
+    const int64_t ox0   = (x + x_skip) % img_width;
+    const int64_t first = std::min(n_x, img_width - ox0);
+    const float* wx     = x_weights.data();
+    for (int64_t iy = y_skip; iy < height; iy++) {
+        const int64_t oy = (y + iy) % img_height - out_y0;
+        GGML_ASSERT(oy >= 0 && oy < out_rows);
+        for (int64_t plane = 0; plane < plane_count; ++plane) {
+            const float* src_row = src + plane * input_plane + width * iy + x_skip;
+            float* dst_row       = out + plane * output_plane + img_width * oy;
+            if (blend) {
+                const float wy = y_weights[iy - y_skip];
+                float* dst     = dst_row + ox0;
+                for (int64_t i = 0; i < first; i++) {
+                    dst[i] += src_row[i] * wy * wx[i];
+                }
+                for (int64_t i = first; i < n_x; i++) {
+                    dst_row[i - first] += src_row[i] * wy * wx[i];
                 }
+            } else {
+                std::copy(src_row, src_row + first, dst_row + ox0);
+                std::copy(src_row + first, src_row + n_x, dst_row);
             }
         }
     }
 }
 
+__STATIC_INLINE__ void sd_tensor_merge_2d(const sd::Tensor<float>& input,
+                                          sd::Tensor<float>* output,
+                                          int x,
+                                          int y,
+                                          int overlap_x,
+                                          int overlap_y,
+                                          bool circular_x,
+                                          bool circular_y,
+                                          int x_skip = 0,
+                                          int y_skip = 0) {
+    GGML_ASSERT(output != nullptr);
+    int64_t input_plane = sd_tensor_plane_size(input);
+    int64_t plane_count = input.numel() / input_plane;
+    GGML_ASSERT(output->numel() / sd_tensor_plane_size(*output) == plane_count);
+    sd_tensor_merge_2d(input.data(),
+                       input.shape()[0],
+                       input.shape()[1],
+                       plane_count,
+                       output->data(),
+                       output->shape()[0],
+                       output->shape()[1],
+                       0,
+                       output->shape()[1],
+                       x,
+                       y,
+                       overlap_x,
+                       overlap_y,
+                       circular_x,
+                       circular_y,
+                       x_skip,
+                       y_skip);
+}
+
+// Finished rows of a streamed tiled pass (see process_tiles_2d_rows): rows
+// [y0, y0 + n_rows) of a width x height output. data holds plane_count planes
+// of width x plane_rows floats; the finished rows are the first n_rows of each
+// plane. The sink may modify them in place.
+struct SDTileRows {
+    float* data         = nullptr;
+    int width           = 0;
+    int height          = 0;
+    int plane_rows      = 0;
+    int64_t plane_count = 0;
+    int y0              = 0;
+    int n_rows          = 0;
+};
+
+typedef std::function<bool(SDTileRows& rows)> sd_tile_rows_cb_t;
+
 template <typename Fn>
-__STATIC_INLINE__ sd::Tensor<float> process_tiles_2d(const sd::Tensor<float>& input,
-                                                     int output_width,
-                                                     int output_height,
-                                                     int scale,
-                                                     int p_tile_size_x,
-                                                     int p_tile_size_y,
-                                                     float tile_overlap_factor,
-                                                     bool circular_x,
-                                                     bool circular_y,
-                                                     Fn&& on_processing,
-                                                     bool silent = false) {
-    sd::Tensor<float> output;
+__STATIC_INLINE__ bool sd_process_tiles_2d(const sd::Tensor<float>& input,
+                                           int output_width,
+                                           int output_height,
+                                           int scale,
+                                           int p_tile_size_x,
+                                           int p_tile_size_y,
+                                           float tile_overlap_factor,
+                                           bool circular_x,
+                                           bool circular_y,
+                                           Fn&& on_processing,
+                                           bool silent,
+                                           int tile_batch_size,
+                                           sd::Tensor<float>* output,
+                                           const sd_tile_rows_cb_t* on_rows) {
+    GGML_ASSERT((output != nullptr) != (on_rows != nullptr));
+    GGML_ASSERT(on_rows == nullptr || !circular_y);
     int input_width  = static_cast<int>(input.shape()[0]);
     int input_height = static_cast<int>(input.shape()[1]);
 
@@ -874,18 +976,20 @@ __STATIC_INLINE__ sd::Tensor<float> process_tiles_2d(const sd::Tensor<float>& in
         input_tile_size_x *= scale;
         input_tile_size_y *= scale;
     }
+    int overlap_x_out = decode ? tile_overlap_x * scale : tile_overlap_x;
+    int overlap_y_out = decode ? tile_overlap_y * scale : tile_overlap_y;
 
-    int num_tiles   = num_tiles_x * num_tiles_y;
-    int tile_count  = 1;
-    bool last_y     = false;
-    bool last_x     = false;
-    float last_time = 0.0f;
-    if (!silent) {
-        LOG_DEBUG("num tiles : %d, %d ", num_tiles_x, num_tiles_y);
-        LOG_DEBUG("optimal overlap : %f, %f (targeting %f)", tile_overlap_factor_x, tile_overlap_factor_y, tile_overlap_factor);
-        LOG_DEBUG("processing %i tiles", num_tiles);
-        pretty_progress(0, num_tiles, 0.0f);
-    }
+    struct TilePos {
+        int x_in;
+        int y_in;
+        int x_out;
+        int y_out;
+        int dx;
+        int dy;
+    };
+    std::vector<TilePos> tiles;
+    bool last_y = false;
+    bool last_x = false;
     for (int y = 0; y < small_height && !last_y; y += non_tile_overlap_y) {
         int dy = 0;
         if (!circular_y && y + tile_size_y >= small_height) {
@@ -909,47 +1013,221 @@ __STATIC_INLINE__ sd::Tensor<float> process_tiles_2d(const sd::Tensor<float>& in
                 last_x = true;
             }
 
-            int x_in  = decode ? x : scale * x;
-            int y_in  = decode ? y : scale * y;
-            int x_out = decode ? x * scale : x;
-            int y_out = decode ? y * scale : y;
+            TilePos tile;
+            tile.x_in  = decode ? x : scale * x;
+            tile.y_in  = decode ? y : scale * y;
+            tile.x_out = decode ? x * scale : x;
+            tile.y_out = decode ? y * scale : y;
+            tile.dx    = dx;
+            tile.dy    = dy;
+            tiles.push_back(tile);
+        }
+        last_x = false;
+    }
+
+    if (tile_batch_size > 1 && (input.dim() != 4 || input.shape()[3] != 1)) {
+        tile_batch_size = 1;
+    }
+    tile_batch_size = std::max(1, std::min(tile_batch_size, static_cast<int>(tiles.size())));
+
+    int num_tiles   = num_tiles_x * num_tiles_y;
+    int tile_count  = 1;
+    float last_time = 0.0f;
+    if (!silent) {
+        LOG_DEBUG("num tiles : %d, %d ", num_tiles_x, num_tiles_y);
+        LOG_DEBUG("optimal overlap : %f, %f (targeting %f)", tile_overlap_factor_x, tile_overlap_factor_y, tile_overlap_factor);
+        if (tile_batch_size > 1) {
+            LOG_DEBUG("processing %i tiles, %i per batch", num_tiles, tile_batch_size);
+        } else {
+            LOG_DEBUG("processing %i tiles", num_tiles);
+        }
+        pretty_progress(0, num_tiles, 0.0f);
+    }
 
-            int overlap_x_out = decode ? tile_overlap_x * scale : tile_overlap_x;
-            int overlap_y_out = decode ? tile_overlap_y * scale : tile_overlap_y;
+    // Blend target: the whole output, or in streaming mode a band of one tile
+    // row whose top rows are handed out and shifted away once finished.
+    sd::Tensor<float> band;
+    sd::Tensor<float>& target = output != nullptr ? *output : band;
+    const int band_rows       = output != nullptr ? output_height : output_tile_size_y;
+    int band_y0               = 0;
+    int64_t band_planes       = 0;
 
-            int64_t t1       = ggml_time_ms();
-            auto input_tile  = sd_tensor_split_2d(input, input_tile_size_x, input_tile_size_y, x_in, y_in);
-            auto output_tile = on_processing(input_tile);
-            if (output_tile.empty()) {
-                return {};
+    sd::Tensor<float> input_batch;
+    for (size_t first_tile = 0; first_tile < tiles.size(); first_tile += tile_batch_size) {
+        const int batch = static_cast<int>(std::min(tiles.size() - first_tile, static_cast<size_t>(tile_batch_size)));
+        int64_t t1      = ggml_time_ms();
+
+        std::vector<int64_t> batch_shape = input.shape();
+        batch_shape[0]                   = input_tile_size_x;
+        batch_shape[1]                   = input_tile_size_y;
+        if (tile_batch_size > 1) {
+            batch_shape[3] = batch;
+        }
+        if (input_batch.shape() != batch_shape) {
+            input_batch = sd::Tensor<float>(std::move(batch_shape));
+        }
+        const int64_t tile_planes = input.numel() / sd_tensor_plane_size(input);
+        for (int i = 0; i < batch; i++) {
+            const TilePos& tile = tiles[first_tile + i];
+            sd_tensor_split_2d_into(input, &input_batch, tile.x_in, tile.y_in, i * tile_planes);
+        }
+
+        auto output_batch = on_processing(input_batch);
+        if (output_batch.empty()) {
+            return false;
+        }
+        GGML_ASSERT(output_batch.shape()[0] == output_tile_size_x && output_batch.shape()[1] == output_tile_size_y);
+        GGML_ASSERT(tile_batch_size == 1 || (output_batch.dim() == 4 && output_batch.shape()[3] == batch));
+        const int64_t output_tile_plane  = sd_tensor_plane_size(output_batch);
+        const int64_t output_tile_planes = output_batch.numel() / output_tile_plane / batch;
+        if (target.empty()) {
+            std::vector<int64_t> target_shape = output_batch.shape();
+            target_shape[0]                   = output_width;
+            target_shape[1]                   = band_rows;
+            if (tile_batch_size > 1) {
+                target_shape[3] = 1;
             }
-            GGML_ASSERT(output_tile.shape()[0] == output_tile_size_x && output_tile.shape()[1] == output_tile_size_y);
-            if (output.empty()) {
-                std::vector<int64_t> output_shape = output_tile.shape();
-                output_shape[0]                   = output_width;
-                output_shape[1]                   = output_height;
-                output                            = sd::Tensor<float>::zeros(std::move(output_shape));
+            target      = sd::Tensor<float>::zeros(std::move(target_shape));
+            band_planes = output_tile_planes;
+        }
+        GGML_ASSERT(output_tile_planes == band_planes);
+        for (int i = 0; i < batch; i++) {
+            const size_t tile_index = first_tile + i;
+            const TilePos& tile     = tiles[tile_index];
+            sd_tensor_merge_2d(output_batch.data() + i * output_tile_planes * output_tile_plane,
+                               output_tile_size_x,
+                               output_tile_size_y,
+                               output_tile_planes,
+                               target.data(),
+                               output_width,
+                               output_height,
+                               band_y0,
+                               band_rows,
+                               tile.x_out,
+                               tile.y_out,
+                               overlap_x_out,
+                               overlap_y_out,
+                               circular_x,
+                               circular_y,
+                               tile.dx,
+                               tile.dy);
+
+            const bool row_done = tile_index + 1 == tiles.size() || tiles[tile_index + 1].y_out != tile.y_out;
+            if (on_rows == nullptr || !row_done) {
+                continue;
             }
-            sd_tensor_merge_2d(output_tile, &output, x_out, y_out, overlap_x_out, overlap_y_out, circular_x, circular_y, dx, dy);
-
-            if (!silent) {
-                int64_t t2 = ggml_time_ms();
-                last_time  = (t2 - t1) / 1000.0f;
-                pretty_progress(tile_count, num_tiles, last_time);
+            // Rows above the first row the next tile row writes are final.
+            const int next_y = tile_index + 1 < tiles.size()
+                                   ? tiles[tile_index + 1].y_out + tiles[tile_index + 1].dy
+                                   : output_height;
+            const int n_rows = next_y - band_y0;
+            GGML_ASSERT(n_rows >= 0 && n_rows <= band_rows);
+            SDTileRows rows;
+            rows.data        = target.data();
+            rows.width       = output_width;
+            rows.height      = output_height;
+            rows.plane_rows  = band_rows;
+            rows.plane_count = band_planes;
+            rows.y0          = band_y0;
+            rows.n_rows      = n_rows;
+            if (n_rows > 0 && !(*on_rows)(rows)) {
+                return false;
+            }
+            const int64_t row_size = output_width;
+            for (int64_t plane = 0; plane < band_planes; ++plane) {
+                float* plane_data = target.data() + plane * row_size * band_rows;
+                std::copy(plane_data + n_rows * row_size, plane_data + band_rows * row_size, plane_data);
+                std::fill(plane_data + (band_rows - n_rows) * row_size, plane_data + band_rows * row_size, 0.f);
             }
-            tile_count++;
+            band_y0 = next_y;
         }
-        last_x = false;
+
+        if (!silent) {
+            int64_t t2 = ggml_time_ms();
+            last_time  = (t2 - t1) / 1000.0f / batch;
+            pretty_progress(tile_count + batch - 1, num_tiles, last_time);
+        }
+        tile_count += batch;
     }
     if (!silent && tile_count < num_tiles) {
         pretty_progress(num_tiles, num_tiles, last_time);
     }
-    if (output.empty()) {
+    return !target.empty();
+}
+
+// Runs on_processing over overlapping tiles of input and blends the results.
+// With tile_batch_size > 1 (and a single-image 4D input) up to that many tiles
+// are stacked along dim 3 and handed to on_processing as one batch, which must
+// return the outputs stacked the same way. The tile buffer passed to
+// on_processing is reused between calls of the same batch size, so runners can
+// keep their graph bound to it.
+template <typename Fn>
+__STATIC_INLINE__ sd::Tensor<float> process_tiles_2d(const sd::Tensor<float>& input,
+                                                     int output_width,
+                                                     int output_height,
+                                                     int scale,
+                                                     int p_tile_size_x,
+                                                     int p_tile_size_y,
+                                                     float tile_overlap_factor,
+                                                     bool circular_x,
+                                                     bool circular_y,
+                                                     Fn&& on_processing,
+                                                     bool silent         = false,
+                                                     int tile_batch_size = 1) {
+    sd::Tensor<float> output;
+    if (!sd_process_tiles_2d(input,
+                             output_width,
+                             output_height,
+                             scale,
+                             p_tile_size_x,
+                             p_tile_size_y,
+                             tile_overlap_factor,
+                             circular_x,
+                             circular_y,
+                             std::forward<Fn>(on_processing),
+                             silent,
+                             tile_batch_size,
+                             &output,
+                             nullptr)) {
         return {};
     }
     return output;
 }
 
+// Streaming variant of process_tiles_2d for outputs too large to hold in
+// float: only one tile row is kept, and rows are passed to on_rows as soon as
+// no later tile overlaps them. Rows arrive top to bottom; returning false from
+// on_rows aborts. Not available with circular_y, where the last tile row wraps
+// onto the first.
+template <typename Fn>
+__STATIC_INLINE__ bool process_tiles_2d_rows(const sd::Tensor<float>& input,
+                                             int output_width,
+                                             int output_height,
+                                             int scale,
+                                             int p_tile_size_x,
+                                             int p_tile_size_y,
+                                             float tile_overlap_factor,
+                                             bool circular_x,
+                                             Fn&& on_processing,
+                                             const sd_tile_rows_cb_t& on_rows,
+                                             bool silent         = false,
+                                             int tile_batch_size = 1) {
+    return sd_process_tiles_2d(input,
+                               output_width,
+                               output_height,
+                               scale,
+                               p_tile_size_x,
+                               p_tile_size_y,
+                               tile_overlap_factor,
+                               circular_x,
+                               false,
+                               std::forward<Fn>(on_processing),
+                               silent,
+                               tile_batch_size,
+                               nullptr,
+                               &on_rows);
+}
+
 __STATIC_INLINE__ ggml_tensor* ggml_ext_group_norm_32(ggml_context* ctx,
                                                       ggml_tensor* a) {
     const float eps = 1e-6f;  // default eps parameter
@@ -1784,6 +2062,10 @@ protected:
     std::unordered_map<const ggml_tensor*, ggml_backend_t> graph_cut_layer_split_node_assignments_;
     bool graph_cut_layer_split_primary_notice_logged_ = false;
 
+    // Graph kept alive by compute_reused(); lives in compute_ctx.
+    ggml_cgraph* reused_graph_ = nullptr;
+    std::vector<int64_t> reused_graph_key_;
+
     template <typename T>
     static sd::Tensor<T> take_or_empty(std::optional<sd::Tensor<T>> tensor) {
         if (!tensor.has_value()) {
@@ -1859,6 +2141,7 @@ protected:
     }
 
     void free_compute_ctx() {
+        drop_reused_graph();
         debug_tensors.clear();
         if (compute_ctx != nullptr) {
             ggml_free(compute_ctx);
@@ -1957,6 +2240,42 @@ protected:
         return true;
     }
 
+    // Hint the weight manager about the params of the next few segments so
+    // disk reads can overlap with the compute of the current one.
+    void prefetch_graph_cut_segment_params(ggml_cgraph* gf, const GraphCutPlan& plan, size_t first_seg_idx) {
+        static constexpr size_t GRAPH_CUT_PREFETCH_SEGMENTS = 2;
+        if (first_seg_idx >= plan.segments.size()) {
+            return;
+        }
+        auto manager = weight_manager.lock();
+        if (manager == nullptr) {
+            return;
+        }
+        rebuild_params_tensor_set();
+
+        std::vector<ggml_tensor*> tensors;
+        std::unordered_set<ggml_tensor*> seen_params;
+        const size_t end_seg_idx = std::min(plan.segments.size(), first_seg_idx + GRAPH_CUT_PREFETCH_SEGMENTS);
+        for (size_t seg_idx = first_seg_idx; seg_idx < end_seg_idx; ++seg_idx) {
+            for (ggml_tensor* leaf : sd::ggml_graph_cut::param_tensors(gf, plan.segments[seg_idx])) {
+                ggml_tensor* param = canonical_param_tensor(leaf);
+                if (param != nullptr && seen_params.insert(param).second) {
+                    tensors.push_back(param);
+                }
+            }
+        }
+        if (!tensors.empty()) {
+            manager->prefetch_params(tensors);
+        }
+    }
+
+    void cancel_graph_cut_prefetch() {
+        auto manager = weight_manager.lock();
+        if (manager != nullptr) {
+            manager->cancel_prefetch();
+        }
+    }
+
     void free_compute_backend_param_tensors(const std::vector<ggml_tensor*>& tensors) {
         if (tensors.empty()) {
             return;
@@ -2728,6 +3047,15 @@ protected:
         };
         GraphWeightDoneGuard graph_weight_done_guard(this, &params_to_prepare);
 
+        // In-graph matmul input statistics: reduced on the device and read back
+        // once after the compute instead of syncing on every matmul.
+        std::vector<SDMatmulStat> matmul_stats;
+        ggml_context* matmul_stats_ctx = nullptr;
+        if (sd_get_matmul_stats_filter() != nullptr && !is_multi_device()) {
+            gf = sd_graph_with_matmul_input_stats(gf, sd_get_matmul_stats_filter(), &matmul_stats_ctx, &matmul_stats);
+        }
+        std::unique_ptr<ggml_context, decltype(&ggml_free)> matmul_stats_ctx_guard(matmul_stats_ctx, ggml_free);
+
         if (!alloc_compute_buffer(gf)) {
             LOG_ERROR("%s alloc compute buffer failed", get_desc().c_str());
             return std::nullopt;
@@ -2792,6 +3120,7 @@ protected:
             LOG_ERROR("%s compute failed: %s", get_desc().c_str(), ggml_status_to_string(status));
             return std::nullopt;
         }
+        sd_read_matmul_input_stats(matmul_stats, sd_get_matmul_stats_sink());
 
         if (!debug_tensors.empty()) {
             std::unordered_set<const ggml_tensor*> debug_graph_tensor_set;
@@ -2894,6 +3223,7 @@ protected:
 
             reset_segment_runtime_tensors(segment, gf, &persistent_externals);
             if (!bind_segment_cached_inputs(gf, segment)) {
+                cancel_graph_cut_prefetch();
                 free_cache_ctx_and_buffer();
                 free_compute_buffer();
                 free_compute_ctx();
@@ -2911,6 +3241,8 @@ protected:
                 }
             }
 
+            prefetch_graph_cut_segment_params(gf, plan, seg_idx + 1);
+
             ggml_context* segment_graph_ctx = nullptr;
             ggml_cgraph* segment_graph      = sd::ggml_graph_cut::build_segment_graph(gf, segment, &segment_graph_ctx);
             const bool keep_segment_params  = segment.residency == sd::ggml_graph_cut::SegmentResidency::RESIDENT;
@@ -2923,6 +3255,8 @@ protected:
                                                    &future_cut_names);
             ggml_free(segment_graph_ctx);
             if (!segment_output.has_value()) {
+                // Nothing will consume the read-ahead of the next segments.
+                cancel_graph_cut_prefetch();
                 free_cache_ctx_and_buffer();
                 free_compute_buffer();
                 free_compute_ctx();
@@ -3004,6 +3338,7 @@ public:
     }
 
     void free_compute_buffer() {
+        drop_reused_graph();
         if (compute_allocr != nullptr) {
             ggml_gallocr_free(compute_allocr);
             compute_allocr = nullptr;
@@ -3140,6 +3475,52 @@ public:
                                 nullptr);
     }
 
+    // Fast path for callers that run one graph many times with the same
+    // shapes, e.g. tiled VAE and upscaler passes. The first call builds and
+    // allocates the graph; later calls with the same key skip the rebuild and
+    // only upload the inputs again from the host buffers the graph was built
+    // with, so the caller must keep those buffers alive and in place and put
+    // anything that changes them (data pointer, shape) into key. Falls back to
+    // compute() when the graph can not be kept as is.
+    template <typename T>
+    std::optional<sd::Tensor<T>> compute_reused(get_graph_cb_t get_graph,
+                                                int n_threads,
+                                                const std::vector<int64_t>& key) {
+        if (is_multi_device() ||
+            can_attempt_graph_cut_segmented_compute() ||
+            sd_get_matmul_stats_filter() != nullptr) {
+            drop_reused_graph();
+            return compute<T>(get_graph, n_threads, false, false, false);
+        }
+        if (reused_graph_ == nullptr || key != reused_graph_key_) {
+            ggml_cgraph* gf = nullptr;
+            if (!prepare_compute_graph(get_graph, &gf)) {
+                return std::nullopt;
+            }
+            GGML_ASSERT(gf != nullptr);
+            rebuild_params_tensor_set();
+            if (!assign_graph_cut_layer_split_backends(gf)) {
+                free_compute_ctx();
+                return std::nullopt;
+            }
+            if (!debug_tensors.empty() || !cache_tensor_map.empty()) {
+                return execute_graph<T>(gf, n_threads, false, false, false);
+            }
+            reused_graph_     = gf;
+            reused_graph_key_ = key;
+        }
+        auto output = execute_graph<T>(reused_graph_, n_threads, false, false, true);
+        if (!output.has_value()) {
+            drop_reused_graph();
+        }
+        return output;
+    }
+
+    void drop_reused_graph() {
+        reused_graph_ = nullptr;
+        reused_graph_key_.clear();
+    }
+
     void set_flash_attention_enabled(bool enabled) {
         flash_attn_enabled = enabled;
     }
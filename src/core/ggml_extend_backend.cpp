@@ -6,9 +6,11 @@
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_set>
 #include <vector>
 
 #include "core/util.h"
+#include "ggml-cpu.h"
 #include "ggml/src/ggml-impl.h"
 #include "stable-diffusion.h"
 
@@ -430,6 +432,51 @@ ggml_backend_t sd_backend_cpu_init() {
     return ggml_backend_init_by_type(GGML_BACKEND_DEVICE_TYPE_CPU, nullptr);
 }
 
+bool sd_backend_cpu_numa_init(sd_numa_mode_t mode) {
+    static std::mutex numa_mutex;
+    static bool numa_initialized = false;
+
+    ggml_numa_strategy strategy = GGML_NUMA_STRATEGY_DISABLED;
+    switch (mode) {
+        case SD_NUMA_DISTRIBUTE:
+            strategy = GGML_NUMA_STRATEGY_DISTRIBUTE;
+            break;
+        case SD_NUMA_ISOLATE:
+            strategy = GGML_NUMA_STRATEGY_ISOLATE;
+            break;
+        case SD_NUMA_NUMACTL:
+            strategy = GGML_NUMA_STRATEGY_NUMACTL;
+            break;
+        default:
+            return true;
+    }
+
+    // ggml keeps the NUMA state process wide and only honours the first call.
+    std::lock_guard<std::mutex> lock(numa_mutex);
+    if (numa_initialized) {
+        return true;
+    }
+    ggml_backend_load_all_once();
+    ggml_backend_dev_t dev = ggml_backend_dev_by_type(GGML_BACKEND_DEVICE_TYPE_CPU);
+    if (dev == nullptr) {
+        return false;
+    }
+    auto reg          = ggml_backend_dev_backend_reg(dev);
+    auto numa_init_fn = (decltype(ggml_numa_init)*)ggml_backend_reg_get_proc_address(reg, "ggml_backend_cpu_numa_init");
+    if (numa_init_fn == nullptr) {
+        LOG_WARN("CPU backend does not support NUMA initialization");
+        return false;
+    }
+    numa_init_fn(strategy);
+    numa_initialized = true;
+
+    auto is_numa_fn = (decltype(ggml_is_numa)*)ggml_backend_reg_get_proc_address(reg, "ggml_backend_cpu_is_numa");
+    if (is_numa_fn != nullptr && !is_numa_fn()) {
+        LOG_INFO("NUMA mode '%s' requested, but the system has a single NUMA node", sd_numa_mode_name(mode));
+    }
+    return true;
+}
+
 bool sd_backend_cpu_set_n_threads(ggml_backend_t backend, int n_threads) {
     if (backend == nullptr) {
         return false;
@@ -463,6 +510,98 @@ static ggml_cgraph sd_ggml_graph_view(ggml_cgraph* cgraph0, int i0, int i1) {
     return cgraph;
 }
 
+ggml_cgraph* sd_graph_with_matmul_input_stats(ggml_cgraph* gf,
+                                              sd_matmul_stats_filter_t filter,
+                                              ggml_context** ctx_out,
+                                              std::vector<SDMatmulStat>* stats) {
+    GGML_ASSERT(ctx_out != nullptr && stats != nullptr);
+    *ctx_out = nullptr;
+    stats->clear();
+    if (gf == nullptr || filter == nullptr) {
+        return gf;
+    }
+
+    std::unordered_set<ggml_tensor*> targets;
+    for (int i = 0; i < gf->n_nodes; ++i) {
+        ggml_tensor* node = gf->nodes[i];
+        if (node->op == GGML_OP_MUL_MAT &&
+            node->src[1] != nullptr &&
+            node->src[1]->type == GGML_TYPE_F32 &&
+            filter(node)) {
+            targets.insert(node);
+        }
+    }
+    if (targets.empty()) {
+        return gf;
+    }
+
+    // cont(src1), sqr, reshape, transpose, cont, sum_rows
+    static constexpr size_t NODES_PER_STAT = 6;
+    const size_t n_extra    = targets.size() * NODES_PER_STAT;
+    const size_t graph_size = static_cast<size_t>(gf->n_nodes + gf->n_leafs) + n_extra;
+    ggml_init_params params = {
+        /*.mem_size   =*/ggml_tensor_overhead() * n_extra + ggml_graph_overhead_custom(graph_size, false) + 1024,
+        /*.mem_buffer =*/nullptr,
+        /*.no_alloc   =*/true,
+    };
+    ggml_context* ctx = ggml_init(params);
+    if (ctx == nullptr) {
+        return gf;
+    }
+    ggml_cgraph* out = ggml_new_graph_custom(ctx, graph_size, false);
+    for (int i = 0; i < gf->n_leafs; ++i) {
+        out->leafs[out->n_leafs++] = gf->leafs[i];
+    }
+
+    // Each reduction directly follows its MUL_MAT, so src1 is read while it
+    // is still live and the allocator frees it at its usual point instead of
+    // keeping every matmul input until the end of the graph.
+    stats->reserve(targets.size());
+    for (int i = 0; i < gf->n_nodes; ++i) {
+        ggml_tensor* mul_mat = gf->nodes[i];
+        ggml_graph_add_node(out, mul_mat);
+        if (targets.count(mul_mat) == 0) {
+            continue;
+        }
+        ggml_tensor* x = mul_mat->src[1];
+        if (!ggml_is_contiguous(x)) {
+            x = ggml_cont(ctx, x);
+            ggml_graph_add_node(out, x);
+        }
+        ggml_tensor* sq = ggml_sqr(ctx, x);
+        ggml_graph_add_node(out, sq);
+        sq = ggml_reshape_2d(ctx, sq, x->ne[0], ggml_nrows(x));
+        ggml_graph_add_node(out, sq);
+        ggml_tensor* sq_t = ggml_transpose(ctx, sq);
+        ggml_graph_add_node(out, sq_t);
+        sq_t = ggml_cont(ctx, sq_t);
+        ggml_graph_add_node(out, sq_t);
+        ggml_tensor* col_sums = ggml_sum_rows(ctx, sq_t);
+        ggml_set_output(col_sums);
+        ggml_graph_add_node(out, col_sums);
+
+        SDMatmulStat stat;
+        stat.mul_mat  = mul_mat;
+        stat.col_sums = col_sums;
+        stat.n_rows   = ggml_nrows(x);
+        stats->push_back(stat);
+    }
+    *ctx_out = ctx;
+    return out;
+}
+
+void sd_read_matmul_input_stats(const std::vector<SDMatmulStat>& stats, sd_matmul_stats_sink_t sink) {
+    if (sink == nullptr) {
+        return;
+    }
+    std::vector<float> col_sums;
+    for (const SDMatmulStat& stat : stats) {
+        col_sums.resize(static_cast<size_t>(ggml_nelements(stat.col_sums)));
+        ggml_backend_tensor_get(stat.col_sums, col_sums.data(), 0, ggml_nbytes(stat.col_sums));
+        sink(stat.mul_mat, col_sums.data(), static_cast<int64_t>(col_sums.size()), stat.n_rows);
+    }
+}
+
 ggml_status sd_backend_graph_compute_with_eval_callback(ggml_backend_t backend,
                                                         ggml_cgraph* gf,
                                                         sd_graph_eval_callback_t callback_eval,
@@ -593,7 +732,7 @@ static ggml_backend_t sd_get_default_backend() {
     return backend;
 }
 
-static bool sd_parse_backend_assignment(const std::string& spec, SDBackendAssignment* assignment, std::string* error) {
+bool sd_parse_backend_assignment(const std::string& spec, SDBackendAssignment* assignment, std::string* error) {
     if (assignment == nullptr) {
         return false;
     }
@@ -717,6 +856,18 @@ std::vector<ggml_backend_t> SDBackendManager::runtime_backends(SDBackendModule m
     return backends;
 }
 
+SDBackendHandle SDBackendManager::create_private_runtime_backend(SDBackendModule module) {
+    ggml_backend_t backend = runtime_backend(module);
+    if (backend == nullptr) {
+        return nullptr;
+    }
+    ggml_backend_dev_t dev = ggml_backend_get_device(backend);
+    if (dev == nullptr) {
+        return nullptr;
+    }
+    return SDBackendHandle(ggml_backend_dev_init(dev, nullptr));
+}
+
 ggml_backend_t SDBackendManager::params_backend(SDBackendModule module) {
     std::string name = params_assignment_.get(module);
     if (name.empty()) {
@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "core/util.h"
 #include "ggml-backend.h"
 #include "ggml.h"
 #include "stable-diffusion.h"
@@ -68,6 +69,10 @@ public:
     ggml_backend_t params_backend(SDBackendModule module);
 
     std::vector<ggml_backend_t> runtime_backends(SDBackendModule module);
+    // New instance on the device of runtime_backend(module), owned by the
+    // caller. A runner on it can compute while runners on the cached
+    // instance do.
+    SDBackendHandle create_private_runtime_backend(SDBackendModule module);
 
     SDSplitMode split_mode(SDBackendModule module) const;
     ggml_backend_buffer_type_t split_buffer_type(ggml_backend_t backend,
@@ -84,10 +89,28 @@ private:
     ggml_backend_t init_cached_backend(const std::string& name);
 };
 
+// Parses "value" / "module=value,..." specs as used by --backend and friends.
+bool sd_parse_backend_assignment(const std::string& spec, SDBackendAssignment* assignment, std::string* error);
 bool sd_backend_is(ggml_backend_t backend, const std::string& name);
 bool sd_backend_is_cpu(ggml_backend_t backend);
 ggml_backend_t sd_backend_cpu_init();
+// Applies a NUMA strategy to the CPU backend thread pool. Process wide, only
+// the first call takes effect.
+bool sd_backend_cpu_numa_init(sd_numa_mode_t mode);
 bool sd_backend_cpu_set_n_threads(ggml_backend_t backend_cpu, int n_threads);
+struct SDMatmulStat {
+    ggml_tensor* mul_mat  = nullptr;
+    ggml_tensor* col_sums = nullptr;
+    int64_t n_rows        = 0;
+};
+// Returns a copy of gf extended with a per-column sum of squares of src1 for
+// every MUL_MAT accepted by filter, allocated in *ctx_out (free with
+// ggml_free after the compute), or gf itself if no node was accepted.
+ggml_cgraph* sd_graph_with_matmul_input_stats(ggml_cgraph* gf,
+                                              sd_matmul_stats_filter_t filter,
+                                              ggml_context** ctx_out,
+                                              std::vector<SDMatmulStat>* stats);
+void sd_read_matmul_input_stats(const std::vector<SDMatmulStat>& stats, sd_matmul_stats_sink_t sink);
 ggml_status sd_backend_graph_compute_with_eval_callback(ggml_backend_t backend,
                                                         ggml_cgraph* gf,
                                                         sd_graph_eval_callback_t callback_eval,
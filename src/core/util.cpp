@@ -85,6 +85,42 @@ int round_up_to(int value, int base) {
     }
 }
 
+MmapFlags get_mmap_flags() {
+    MmapFlags result          = {};
+    const char* SD_MMAP_FLAGS = std::getenv("SD_MMAP_FLAGS");
+    if (SD_MMAP_FLAGS && *SD_MMAP_FLAGS) {
+        std::stringstream ss(SD_MMAP_FLAGS);
+        std::string token;
+        while (std::getline(ss, token, ',')) {
+            std::string ntoken = trim(token);
+            std::transform(ntoken.begin(), ntoken.end(), ntoken.begin(), ::tolower);
+            if (ntoken == "sequential") {
+                result.sequential = true;
+            } else if (ntoken == "populate") {
+                result.populate = true;
+            } else if (ntoken == "willneed") {
+                result.willneed = true;
+            } else if (ntoken == "dontneed") {
+                result.dontneed = true;
+            } else if (ntoken == "prefetch") {
+                result.prefetch = true;
+            } else if (ntoken == "hugepage") {
+                result.hugepage = true;
+            } else if (ntoken == "cold") {
+                result.cold = true;
+            } else if (starts_with(ntoken, "ram_cap=")) {
+                float ram_cap_gib = 0.f;
+                if (parse_strict_float(ntoken.substr(8), ram_cap_gib) && ram_cap_gib > 0.f) {
+                    result.ram_cap_bytes = static_cast<size_t>(ram_cap_gib * 1024.0 * 1024.0 * 1024.0);
+                } else {
+                    LOG_WARN("ignoring invalid SD_MMAP_FLAGS token '%s'", ntoken.c_str());
+                }
+            }
+        }
+    }
+    return result;
+}
+
 #ifdef _WIN32  // code for windows
 #define NOMINMAX
 #include <windows.h>
@@ -162,12 +198,40 @@ std::unique_ptr<MmapWrapper> MmapWrapper::create(const std::string& filename, bo
     return std::make_unique<MmapWrapperImpl>(mapped_data, file_size, file_handle, mapping_handle);
 }
 
+void mmap_advise_willneed(const void* addr, size_t size) {
+    (void)addr;
+    (void)size;
+}
+
+void mmap_advise_cold(const void* addr, size_t size) {
+    (void)addr;
+    (void)size;
+}
+
+int64_t sd_get_major_page_faults() {
+    return -1;
+}
+
+size_t sd_get_resident_memory_bytes() {
+    return 0;
+}
+
+bool sd_numa_bind_memory(void* addr, size_t size, sd_numa_mode_t mode) {
+    (void)addr;
+    (void)size;
+    return mode == SD_NUMA_DISABLED || mode == SD_NUMA_NUMACTL;
+}
+
 #else  // Unix
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 bool file_exists(const std::string& filename) {
     struct stat buffer;
@@ -179,36 +243,6 @@ bool is_directory(const std::string& path) {
     return (stat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode));
 }
 
-struct MmapFlags {
-    bool sequential;
-    bool populate;
-    bool willneed;
-    bool dontneed;
-};
-
-static MmapFlags get_mmap_flags() {
-    MmapFlags result          = {};
-    const char* SD_MMAP_FLAGS = std::getenv("SD_MMAP_FLAGS");
-    if (SD_MMAP_FLAGS && *SD_MMAP_FLAGS) {
-        std::stringstream ss(SD_MMAP_FLAGS);
-        std::string token;
-        while (std::getline(ss, token, ',')) {
-            std::string ntoken = trim(token);
-            std::transform(ntoken.begin(), ntoken.end(), ntoken.begin(), ::tolower);
-            if (ntoken == "sequential") {
-                result.sequential = true;
-            } else if (ntoken == "populate") {
-                result.populate = true;
-            } else if (ntoken == "willneed") {
-                result.willneed = true;
-            } else if (ntoken == "dontneed") {
-                result.dontneed = true;
-            }
-        }
-    }
-    return result;
-}
-
 class MmapWrapperImpl : public MmapWrapper {
 public:
     MmapWrapperImpl(void* data, size_t size, int fd)
@@ -286,11 +320,155 @@ std::unique_ptr<MmapWrapper> MmapWrapper::create(const std::string& filename, bo
     if (cfg_flags.willneed) {
         posix_madvise(mapped_data, file_size, POSIX_MADV_WILLNEED);
     }
+#ifdef MADV_HUGEPAGE
+    // Only effective for file mappings on kernels with read-only THP for
+    // page cache; otherwise madvise fails harmlessly.
+    if (cfg_flags.hugepage) {
+        madvise(mapped_data, file_size, MADV_HUGEPAGE);
+    }
+#endif
 #endif
 
     return std::make_unique<MmapWrapperImpl>(mapped_data, file_size, file_descriptor);
 }
 
+// madvise() wants a page aligned start address.
+static bool page_align_range(const void* addr, size_t size, void** aligned_addr, size_t* aligned_size) {
+    static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    if (addr == nullptr || size == 0 || page_size == 0) {
+        return false;
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page_size - 1);
+    uintptr_t end   = reinterpret_cast<uintptr_t>(addr) + size;
+    *aligned_addr   = reinterpret_cast<void*>(begin);
+    *aligned_size   = static_cast<size_t>(end - begin);
+    return true;
+}
+
+void mmap_advise_willneed(const void* addr, size_t size) {
+    void* aligned_addr  = nullptr;
+    size_t aligned_size = 0;
+    if (page_align_range(addr, size, &aligned_addr, &aligned_size)) {
+        posix_madvise(aligned_addr, aligned_size, POSIX_MADV_WILLNEED);
+    }
+}
+
+void mmap_advise_cold(const void* addr, size_t size) {
+#if defined(__linux__) && defined(MADV_COLD)
+    void* aligned_addr  = nullptr;
+    size_t aligned_size = 0;
+    if (page_align_range(addr, size, &aligned_addr, &aligned_size)) {
+        madvise(aligned_addr, aligned_size, MADV_COLD);
+    }
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+int64_t sd_get_major_page_faults() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(usage.ru_majflt);
+}
+
+#ifdef __linux__
+// Parses a sysfs cpulist/nodelist such as "0-1,4" into a bit mask.
+static uint64_t parse_numa_node_list(const std::string& list) {
+    uint64_t mask = 0;
+    for (const std::string& part : split_string(trim(list), ',')) {
+        if (part.empty()) {
+            continue;
+        }
+        int first      = 0;
+        int last       = 0;
+        size_t dash    = part.find('-');
+        bool parsed_ok = dash == std::string::npos
+                             ? parse_strict_int(part, first) && parse_strict_int(part, last)
+                             : parse_strict_int(part.substr(0, dash), first) && parse_strict_int(part.substr(dash + 1), last);
+        if (!parsed_ok) {
+            continue;
+        }
+        for (int node = std::max(first, 0); node <= last && node < 64; ++node) {
+            mask |= uint64_t(1) << node;
+        }
+    }
+    return mask;
+}
+#endif
+
+bool sd_numa_bind_memory(void* addr, size_t size, sd_numa_mode_t mode) {
+    if (mode != SD_NUMA_DISTRIBUTE && mode != SD_NUMA_ISOLATE) {
+        return true;
+    }
+#if defined(__linux__) && defined(SYS_mbind)
+    // Values from <linux/mempolicy.h>, which is not always installed.
+    constexpr int SD_MPOL_BIND         = 2;
+    constexpr int SD_MPOL_INTERLEAVE   = 3;
+    constexpr unsigned SD_MPOL_MF_MOVE = 1u << 1;
+
+    uint64_t node_mask = 0;
+    if (mode == SD_NUMA_DISTRIBUTE) {
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (!std::getline(online, list)) {
+            return false;
+        }
+        node_mask = parse_numa_node_list(list);
+    } else {
+        unsigned cpu  = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= 64) {
+            return false;
+        }
+        node_mask = uint64_t(1) << node;
+    }
+    if (node_mask == 0) {
+        return false;
+    }
+    if (mode == SD_NUMA_DISTRIBUTE && (node_mask & (node_mask - 1)) == 0) {
+        return true;  // single node, nothing to interleave
+    }
+
+    // mbind() works on whole pages; leave partial pages at the edges alone.
+    const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin           = (reinterpret_cast<uintptr_t>(addr) + page_size - 1) & ~(page_size - 1);
+    uintptr_t end             = (reinterpret_cast<uintptr_t>(addr) + size) & ~(page_size - 1);
+    if (addr == nullptr || end <= begin) {
+        return true;
+    }
+    int policy = mode == SD_NUMA_DISTRIBUTE ? SD_MPOL_INTERLEAVE : SD_MPOL_BIND;
+    // maxnode counts one bit past the mask, same as libnuma passes it.
+    unsigned long max_node = sizeof(node_mask) * 8 + 1;
+    long rc                = syscall(SYS_mbind,
+                                     reinterpret_cast<void*>(begin),
+                                     static_cast<unsigned long>(end - begin),
+                                     policy,
+                                     &node_mask,
+                                     max_node,
+                                     SD_MPOL_MF_MOVE);
+    return rc == 0;
+#else
+    (void)addr;
+    (void)size;
+    return false;
+#endif
+}
+
+size_t sd_get_resident_memory_bytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages    = 0;
+    size_t resident_pages = 0;
+    if (statm >> total_pages >> resident_pages) {
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
 #endif
 
 bool MmapWrapper::copy_data(void* buf, size_t n, size_t offset) const {
@@ -348,10 +526,15 @@ preview_t sd_preview_mode            = PREVIEW_NONE;
 int sd_preview_interval              = 1;
 bool sd_preview_denoised             = true;
 bool sd_preview_noisy                = false;
+int sd_preview_decode_threads        = 0;
+int sd_preview_downscale             = 1;
 
 static sd_graph_eval_callback_t sd_backend_eval_cb = nullptr;
 static void* sd_backend_eval_cb_data               = nullptr;
 
+static sd_matmul_stats_filter_t sd_matmul_stats_filter = nullptr;
+static sd_matmul_stats_sink_t sd_matmul_stats_sink     = nullptr;
+
 std::u32string utf8_to_utf32(const std::string& utf8_str) {
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
     return converter.from_bytes(utf8_str);
@@ -635,6 +818,11 @@ void sd_set_preview_callback(sd_preview_cb_t cb, preview_t mode, int interval, b
     sd_preview_noisy    = noisy;
 }
 
+void sd_set_preview_decode_options(int n_threads, int downscale) {
+    sd_preview_decode_threads = n_threads;
+    sd_preview_downscale      = std::max(1, downscale);
+}
+
 void sd_set_backend_eval_callback(sd_graph_eval_callback_t cb, void* data) {
     sd_backend_eval_cb      = cb;
     sd_backend_eval_cb_data = data;
@@ -659,6 +847,12 @@ bool sd_should_preview_denoised() {
 bool sd_should_preview_noisy() {
     return sd_preview_noisy;
 }
+int sd_get_preview_decode_threads() {
+    return sd_preview_decode_threads;
+}
+int sd_get_preview_downscale() {
+    return sd_preview_downscale;
+}
 
 sd_graph_eval_callback_t sd_get_backend_eval_callback() {
     return sd_backend_eval_cb;
@@ -668,6 +862,19 @@ void* sd_get_backend_eval_callback_data() {
     return sd_backend_eval_cb_data;
 }
 
+void sd_set_matmul_stats_callbacks(sd_matmul_stats_filter_t filter, sd_matmul_stats_sink_t sink) {
+    sd_matmul_stats_filter = filter;
+    sd_matmul_stats_sink   = sink;
+}
+
+sd_matmul_stats_filter_t sd_get_matmul_stats_filter() {
+    return sd_matmul_stats_filter;
+}
+
+sd_matmul_stats_sink_t sd_get_matmul_stats_sink() {
+    return sd_matmul_stats_sink;
+}
+
 sd_progress_cb_t sd_get_progress_callback() {
     return sd_progress_cb;
 }
@@ -692,6 +899,21 @@ sd_image_t tensor_to_sd_image(const sd::Tensor<float>& tensor, int frame_index)
     };
 }
 
+void sd_image_set_rows(sd_image_t* image, const float* planes, int64_t plane_stride, int y0, int n_rows) {
+    GGML_ASSERT(image != nullptr && image->data != nullptr && planes != nullptr);
+    GGML_ASSERT(y0 >= 0 && n_rows >= 0 && static_cast<uint32_t>(y0 + n_rows) <= image->height);
+    const size_t width   = image->width;
+    const size_t channel = image->channel;
+    const size_t pixels  = width * static_cast<size_t>(n_rows);
+    uint8_t* dst         = image->data + static_cast<size_t>(y0) * width * channel;
+    for (size_t c = 0; c < channel; ++c) {
+        const float* src = planes + static_cast<int64_t>(c) * plane_stride;
+        for (size_t i = 0; i < pixels; ++i) {
+            dst[i * channel + c] = preprocessing_float_to_u8(src[i]);
+        }
+    }
+}
+
 sd::Tensor<float> sd_image_to_tensor(sd_image_t image,
                                      int target_width,
                                      int target_height,
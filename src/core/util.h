@@ -33,6 +33,10 @@ std::u32string unicode_value_to_utf32(int unicode_value);
 // std::string sd_basename(const std::string& path);
 
 sd_image_t tensor_to_sd_image(const sd::Tensor<float>& tensor, int frame_index = 0);
+// Converts n_rows rows of planar [0, 1] floats (one plane per channel, planes
+// plane_stride floats apart, rows image->width floats long) into rows
+// [y0, y0 + n_rows) of image.
+void sd_image_set_rows(sd_image_t* image, const float* planes, int64_t plane_stride, int y0, int n_rows);
 
 sd::Tensor<float> sd_image_to_tensor(sd_image_t image,
                                      int target_width  = -1,
@@ -64,6 +68,35 @@ protected:
     size_t size_ = 0;
 };
 
+// Parsed SD_MMAP_FLAGS, a comma separated list of: sequential, populate,
+// willneed, dontneed, prefetch, hugepage, cold, ram_cap=<GiB>.
+struct MmapFlags {
+    bool sequential      = false;
+    bool populate        = false;
+    bool willneed        = false;
+    bool dontneed        = false;
+    bool prefetch        = false;  // WILLNEED mmapped params in graph order before each compute
+    bool hugepage        = false;  // MADV_HUGEPAGE on the whole mapping
+    bool cold            = false;  // MADV_COLD mmapped params once a compute is done with them
+    size_t ram_cap_bytes = 0;      // prefetch budget / cold threshold, 0 = unlimited
+};
+
+MmapFlags get_mmap_flags();
+
+// Paging hints for a range of a file mapping; no-ops where unsupported.
+void mmap_advise_willneed(const void* addr, size_t size);
+void mmap_advise_cold(const void* addr, size_t size);
+
+// Process-wide major page fault counter, -1 if unavailable.
+int64_t sd_get_major_page_faults();
+// Resident set size of the process, 0 if unavailable.
+size_t sd_get_resident_memory_bytes();
+
+// Sets the NUMA placement of a not yet touched host allocation: interleaved
+// over all nodes for SD_NUMA_DISTRIBUTE, bound to the calling thread's node
+// for SD_NUMA_ISOLATE. Returns false if the policy could not be applied.
+bool sd_numa_bind_memory(void* addr, size_t size, sd_numa_mode_t mode);
+
 std::string path_join(const std::string& p1, const std::string& p2);
 std::vector<std::string> split_string(const std::string& str, char delimiter);
 
@@ -97,10 +130,24 @@ preview_t sd_get_preview_mode();
 int sd_get_preview_interval();
 bool sd_should_preview_denoised();
 bool sd_should_preview_noisy();
+int sd_get_preview_decode_threads();
+int sd_get_preview_downscale();
 
 sd_graph_eval_callback_t sd_get_backend_eval_callback();
 void* sd_get_backend_eval_callback_data();
 
+// In-graph matmul input statistics (used for imatrix collection): when set,
+// every MUL_MAT node accepted by the filter gets a per-column sum of squares
+// of its src1 computed inside the graph, handed to the sink after compute.
+typedef bool (*sd_matmul_stats_filter_t)(const struct ggml_tensor* mul_mat);
+typedef void (*sd_matmul_stats_sink_t)(const struct ggml_tensor* mul_mat,
+                                       const float* col_sums,
+                                       int64_t n_cols,
+                                       int64_t n_rows);
+void sd_set_matmul_stats_callbacks(sd_matmul_stats_filter_t filter, sd_matmul_stats_sink_t sink);
+sd_matmul_stats_filter_t sd_get_matmul_stats_filter();
+sd_matmul_stats_sink_t sd_get_matmul_stats_sink();
+
 // test if the backend is a specific one, e.g. "CUDA", "ROCm", "Vulkan" etc.
 bool sd_backend_is(ggml_backend_t backend, const std::string& name);
 
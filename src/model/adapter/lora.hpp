@@ -14,6 +14,8 @@ struct LoraModel : public GGMLRunner {
     std::unordered_map<std::string, ggml_tensor*> lora_tensors;
     std::map<ggml_tensor*, ggml_tensor*> original_tensor_to_final_tensor;
     std::set<std::string> applied_lora_tensors;
+    // Model tensors the last apply() changed.
+    std::set<std::string> patched_model_tensors;
     std::string file_path;
     std::shared_ptr<ModelManager> model_manager;
     ggml_backend_t params_backend = nullptr;
@@ -133,6 +135,7 @@ struct LoraModel : public GGMLRunner {
         lora_tensors.clear();
         original_tensor_to_final_tensor.clear();
         applied_lora_tensors.clear();
+        patched_model_tensors.clear();
         applied             = false;
         tensor_preprocessed = false;
     }
@@ -739,6 +742,51 @@ struct LoraModel : public GGMLRunner {
                     lx = ggml_ext_linear(ctx, lx, lora_mid, nullptr, forward_params.linear.force_prec_f32, forward_params.linear.scale);
                 }
                 lx = ggml_ext_linear(ctx, lx, lora_up, nullptr, forward_params.linear.force_prec_f32, forward_params.linear.scale);
+            } else if (lora_mid) {  // OP_CONV2D, tucker decomposed (LoCon)
+                // lora_down and lora_up are 1x1, lora_mid carries the spatial
+                // kernel, so the layer's stride/padding/dilation belong to it.
+                lx = ggml_ext_conv_2d(ctx,
+                                      x,
+                                      lora_down,
+                                      nullptr,
+                                      1,
+                                      1,
+                                      0,
+                                      0,
+                                      1,
+                                      1,
+                                      forward_params.conv2d.direct,
+                                      forward_params.conv2d.circular_x,
+                                      forward_params.conv2d.circular_y,
+                                      forward_params.conv2d.scale);
+                lx = ggml_ext_conv_2d(ctx,
+                                      lx,
+                                      lora_mid,
+                                      nullptr,
+                                      forward_params.conv2d.s0,
+                                      forward_params.conv2d.s1,
+                                      forward_params.conv2d.p0,
+                                      forward_params.conv2d.p1,
+                                      forward_params.conv2d.d0,
+                                      forward_params.conv2d.d1,
+                                      forward_params.conv2d.direct,
+                                      forward_params.conv2d.circular_x,
+                                      forward_params.conv2d.circular_y,
+                                      forward_params.conv2d.scale);
+                lx = ggml_ext_conv_2d(ctx,
+                                      lx,
+                                      lora_up,
+                                      nullptr,
+                                      1,
+                                      1,
+                                      0,
+                                      0,
+                                      1,
+                                      1,
+                                      forward_params.conv2d.direct,
+                                      forward_params.conv2d.circular_x,
+                                      forward_params.conv2d.circular_y,
+                                      forward_params.conv2d.scale);
             } else {  // OP_CONV2D
                 lx = ggml_ext_conv_2d(ctx,
                                       x,
@@ -754,22 +802,6 @@ struct LoraModel : public GGMLRunner {
                                       forward_params.conv2d.circular_x,
                                       forward_params.conv2d.circular_y,
                                       forward_params.conv2d.scale);
-                if (lora_mid) {
-                    lx = ggml_ext_conv_2d(ctx,
-                                          lx,
-                                          lora_mid,
-                                          nullptr,
-                                          1,
-                                          1,
-                                          0,
-                                          0,
-                                          1,
-                                          1,
-                                          forward_params.conv2d.direct,
-                                          forward_params.conv2d.circular_x,
-                                          forward_params.conv2d.circular_y,
-                                          forward_params.conv2d.scale);
-                }
                 lx = ggml_ext_conv_2d(ctx,
                                       lx,
                                       lora_up,
@@ -809,6 +841,7 @@ struct LoraModel : public GGMLRunner {
 
         original_tensor_to_final_tensor.clear();
         applied_lora_tensors.clear();
+        patched_model_tensors.clear();
 
         for (auto it : model_tensors) {
             std::string model_tensor_name = it.first;
@@ -819,6 +852,7 @@ struct LoraModel : public GGMLRunner {
             if (diff == nullptr) {
                 continue;
             }
+            patched_model_tensors.insert(model_tensor_name);
 
             ggml_tensor* original_tensor = model_tensor;
             if (!sd_backend_is_cpu(runtime_backend) && ggml_backend_buffer_is_host(original_tensor->buffer)) {
@@ -929,6 +963,9 @@ public:
                                    ggml_tensor* b,
                                    const std::string& prefix,
                                    WeightAdapter::ForwardParams forward_params) override {
+        // LoRA/LoCon and LoKr run as low-rank side branches (get_out_diff), so
+        // the base weight stays untouched, quantized or not; only full-rank
+        // diffs and LoHa are merged into it.
         w = patch_weight(ctx, backend, w, prefix + "weight", false);
         if (b) {
             b = patch_weight(ctx, backend, b, prefix + "bias", false);
@@ -268,6 +268,16 @@ struct ESRGAN : public GGMLRunner {
         auto result    = restore_trailing_singleton_dims(GGMLRunner::compute<float>(get_graph, n_threads, false, false, false), x.dim());
         return result;
     }
+
+    // Same as compute(), but keeps the graph for the next tile of the same
+    // shape read from the same buffer (see process_tiles_2d).
+    sd::Tensor<float> compute_tile(const int n_threads,
+                                   const sd::Tensor<float>& x) {
+        auto get_graph           = [&]() -> ggml_cgraph* { return build_graph(x); };
+        std::vector<int64_t> key = x.shape();
+        key.push_back(reinterpret_cast<intptr_t>(x.data()));
+        return restore_trailing_singleton_dims(GGMLRunner::compute_reused<float>(get_graph, n_threads, key), x.dim());
+    }
 };
 
 #endif  // __SD_MODEL_UPSCALER_ESRGAN_HPP__
@@ -660,9 +660,10 @@ public:
 };
 
 struct AutoEncoderKL : public VAE {
-    float scale_factor = 1.f;
-    float shift_factor = 0.f;
-    bool decode_only   = true;
+    float scale_factor     = 1.f;
+    float shift_factor     = 0.f;
+    bool decode_only       = true;
+    bool use_video_decoder = false;
     AutoEncoderKLModel ae;
 
     AutoEncoderKL(ggml_backend_t backend,
@@ -672,7 +673,7 @@ struct AutoEncoderKL : public VAE {
                   bool use_video_decoder                              = false,
                   SDVersion version                                   = VERSION_SD1,
                   std::shared_ptr<RunnerWeightManager> weight_manager = nullptr)
-        : VAE(version, backend, prefix, weight_manager), decode_only(decode_only) {
+        : VAE(version, backend, prefix, weight_manager), decode_only(decode_only), use_video_decoder(use_video_decoder) {
         if (sd_version_is_sd1(version) || sd_version_is_sd2(version)) {
             scale_factor = 0.18215f;
             shift_factor = 0.f;
@@ -747,6 +748,25 @@ struct AutoEncoderKL : public VAE {
         return restore_trailing_singleton_dims(GGMLRunner::compute<float>(get_graph, n_threads, false, false, false), z.dim());
     }
 
+    sd::Tensor<float> _compute_tile(const int n_threads,
+                                    const sd::Tensor<float>& z,
+                                    bool decode_graph) override {
+        GGML_ASSERT(!decode_only || decode_graph);
+        auto get_graph = [&]() -> ggml_cgraph* {
+            return build_graph(z, decode_graph);
+        };
+        std::vector<int64_t> key = z.shape();
+        key.push_back(decode_graph);
+        key.push_back(reinterpret_cast<intptr_t>(z.data()));
+        return restore_trailing_singleton_dims(GGMLRunner::compute_reused<float>(get_graph, n_threads, key), z.dim());
+    }
+
+    // The video decoder folds frames into dim 3, so only the image decoder
+    // can take a batch of tiles.
+    bool supports_tile_batching() const override {
+        return !use_video_decoder;
+    }
+
     sd::Tensor<float> gaussian_latent_sample(const sd::Tensor<float>& moments, std::shared_ptr<RNG> rng) {
         // ldm.modules.distributions.distributions.DiagonalGaussianDistribution.sample
         auto chunks               = sd::ops::chunk(moments, 2, 2);
@@ -1265,7 +1265,7 @@ struct LTXVideoVAE : public VAE {
                 temporal_tile_frames = std::max(1, parsed);
             } else if (key == "temporal_tile_overlap") {
                 temporal_tile_overlap = std::max(0, parsed);
-            } else {
+            } else if (key != "tile_batch") {
                 LOG_WARN("ignoring unknown LTX VAE extra tiling arg '%s'", key.c_str());
             }
         }
@@ -1378,7 +1378,10 @@ struct LTXVideoVAE : public VAE {
         free_cache_ctx_and_buffer();
         cache_tensor_map.clear();
 
+        // Chunks come out as whole, final frames, so with a frames callback
+        // they are handed on right away and only the last one is kept.
         sd::Tensor<float> output;
+        int64_t emitted_frames = 0;
         for (int64_t start = 0; start < total_frames - plan.overlap; start += plan.stride) {
             const int64_t end       = std::min<int64_t>(total_frames, start + plan.frames);
             const int chunk_overlap = end < total_frames ? plan.overlap : 0;
@@ -1403,6 +1406,16 @@ struct LTXVideoVAE : public VAE {
                 cache_tensor_map.clear();
                 return {};
             }
+            if (decoded_frames_cb) {
+                if (!emit_decoded_frames(chunk, emitted_frames)) {
+                    free_cache_ctx_and_buffer();
+                    cache_tensor_map.clear();
+                    return {};
+                }
+                emitted_frames += chunk.shape()[2];
+                output = std::move(chunk);
+                continue;
+            }
             output = output.empty() ? std::move(chunk) : sd::ops::concat(output, chunk, 2);
         }
 
@@ -6,14 +6,66 @@
 #include "model_manager.h"
 
 struct VAE : public GGMLRunner {
+public:
+    // Finished output frames [first_frame, first_frame + T) of a video decode,
+    // as [W, H, T, C(, N)] already scaled like decode() output. Returning false
+    // aborts the decode.
+    typedef std::function<bool(const sd::Tensor<float>& frames, int64_t first_frame)> decoded_frames_cb_t;
+
 protected:
     SDVersion version;
     std::string weight_prefix;
     bool scale_input                                      = true;
+    decoded_frames_cb_t decoded_frames_cb;
     virtual sd::Tensor<float> _compute(const int n_threads,
                                        const sd::Tensor<float>& z,
                                        bool decode_graph) = 0;
 
+    // One tile (or a batch of tiles stacked along dim 3) of tiled_compute().
+    // The input buffer stays in place between calls of the same shape, so
+    // runners can override this to reuse their graph across tiles.
+    virtual sd::Tensor<float> _compute_tile(const int n_threads,
+                                            const sd::Tensor<float>& z,
+                                            bool decode_graph) {
+        return _compute(n_threads, z, decode_graph);
+    }
+
+    // Whether the graph treats dim 3 of a 4D input as independent images, so
+    // tiled_compute() may stack several tiles into one compute.
+    virtual bool supports_tile_batching() const { return false; }
+
+    // "tile_batch=N" in extra_tiling_args: number of same-sized tiles to run
+    // per compute. Costs N times the compute buffer.
+    static int get_tile_batch_size(const sd_tiling_params_t& params) {
+        int tile_batch_size = 1;
+        for (const auto& [key, value] : parse_key_value_args(params.extra_tiling_args, "VAE extra tiling arg")) {
+            if (key != "tile_batch") {
+                continue;
+            }
+            int parsed = 0;
+            if (!parse_strict_int(value, parsed) || parsed < 1) {
+                LOG_WARN("ignoring invalid VAE extra tiling arg '%s=%s'", key.c_str(), value.c_str());
+                continue;
+            }
+            tile_batch_size = parsed;
+        }
+        return tile_batch_size;
+    }
+
+    // For decoders that produce whole frames in temporal order before the
+    // decode ends. Without a callback this is a no-op.
+    bool emit_decoded_frames(const sd::Tensor<float>& frames, int64_t first_frame) {
+        if (!decoded_frames_cb) {
+            return true;
+        }
+        if (!scale_input) {
+            return decoded_frames_cb(frames, first_frame);
+        }
+        sd::Tensor<float> scaled = frames;
+        scale_tensor_to_0_1(&scaled);
+        return decoded_frames_cb(scaled, first_frame);
+    }
+
     static inline void scale_tensor_to_minus1_1(sd::Tensor<float>* tensor) {
         GGML_ASSERT(tensor != nullptr);
         for (int64_t i = 0; i < tensor->numel(); ++i) {
@@ -41,9 +93,14 @@ protected:
                                     bool circular_y,
                                     bool decode_graph,
                                     const char* error_message,
-                                    bool silent = false) {
+                                    bool silent         = false,
+                                    int tile_batch_size = 1) {
+        if (tile_batch_size > 1 && !supports_tile_batching()) {
+            LOG_DEBUG("%s does not support batched tiles, processing them one by one", get_desc().c_str());
+            tile_batch_size = 1;
+        }
         auto on_processing = [&](const sd::Tensor<float>& input_tile) {
-            auto output_tile = _compute(n_threads, input_tile, decode_graph);
+            auto output_tile = _compute_tile(n_threads, input_tile, decode_graph);
             if (output_tile.empty()) {
                 LOG_ERROR("%s", error_message);
                 return sd::Tensor<float>();
@@ -60,7 +117,8 @@ protected:
                                   circular_x,
                                   circular_y,
                                   on_processing,
-                                  silent);
+                                  silent,
+                                  tile_batch_size);
     }
 
 public:
@@ -150,7 +208,9 @@ public:
                                    circular_x,
                                    circular_y,
                                    false,
-                                   "vae encode compute failed while processing a tile");
+                                   "vae encode compute failed while processing a tile",
+                                   false,
+                                   get_tile_batch_size(tiling_params));
         } else {
             output = _compute(n_threads, input, false);
         }
@@ -188,7 +248,11 @@ public:
             if (!silent) {
                 LOG_DEBUG("VAE Tile size: %dx%d", tile_size_x, tile_size_y);
             }
-            output = tiled_compute(
+            // Each spatial tile covers every frame, so no frame is finished
+            // before the last tile: keep the decoders from emitting tiles.
+            decoded_frames_cb_t frames_cb = std::move(decoded_frames_cb);
+            decoded_frames_cb             = nullptr;
+            output                        = tiled_compute(
                 input,
                 n_threads,
                 static_cast<int>(W),
@@ -201,7 +265,9 @@ public:
                 circular_y,
                 true,
                 "vae decode compute failed while processing a tile",
-                silent);
+                silent,
+                get_tile_batch_size(tiling_params));
+            decoded_frames_cb = std::move(frames_cb);
         } else {
             output = _compute(n_threads, input, true);
         }
@@ -220,6 +286,75 @@ public:
         return std::move(output);
     }
 
+    // Tiled image decode that never builds the full float output: finished
+    // rows, already in [0, 1], go to on_rows top to bottom (see
+    // process_tiles_2d_rows). Needs tiling enabled and circular_y off.
+    bool decode_rows(int n_threads,
+                     const sd::Tensor<float>& x,
+                     sd_tiling_params_t tiling_params,
+                     bool circular_x,
+                     const sd_tile_rows_cb_t& on_rows) {
+        GGML_ASSERT(tiling_params.enabled);
+        int64_t t0 = ggml_time_ms();
+        set_tiling_params(tiling_params);
+
+        const int scale_factor = get_scale_factor();
+        int64_t W              = x.shape()[0] * scale_factor;
+        int64_t H              = x.shape()[1] * scale_factor;
+        float tile_overlap;
+        int tile_size_x, tile_size_y;
+        get_tile_sizes(tile_size_x, tile_size_y, tile_overlap, tiling_params, x.shape()[0], x.shape()[1]);
+        LOG_DEBUG("VAE Tile size: %dx%d", tile_size_x, tile_size_y);
+
+        int tile_batch_size = supports_tile_batching() ? get_tile_batch_size(tiling_params) : 1;
+        auto on_processing  = [&](const sd::Tensor<float>& input_tile) {
+            auto output_tile = _compute_tile(n_threads, input_tile, true);
+            if (output_tile.empty()) {
+                LOG_ERROR("vae decode compute failed while processing a tile");
+            }
+            return output_tile;
+        };
+        sd_tile_rows_cb_t on_scaled_rows = [&](SDTileRows& rows) {
+            if (scale_input) {
+                for (int64_t plane = 0; plane < rows.plane_count; ++plane) {
+                    float* data = rows.data + plane * rows.width * rows.plane_rows;
+                    for (int64_t i = 0; i < static_cast<int64_t>(rows.width) * rows.n_rows; ++i) {
+                        float value = (data[i] + 1.0f) * 0.5f;
+                        data[i]     = std::max(0.0f, std::min(1.0f, value));
+                    }
+                }
+            }
+            return on_rows(rows);
+        };
+        bool ok = process_tiles_2d_rows(x,
+                                        static_cast<int>(W),
+                                        static_cast<int>(H),
+                                        scale_factor,
+                                        tile_size_x,
+                                        tile_size_y,
+                                        tile_overlap,
+                                        circular_x,
+                                        on_processing,
+                                        on_scaled_rows,
+                                        false,
+                                        tile_batch_size);
+        free_compute_buffer();
+
+        if (!ok) {
+            LOG_ERROR("vae decode compute failed");
+            return false;
+        }
+        int64_t t1 = ggml_time_ms();
+        LOG_DEBUG("computing vae decode graph completed, taking %.2fs", (t1 - t0) * 1.0f / 1000);
+        return true;
+    }
+
+    // See decoded_frames_cb_t. Decoders that stream frames return only the
+    // last chunk from decode() while a callback is set.
+    void set_decoded_frames_callback(decoded_frames_cb_t cb) {
+        decoded_frames_cb = std::move(cb);
+    }
+
     virtual sd::Tensor<float> vae_output_to_latents(const sd::Tensor<float>& vae_output, std::shared_ptr<RNG> rng) = 0;
     virtual sd::Tensor<float> diffusion_to_vae_latents(const sd::Tensor<float>& latents)                           = 0;
     virtual sd::Tensor<float> vae_to_diffusion_latents(const sd::Tensor<float>& latents)                           = 0;
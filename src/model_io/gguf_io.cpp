@@ -41,8 +41,12 @@ bool is_gguf_file(const std::string& file_path) {
 
 bool read_gguf_file(const std::string& file_path,
                     std::vector<TensorStorage>& tensor_storages,
-                    std::string* error) {
+                    std::string* error,
+                    std::map<std::string, std::string>* metadata) {
     tensor_storages.clear();
+    if (metadata != nullptr) {
+        metadata->clear();
+    }
 
     gguf_context* ctx_gguf_ = nullptr;
     ggml_context* ctx_meta_ = nullptr;
@@ -71,6 +75,15 @@ bool read_gguf_file(const std::string& file_path,
         return true;
     }
 
+    if (metadata != nullptr) {
+        int64_t n_kv = gguf_get_n_kv(ctx_gguf_);
+        for (int64_t i = 0; i < n_kv; i++) {
+            if (gguf_get_kv_type(ctx_gguf_, i) == GGUF_TYPE_STRING) {
+                metadata->emplace(gguf_get_key(ctx_gguf_, i), gguf_get_val_str(ctx_gguf_, i));
+            }
+        }
+    }
+
     int n_tensors = static_cast<int>(gguf_get_n_tensors(ctx_gguf_));
 
     size_t data_offset = gguf_get_data_offset(ctx_gguf_);
@@ -150,6 +163,10 @@ bool GGUFStreamingWriter::write_metadata(const std::string& file_path,
         return false;
     }
 
+    for (const auto& kv : kv_metadata_) {
+        gguf_set_val_str(gguf_ctx_, kv.first.c_str(), kv.second.c_str());
+    }
+
     for (const TensorWritePlan& plan : tensors) {
         ggml_tensor* tensor = ggml_new_tensor(meta_ctx_, plan.type, plan.n_dims, plan.ne);
         if (tensor == nullptr) {
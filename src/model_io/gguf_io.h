@@ -1,6 +1,7 @@
 #ifndef __SD_MODEL_IO_GGUF_IO_H__
 #define __SD_MODEL_IO_GGUF_IO_H__
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -13,7 +14,8 @@ struct gguf_context;
 bool is_gguf_file(const std::string& file_path);
 bool read_gguf_file(const std::string& file_path,
                     std::vector<TensorStorage>& tensor_storages,
-                    std::string* error = nullptr);
+                    std::string* error                           = nullptr,
+                    std::map<std::string, std::string>* metadata = nullptr);
 bool write_gguf_file(const std::string& file_path,
                      const std::vector<TensorWriteInfo>& tensors,
                      std::string* error = nullptr);
@@ -404,6 +404,13 @@ bool SafetensorsStreamingWriter::write_metadata(const std::string& file_path,
 
     nlohmann::ordered_json header = nlohmann::ordered_json::object();
     uint64_t data_offset          = 0;
+    if (!kv_metadata_.empty()) {
+        nlohmann::ordered_json metadata = nlohmann::ordered_json::object();
+        for (const auto& kv : kv_metadata_) {
+            metadata[kv.first] = kv.second;
+        }
+        header["__metadata__"] = metadata;
+    }
     tensor_offsets_.resize(tensors.size());
     for (size_t i = 0; i < tensors.size(); i++) {
         const TensorWritePlan& plan = tensors[i];
@@ -4,10 +4,16 @@
 #include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensor_storage.h"
 
+// Header metadata describing how tensor data is laid out in a converted file.
+#define SD_TENSOR_LAYOUT_KEY "sd.tensor_layout"
+#define SD_TENSOR_LAYOUT_EXECUTION "execution"
+#define SD_TENSOR_LAYOUT_GROUPS_KEY "sd.tensor_layout.groups"
+
 class StreamingModelWriter {
 public:
     virtual ~StreamingModelWriter() = default;
@@ -21,6 +27,14 @@ public:
                               size_t size,
                               std::string* error = nullptr) const = 0;
     virtual uint64_t file_size() const                            = 0;
+
+    // String key/value pairs stored in the file header; set before write_metadata().
+    void set_kv_metadata(std::vector<std::pair<std::string, std::string>> kv_metadata) {
+        kv_metadata_ = std::move(kv_metadata);
+    }
+
+protected:
+    std::vector<std::pair<std::string, std::string>> kv_metadata_;
 };
 
 #endif  // __SD_MODEL_IO_STREAMING_WRITER_H__
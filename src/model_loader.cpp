@@ -258,6 +258,7 @@ bool ModelLoader::init_from_file(const std::string& file_path, const std::string
 }
 
 void ModelLoader::convert_tensors_name() {
+    int64_t t_start   = ggml_time_us();
     SDVersion version = (version_ == VERSION_COUNT) ? get_sd_version() : version_;
     String2TensorStorage new_map;
 
@@ -269,6 +270,7 @@ void ModelLoader::convert_tensors_name() {
     }
 
     tensor_storage_map.swap(new_map);
+    LOG_DEBUG("converted %zu tensor names in %.2f ms", tensor_storage_map.size(), (ggml_time_us() - t_start) / 1000.0);
 }
 
 bool ModelLoader::init_from_file_and_convert_name(const std::string& file_path, const std::string& prefix, SDVersion version) {
@@ -284,15 +286,23 @@ bool ModelLoader::init_from_file_and_convert_name(const std::string& file_path,
 
 /*================================================= GGUFModelLoader ==================================================*/
 
+void ModelLoader::log_tensor_layout(const std::string& file_path) const {
+    auto it = metadata_.find(SD_TENSOR_LAYOUT_KEY);
+    if (it != metadata_.end()) {
+        LOG_INFO("'%s' stores tensors in %s order", file_path.c_str(), it->second.c_str());
+    }
+}
+
 bool ModelLoader::init_from_gguf_file(const std::string& file_path, const std::string& prefix) {
     LOG_DEBUG("init from '%s'", file_path.c_str());
 
     std::vector<TensorStorage> tensor_storages;
     std::string error;
-    if (!read_gguf_file(file_path, tensor_storages, &error)) {
+    if (!read_gguf_file(file_path, tensor_storages, &error, &metadata_)) {
         LOG_ERROR("%s", error.c_str());
         return false;
     }
+    log_tensor_layout(file_path);
 
     size_t file_index = add_file_path(file_path);
 
@@ -321,6 +331,7 @@ bool ModelLoader::init_from_safetensors_file(const std::string& file_path, const
         LOG_ERROR("%s", error.c_str());
         return false;
     }
+    log_tensor_layout(file_path);
 
     size_t file_index = add_file_path(file_path);
 
@@ -798,17 +809,56 @@ TensorTypeRules parse_tensor_type_rules(const std::string& tensor_type_rules) {
     return result;
 }
 
-void ModelLoader::set_wtype_override(ggml_type wtype, std::string tensor_type_rules) {
-    auto map_rules = parse_tensor_type_rules(tensor_type_rules);
-    for (auto& [name, tensor_storage] : tensor_storage_map) {
-        ggml_type dst_type = wtype;
-        for (const auto& tensor_type_rule : map_rules) {
-            std::regex pattern(tensor_type_rule.first);
-            if (std::regex_search(name, pattern)) {
-                dst_type = tensor_type_rule.second;
-                break;
+TensorTypeRuleMatcher::TensorTypeRuleMatcher(const TensorTypeRules& rules) {
+    rules_.reserve(rules.size());
+    for (const auto& [pattern, type] : rules) {
+        Rule rule;
+        rule.pattern   = pattern;
+        rule.type      = type;
+        rule.use_regex = pattern.find_first_of("\\^$|?*+()[]{}") != std::string::npos;
+        if (rule.use_regex) {
+            try {
+                rule.regex = std::regex(pattern);
+            } catch (const std::regex_error& e) {
+                LOG_WARN("ignoring invalid tensor type rule pattern \"%s\": %s", pattern.c_str(), e.what());
+                continue;
             }
         }
+        rules_.push_back(std::move(rule));
+    }
+}
+
+bool TensorTypeRuleMatcher::search_simple(const std::string& name, const std::string& pattern) {
+    if (pattern.size() > name.size()) {
+        return false;
+    }
+    for (size_t start = 0; start + pattern.size() <= name.size(); start++) {
+        size_t i = 0;
+        while (i < pattern.size() && (pattern[i] == '.' || pattern[i] == name[start + i])) {
+            i++;
+        }
+        if (i == pattern.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ggml_type TensorTypeRuleMatcher::match(const std::string& name, ggml_type fallback) const {
+    for (const auto& rule : rules_) {
+        bool matched = rule.use_regex ? std::regex_search(name, rule.regex) : search_simple(name, rule.pattern);
+        if (matched) {
+            return rule.type;
+        }
+    }
+    return fallback;
+}
+
+void ModelLoader::set_wtype_override(ggml_type wtype, std::string tensor_type_rules) {
+    int64_t t_start = ggml_time_us();
+    TensorTypeRuleMatcher matcher(parse_tensor_type_rules(tensor_type_rules));
+    for (auto& [name, tensor_storage] : tensor_storage_map) {
+        ggml_type dst_type = matcher.match(name, wtype);
         if (dst_type == GGML_TYPE_COUNT) {
             continue;
         }
@@ -817,6 +867,24 @@ void ModelLoader::set_wtype_override(ggml_type wtype, std::string tensor_type_ru
         }
         tensor_storage.expected_type = dst_type;
     }
+    LOG_DEBUG("applied tensor type rules to %zu tensors in %.2f ms",
+              tensor_storage_map.size(),
+              (ggml_time_us() - t_start) / 1000.0);
+}
+
+size_t ModelLoader::requantize_f8_weights(ggml_type type, const std::function<bool(const std::string&)>& filter) {
+    size_t count = 0;
+    for (auto& [name, tensor_storage] : tensor_storage_map) {
+        if ((!tensor_storage.is_f8_e4m3 && !tensor_storage.is_f8_e5m2) ||
+            tensor_storage.expected_type != GGML_TYPE_COUNT ||
+            (filter && !filter(name)) ||
+            !tensor_should_be_converted(tensor_storage, type)) {
+            continue;
+        }
+        tensor_storage.expected_type = type;
+        count++;
+    }
+    return count;
 }
 
 void ModelLoader::process_model_files(bool enable_mmap, bool writable_mmap) {
@@ -1286,6 +1354,21 @@ bool ModelLoader::load_tensors(on_new_tensor_cb_t on_new_tensor_cb,
     return success;
 }
 
+bool ModelLoader::get_tensor_file_range(const std::string& name, sd::FileReadRange& range) const {
+    auto it = tensor_storage_map.find(name);
+    if (it == tensor_storage_map.end()) {
+        return false;
+    }
+    const TensorStorage& tensor_storage = it->second;
+    if (tensor_storage.index_in_zip >= 0 || tensor_storage.file_index >= file_paths_.size()) {
+        return false;
+    }
+    range.path   = file_paths_[tensor_storage.file_index];
+    range.offset = tensor_storage.offset;
+    range.size   = static_cast<uint64_t>(tensor_storage.nbytes_to_read());
+    return true;
+}
+
 bool ModelLoader::load_tensor(const TensorStorage& tensor_storage, ggml_tensor* dst_tensor) {
     if (dst_tensor == nullptr || dst_tensor->data == nullptr) {
         LOG_ERROR("load tensor failed: null destination for '%s'", tensor_storage.name.c_str());
@@ -1338,6 +1421,50 @@ bool ModelLoader::load_tensor(const TensorStorage& tensor_storage, ggml_tensor*
     return true;
 }
 
+bool ModelLoader::load_tensor_rows_f32(const TensorStorage& tensor_storage,
+                                       int64_t row_stride,
+                                       int64_t n_rows,
+                                       float* dst) {
+    if (tensor_storage.index_in_zip >= 0 || tensor_storage.is_i64 ||
+        tensor_storage.file_index >= file_paths_.size() || tensor_storage.ne[0] <= 0) {
+        return false;
+    }
+    const int64_t n_per_row = tensor_storage.ne[0];
+    const int64_t nrows     = tensor_storage.nelements() / n_per_row;
+    if (row_stride <= 0 || n_rows <= 0 || (n_rows - 1) * row_stride >= nrows) {
+        return false;
+    }
+
+    const std::string& file_path = file_paths_[tensor_storage.file_index];
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("failed to open '%s'", file_path.c_str());
+        return false;
+    }
+
+    // Same per-element widening as load_tensors, applied to one row at a time.
+    const size_t row_bytes_to_read = static_cast<size_t>(tensor_storage.nbytes_to_read() / nrows);
+    const size_t row_bytes         = static_cast<size_t>(tensor_storage.nbytes() / nrows);
+    std::vector<uint8_t> row(std::max(row_bytes_to_read, row_bytes));
+    for (int64_t i = 0; i < n_rows; i++) {
+        file.seekg(static_cast<std::streamoff>(tensor_storage.offset + i * row_stride * row_bytes_to_read));
+        file.read((char*)row.data(), row_bytes_to_read);
+        if (!file) {
+            LOG_ERROR("read tensor data failed: '%s'", file_path.c_str());
+            return false;
+        }
+        if (tensor_storage.is_f8_e4m3) {
+            f8_e4m3_to_f16_vec(row.data(), (uint16_t*)row.data(), n_per_row);
+        } else if (tensor_storage.is_f8_e5m2) {
+            f8_e5m2_to_f16_vec(row.data(), (uint16_t*)row.data(), n_per_row);
+        } else if (tensor_storage.is_f64) {
+            f64_to_f32_vec((double*)row.data(), (float*)row.data(), n_per_row);
+        }
+        convert_tensor(row.data(), tensor_storage.type, dst + i * n_per_row, GGML_TYPE_F32, 1, (int)n_per_row);
+    }
+    return true;
+}
+
 bool ModelLoader::load_float_tensor(const std::string& name,
                                     std::vector<float>& data,
                                     int n_threads,
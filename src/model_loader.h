@@ -2,16 +2,45 @@
 #define __MODEL_LOADER_H__
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <regex>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "core/file_readahead.h"
 #include "model.h"
 
 TensorTypeRules parse_tensor_type_rules(const std::string& tensor_type_rules);
 
+// tensor_type_rules compiled once for matching against many tensor names.
+// Patterns made only of literal characters and '.' are matched by a plain
+// scan; anything else goes through a std::regex built here instead of per
+// tensor. Invalid patterns are skipped with a warning.
+class TensorTypeRuleMatcher {
+public:
+    TensorTypeRuleMatcher() = default;
+    explicit TensorTypeRuleMatcher(const TensorTypeRules& rules);
+
+    bool empty() const { return rules_.empty(); }
+    // Type of the first rule whose pattern occurs in name, else fallback.
+    ggml_type match(const std::string& name, ggml_type fallback) const;
+
+private:
+    struct Rule {
+        std::string pattern;
+        std::regex regex;
+        bool use_regex = false;
+        ggml_type type = GGML_TYPE_COUNT;
+    };
+
+    static bool search_simple(const std::string& name, const std::string& pattern);
+
+    std::vector<Rule> rules_;
+};
+
 class MmapWrapper;
 
 struct ModelFileData {
@@ -42,6 +71,7 @@ protected:
     size_t add_file_path(const std::string& file_path);
     void add_tensor_storage(const TensorStorage& tensor_storage);
 
+    void log_tensor_layout(const std::string& file_path) const;
     bool init_from_gguf_file(const std::string& file_path, const std::string& prefix = "");
     bool init_from_safetensors_file(const std::string& file_path, const std::string& prefix = "");
     bool init_from_safetensors_index_file(const std::string& file_path, const std::string& prefix = "");
@@ -67,6 +97,9 @@ public:
     const std::map<std::string, std::string>& get_metadata() const { return metadata_; }
     void set_n_threads(int n_threads);
     void set_wtype_override(ggml_type wtype, std::string tensor_type_rules = "");
+    // Loads FP8 weights accepted by filter as type instead of widening them
+    // to f16; tensors with an explicit type override are left alone.
+    size_t requantize_f8_weights(ggml_type type, const std::function<bool(const std::string&)>& filter);
     void process_model_files(bool enable_mmap = false, bool writable_mmap = true);
     std::vector<MmapTensorStore> mmap_tensors(std::map<std::string, ggml_tensor*>& tensors,
                                               std::set<std::string> ignore_tensors = {},
@@ -83,6 +116,16 @@ public:
                            int n_threads = 0,
                            bool use_mmap = false);
     bool load_tensor(const TensorStorage& tensor_storage, ggml_tensor* dst_tensor);
+    // Reads rows 0, row_stride, 2 * row_stride, ... (n_rows of them, rows of
+    // ne[0] elements) as f32 into dst without loading the rest of the tensor.
+    // False for tensors stored inside zip archives and non-float tensors.
+    bool load_tensor_rows_f32(const TensorStorage& tensor_storage,
+                              int64_t row_stride,
+                              int64_t n_rows,
+                              float* dst);
+    // File byte range backing the named tensor; false for unknown tensors and
+    // tensors stored inside zip archives.
+    bool get_tensor_file_range(const std::string& name, sd::FileReadRange& range) const;
 
     std::vector<std::string> get_tensor_names() const {
         std::vector<std::string> names;
@@ -37,6 +37,19 @@ static std::string lora_id(const ModelManager::LoraSpec& lora) {
     return lora.is_high_noise ? "|high_noise|" + lora.path : lora.path;
 }
 
+// Everything that determines the merged params of a LoRA stack.
+static std::string lora_stack_key(const std::vector<ModelManager::LoraSpec>& loras, SDVersion version) {
+    std::string key = std::to_string((int)version);
+    for (const auto& lora : loras) {
+        key += sd_format("\n%s|%s|%.9g|%s",
+                         lora_id(lora).c_str(),
+                         SharedWeightRegistry::file_identity(lora.path).c_str(),
+                         lora.multiplier,
+                         lora.tensor_name_prefix_filter.c_str());
+    }
+    return key;
+}
+
 static bool backend_supports_host_buffer(ggml_backend_t backend) {
     if (backend == nullptr) {
         return false;
@@ -57,6 +70,15 @@ ModelManager::~ModelManager() {
     release_all();
 }
 
+void ModelManager::set_enable_mmap(bool enable_mmap) {
+    enable_mmap_ = enable_mmap;
+
+    MmapFlags mmap_flags = get_mmap_flags();
+    mmap_prefetch_       = enable_mmap && mmap_flags.prefetch;
+    mmap_cold_           = enable_mmap && mmap_flags.cold;
+    mmap_ram_cap_bytes_  = mmap_flags.ram_cap_bytes;
+}
+
 void ModelManager::set_common_ignore_tensors(std::set<std::string> ignore_tensors) {
     common_ignore_tensors_ = std::move(ignore_tensors);
 }
@@ -70,12 +92,18 @@ void ModelManager::set_loras(std::vector<LoraSpec> loras, SDVersion version) {
         return;
     }
 
-    loras_        = std::move(loras);
-    lora_version_ = version;
+    loras_            = std::move(loras);
+    lora_version_     = version;
+    current_lora_key_ = loras_.empty() ? "" : lora_stack_key(loras_, version);
     current_lora_epoch_++;
     reset_lora_applied_params();
 }
 
+void ModelManager::set_merged_lora_cache_bytes(size_t max_bytes) {
+    merged_lora_cache_max_bytes_ = max_bytes;
+    trim_merged_lora_cache(max_bytes);
+}
+
 std::set<std::string> ModelManager::tensor_names() const {
     std::set<std::string> names;
     for (const auto& state : tensor_states_) {
@@ -334,16 +362,40 @@ bool ModelManager::load_tensors_to_params_backend(const std::vector<TensorState*
         return false;
     }
 
+    bind_shared_params(need_load, created_storage_blocks);
+
+    std::vector<TensorState*> need_read;
     std::vector<TensorState*> need_alloc;
+    need_read.reserve(need_load.size());
     need_alloc.reserve(need_load.size());
     for (TensorState* state : need_load) {
+        if (state->loaded_to_params_backend) {
+            continue;
+        }
+        need_read.push_back(state);
         if (state->tensor != nullptr && state->tensor->data == nullptr && state->tensor->view_src == nullptr) {
             need_alloc.push_back(state);
         }
     }
 
-    if (!alloc_params_buffers(need_alloc, created_storage_blocks) ||
-        !load_tensors(need_load)) {
+    bool allocated = alloc_params_buffers(need_alloc, created_storage_blocks);
+    if (allocated && !merged_lora_cache_.empty()) {
+        // Params that are used in place get the cached merged bytes instead
+        // of a disk read; staged ones are restored after staging.
+        need_read.erase(std::remove_if(need_read.begin(),
+                                       need_read.end(),
+                                       [this](TensorState* state) {
+                                           if (state->compute_backend != state->params_backend ||
+                                               state->tensor == nullptr || state->tensor->data == nullptr ||
+                                               !restore_merged_lora_params(state, false)) {
+                                               return false;
+                                           }
+                                           state->loaded_to_params_backend = true;
+                                           return true;
+                                       }),
+                        need_read.end());
+    }
+    if (!allocated || !load_tensors(need_read)) {
         for (ParamsStorageBlock* block : created_storage_blocks) {
             if (block != nullptr) {
                 free_params_storage_block(*block);
@@ -352,6 +404,10 @@ bool ModelManager::load_tensors_to_params_backend(const std::vector<TensorState*
         }
         return false;
     }
+    for (TensorState* state : need_load) {
+        state->readahead_issued = false;
+    }
+    publish_shared_params(created_storage_blocks);
     for (ParamsStorageBlock* block : created_storage_blocks) {
         if (block != nullptr && block->buffer != nullptr) {
             LOG_DEBUG("model manager prepared params backend buffer (%6.2f MB, %zu tensors, %s)",
@@ -498,6 +554,9 @@ bool ModelManager::apply_loras_to_params(const std::vector<TensorState*>& states
             LOG_ERROR("model manager lora target tensor '%s' is not prepared", state->name.c_str());
             return false;
         }
+        if (restore_merged_lora_params(state, true)) {
+            continue;
+        }
         LoraApplyGroup& group            = groups[state->compute_backend];
         group.model_tensors[state->name] = state->tensor;
         group.states.push_back(state);
@@ -511,6 +570,7 @@ bool ModelManager::apply_loras_to_params(const std::vector<TensorState*>& states
     for (auto& group_pair : groups) {
         ggml_backend_t compute_backend = group_pair.first;
         LoraApplyGroup& group          = group_pair.second;
+        std::set<std::string> patched_names;
         for (const LoraSpec& lora_spec : loras_) {
             if (group.model_tensors.empty()) {
                 continue;
@@ -546,6 +606,7 @@ bool ModelManager::apply_loras_to_params(const std::vector<TensorState*>& states
             }
             lora->multiplier = lora_spec.multiplier;
             lora->apply(group.model_tensors, all_tensor_names, lora_version_, n_threads_, false);
+            patched_names.insert(lora->patched_model_tensors.begin(), lora->patched_model_tensors.end());
             lora->release_loaded_tensors();
         }
 
@@ -554,6 +615,7 @@ bool ModelManager::apply_loras_to_params(const std::vector<TensorState*>& states
                 state->applied_lora_epoch = current_lora_epoch_;
             }
         }
+        store_merged_lora_params(group.states, patched_names);
     }
     return true;
 }
@@ -566,6 +628,104 @@ void ModelManager::reset_lora_applied_params() {
     }
 }
 
+const ModelManager::MergedLoraParams* ModelManager::find_merged_lora_entry() {
+    if (current_lora_key_.empty()) {
+        return nullptr;
+    }
+    auto entry_it = std::find_if(merged_lora_cache_.begin(),
+                                 merged_lora_cache_.end(),
+                                 [this](const MergedLoraParams& entry) {
+                                     return entry.lora_key == current_lora_key_;
+                                 });
+    if (entry_it == merged_lora_cache_.end()) {
+        return nullptr;
+    }
+    if (entry_it != merged_lora_cache_.begin()) {
+        merged_lora_cache_.splice(merged_lora_cache_.begin(), merged_lora_cache_, entry_it);
+    }
+    return &merged_lora_cache_.front();
+}
+
+bool ModelManager::restore_merged_lora_params(TensorState* state, bool base_params_loaded) {
+    if (state->tensor == nullptr) {
+        return false;
+    }
+    const MergedLoraParams* entry = find_merged_lora_entry();
+    if (entry == nullptr) {
+        return false;
+    }
+    if (entry->untouched.count(state->name) > 0) {
+        if (!base_params_loaded) {
+            return false;
+        }
+        state->applied_lora_epoch = current_lora_epoch_;
+        return true;
+    }
+    auto tensor_it = entry->tensors.find(state->name);
+    if (tensor_it == entry->tensors.end() || tensor_it->second.size() != ggml_nbytes(state->tensor)) {
+        return false;
+    }
+    ggml_backend_tensor_set(state->tensor, tensor_it->second.data(), 0, tensor_it->second.size());
+    state->applied_lora_epoch = current_lora_epoch_;
+    return true;
+}
+
+void ModelManager::store_merged_lora_params(const std::vector<TensorState*>& states,
+                                            const std::set<std::string>& patched_names) {
+    if (merged_lora_cache_max_bytes_ == 0 || current_lora_key_.empty()) {
+        return;
+    }
+    auto entry_it = std::find_if(merged_lora_cache_.begin(),
+                                 merged_lora_cache_.end(),
+                                 [this](const MergedLoraParams& entry) {
+                                     return entry.lora_key == current_lora_key_;
+                                 });
+    if (entry_it == merged_lora_cache_.end()) {
+        merged_lora_cache_.emplace_front();
+        merged_lora_cache_.front().lora_key = current_lora_key_;
+    } else if (entry_it != merged_lora_cache_.begin()) {
+        merged_lora_cache_.splice(merged_lora_cache_.begin(), merged_lora_cache_, entry_it);
+    }
+    MergedLoraParams& entry = merged_lora_cache_.front();
+
+    for (TensorState* state : states) {
+        if (state == nullptr || state->tensor == nullptr || state->tensor->data == nullptr ||
+            entry.tensors.find(state->name) != entry.tensors.end()) {
+            continue;
+        }
+        if (patched_names.count(state->name) == 0) {
+            entry.untouched.insert(state->name);
+            continue;
+        }
+        const size_t nbytes = ggml_nbytes(state->tensor);
+        while (merged_lora_cache_bytes_ + nbytes > merged_lora_cache_max_bytes_ &&
+               merged_lora_cache_.size() > 1) {
+            const MergedLoraParams& evicted = merged_lora_cache_.back();
+            LOG_DEBUG("model manager evicting merged lora params (%6.2f MB, %zu tensors)",
+                      evicted.nbytes / (1024.f * 1024.f),
+                      evicted.tensors.size());
+            merged_lora_cache_bytes_ -= evicted.nbytes;
+            merged_lora_cache_.pop_back();
+        }
+        if (merged_lora_cache_bytes_ + nbytes > merged_lora_cache_max_bytes_) {
+            // The current stack alone fills the budget.
+            continue;
+        }
+        std::vector<uint8_t>& data = entry.tensors[state->name];
+        data.resize(nbytes);
+        ggml_backend_tensor_get(state->tensor, data.data(), 0, nbytes);
+        entry.nbytes += nbytes;
+        merged_lora_cache_bytes_ += nbytes;
+    }
+}
+
+void ModelManager::trim_merged_lora_cache(size_t max_bytes) {
+    while (merged_lora_cache_bytes_ > max_bytes && !merged_lora_cache_.empty()) {
+        merged_lora_cache_bytes_ -= merged_lora_cache_.back().nbytes;
+        merged_lora_cache_.pop_back();
+    }
+}
+
 bool ModelManager::should_ignore(const TensorState& state) const {
     for (const auto& ignore_prefix : common_ignore_tensors_) {
         if (starts_with(state.name, ignore_prefix)) {
@@ -635,6 +795,7 @@ bool ModelManager::mmap_params(const std::vector<TensorState*>& states,
     for (const auto& pair : mmap_states) {
         TensorState* state = pair.second;
         if (state != nullptr && state->tensor != nullptr && state->tensor->data != nullptr) {
+            state->mmapped = true;
             block->states.push_back(state);
         }
     }
@@ -690,6 +851,14 @@ bool ModelManager::alloc_params_buffers(const std::vector<TensorState*>& states,
                 return false;
             }
             ggml_backend_buffer_set_usage(buffer, GGML_BACKEND_BUFFER_USAGE_WEIGHTS);
+            // Place the pages before load_tensors() first-touches them.
+            if (ggml_backend_buffer_is_host(buffer) &&
+                !sd_numa_bind_memory(ggml_backend_buffer_get_base(buffer), chunk_size, numa_mode_) &&
+                !warned_numa_bind_) {
+                LOG_WARN("model manager failed to apply NUMA mode '%s' to params buffers",
+                         sd_numa_mode_name(numa_mode_));
+                warned_numa_bind_ = true;
+            }
 
             std::vector<ggml_tensor*> initialized_tensors;
             void* base    = ggml_backend_buffer_get_base(buffer);
@@ -720,6 +889,9 @@ bool ModelManager::alloc_params_buffers(const std::vector<TensorState*>& states,
             auto block              = std::make_unique<ParamsStorageBlock>();
             block->buffer           = buffer;
             block->states           = chunk;
+            if (share_params_ && loras_.empty()) {
+                block->published_buffer = SharedParamsBuffer(buffer, ggml_backend_buffer_free);
+            }
             ParamsStorageBlock* raw = block.get();
             params_storage_blocks_.push_back(std::move(block));
             created_storage_blocks.push_back(raw);
@@ -827,6 +999,89 @@ bool ModelManager::load_tensors(const std::vector<TensorState*>& states) {
     return true;
 }
 
+bool ModelManager::shared_weight_key_for(const TensorState& state, SharedWeightKey& key) {
+    if (!share_params_ || !loras_.empty() || state.tensor == nullptr ||
+        state.residency_mode != ResidencyMode::ParamBackend || state.allow_split_buffer) {
+        return false;
+    }
+    const auto& tensor_storage_map = model_loader_.get_tensor_storage_map();
+    auto ts_it                     = tensor_storage_map.find(state.name);
+    sd::FileReadRange range;
+    if (ts_it == tensor_storage_map.end() || !model_loader_.get_tensor_file_range(state.name, range)) {
+        return false;
+    }
+
+    auto id_it = file_identities_.find(range.path);
+    if (id_it == file_identities_.end()) {
+        id_it = file_identities_.emplace(range.path, SharedWeightRegistry::file_identity(range.path)).first;
+    }
+    key.file_id  = id_it->second;
+    key.offset   = range.offset;
+    key.nbytes   = range.size;
+    key.src_type = ts_it->second.type;
+    key.dst_type = state.tensor->type;
+    key.buft     = params_buffer_type_for(state);
+    return !key.file_id.empty() && key.buft != nullptr;
+}
+
+void ModelManager::bind_shared_params(const std::vector<TensorState*>& states,
+                                      std::vector<ParamsStorageBlock*>& created_storage_blocks) {
+    if (!share_params_ || !loras_.empty()) {
+        return;
+    }
+
+    auto block = std::make_unique<ParamsStorageBlock>();
+    std::unordered_set<ggml_backend_buffer_t> seen_buffers;
+    for (TensorState* state : states) {
+        if (state == nullptr || state->tensor == nullptr ||
+            state->tensor->data != nullptr || state->tensor->view_src != nullptr) {
+            continue;
+        }
+        SharedWeightKey key;
+        if (!shared_weight_key_for(*state, key)) {
+            continue;
+        }
+        SharedParamsBuffer buffer;
+        void* data = nullptr;
+        if (!SharedWeightRegistry::instance().lookup(key, &buffer, &data)) {
+            continue;
+        }
+        if (ggml_backend_tensor_alloc(buffer.get(), state->tensor, data) != GGML_STATUS_SUCCESS) {
+            state->tensor->buffer = nullptr;
+            state->tensor->data   = nullptr;
+            continue;
+        }
+        state->loaded_to_params_backend = true;
+        block->states.push_back(state);
+        if (seen_buffers.insert(buffer.get()).second) {
+            block->shared_buffers.push_back(std::move(buffer));
+        }
+    }
+    if (block->states.empty()) {
+        return;
+    }
+
+    LOG_DEBUG("model manager reusing %zu params tensors already loaded by another context",
+              block->states.size());
+    ParamsStorageBlock* raw = block.get();
+    params_storage_blocks_.push_back(std::move(block));
+    created_storage_blocks.push_back(raw);
+}
+
+void ModelManager::publish_shared_params(const std::vector<ParamsStorageBlock*>& blocks) {
+    for (ParamsStorageBlock* block : blocks) {
+        if (block == nullptr || block->published_buffer == nullptr) {
+            continue;
+        }
+        for (TensorState* state : block->states) {
+            SharedWeightKey key;
+            if (state != nullptr && state->tensor != nullptr && shared_weight_key_for(*state, key)) {
+                SharedWeightRegistry::instance().publish(key, block->published_buffer, state->tensor->data);
+            }
+        }
+    }
+}
+
 ggml_backend_buffer_type_t ModelManager::params_buffer_type_for(const TensorState& state) const {
     if (state.params_backend == nullptr) {
         LOG_ERROR("model manager params backend is null for tensor '%s'", state.name.c_str());
@@ -917,9 +1172,15 @@ void ModelManager::free_params_storage_block(ParamsStorageBlock& block) {
                   ggml_backend_buffer_get_size(block.buffer) / (1024.f * 1024.f),
                   block.states.size(),
                   ggml_backend_buffer_is_host(block.buffer) ? "RAM" : "VRAM");
-        ggml_backend_buffer_free(block.buffer);
+        if (block.published_buffer != nullptr) {
+            // Other managers may still reference it; the last owner frees it.
+            block.published_buffer.reset();
+        } else {
+            ggml_backend_buffer_free(block.buffer);
+        }
         block.buffer = nullptr;
     }
+    block.shared_buffers.clear();
     block.mmap_tensor_stores.clear();
 
     for (TensorState* state : block.states) {
@@ -931,6 +1192,7 @@ void ModelManager::free_params_storage_block(ParamsStorageBlock& block) {
         state->tensor->extra  = nullptr;
 
         state->loaded_to_params_backend = false;
+        state->mmapped                  = false;
         state->applied_lora_epoch       = UINT64_MAX;
     }
     block.states.clear();
@@ -1022,6 +1284,7 @@ bool ModelManager::assign_compute_backend(const std::vector<ggml_tensor*>& tenso
     if (tensors.empty()) {
         return true;
     }
+    std::lock_guard<std::mutex> lock(weight_mutex_);
     if (compute_backend == nullptr) {
         LOG_ERROR("model manager cannot assign tensors to a null compute backend");
         return false;
@@ -1069,6 +1332,7 @@ bool ModelManager::prepare_params(const std::vector<ggml_tensor*>& tensors) {
     if (tensors.empty()) {
         return true;
     }
+    std::lock_guard<std::mutex> lock(weight_mutex_);
 
     std::vector<TensorState*> required_states;
     if (!resolve_required_tensor_states(tensors, required_states)) {
@@ -1078,6 +1342,7 @@ bool ModelManager::prepare_params(const std::vector<ggml_tensor*>& tensors) {
     if (!load_tensors_to_params_backend(required_states)) {
         return false;
     }
+    advise_mmapped_params_willneed(required_states);
 
     if (!stage_tensors_to_compute_backend(required_states)) {
         release_compute_staging_blocks(false);
@@ -1100,6 +1365,115 @@ bool ModelManager::prepare_params(const std::vector<ggml_tensor*>& tensors) {
     return true;
 }
 
+void ModelManager::prefetch_params(const std::vector<ggml_tensor*>& tensors) {
+    if (tensors.empty() || readahead_bytes_ == 0 || !sd::FileReadahead::supported()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(weight_mutex_);
+
+    std::vector<std::pair<TensorState*, sd::FileReadRange>> pending;
+    pending.reserve(tensors.size());
+    for (ggml_tensor* tensor : tensors) {
+        if (tensor == nullptr) {
+            continue;
+        }
+        const char* raw_name = ggml_get_name(tensor);
+        auto state_it        = tensor_states_by_name_.find(raw_name != nullptr ? raw_name : "");
+        if (state_it == tensor_states_by_name_.end() || state_it->second == nullptr) {
+            continue;
+        }
+        TensorState* state = state_it->second;
+        if (state->residency_mode != ResidencyMode::Disk ||
+            state->loaded_to_params_backend ||
+            state->readahead_issued ||
+            should_ignore(*state) ||
+            is_optional_missing_tensor(state->name)) {
+            continue;
+        }
+        sd::FileReadRange range;
+        if (!model_loader_.get_tensor_file_range(state->name, range)) {
+            // Nothing to read ahead (e.g. zip-backed tensor); don't look again.
+            state->readahead_issued = true;
+            continue;
+        }
+        pending.emplace_back(state, std::move(range));
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    if (readahead_ == nullptr) {
+        readahead_ = std::make_unique<sd::FileReadahead>(readahead_bytes_);
+    }
+
+    // Tensors of one segment that sit back to back in the file (execution
+    // order layout) are merged into a single range, up to the padding
+    // between them, so the segment is one sequential read.
+    static constexpr uint64_t READAHEAD_MERGE_GAP = 4096;
+    struct ReadaheadRun {
+        std::vector<TensorState*> states;
+        sd::FileReadRange range;
+    };
+    std::vector<ReadaheadRun> runs;
+    for (auto& pair : pending) {
+        if (!runs.empty()) {
+            sd::FileReadRange& last = runs.back().range;
+            uint64_t last_end       = last.offset + last.size;
+            uint64_t merged_size    = pair.second.offset + pair.second.size - last.offset;
+            if (pair.second.path == last.path &&
+                pair.second.offset >= last_end &&
+                pair.second.offset - last_end <= READAHEAD_MERGE_GAP &&
+                merged_size <= readahead_bytes_) {
+                last.size = merged_size;
+                runs.back().states.push_back(pair.first);
+                continue;
+            }
+        }
+        runs.push_back({{pair.first}, std::move(pair.second)});
+    }
+
+    // Submit in the caller's order so the nearest tensors win the budget.
+    size_t queued_bytes = 0;
+    size_t queued_count = 0;
+    size_t queued_runs  = 0;
+    for (auto& run : runs) {
+        // A tensor larger than the whole budget only gets its head warmed.
+        run.range.size          = std::min<uint64_t>(run.range.size, readahead_bytes_);
+        const size_t range_size = static_cast<size_t>(run.range.size);
+        if (range_size > 0 && readahead_->submit({run.range}) == 0) {
+            break;
+        }
+        for (TensorState* state : run.states) {
+            state->readahead_issued = true;
+        }
+        queued_bytes += range_size;
+        queued_count += run.states.size();
+        queued_runs++;
+    }
+    if (queued_count > 0) {
+        LOG_DEBUG("model manager queued read-ahead for %zu tensors in %zu ranges (%.2f MB)",
+                  queued_count,
+                  queued_runs,
+                  queued_bytes / (1024.f * 1024.f));
+    }
+}
+
+void ModelManager::cancel_prefetch() {
+    std::lock_guard<std::mutex> lock(weight_mutex_);
+    if (readahead_ == nullptr) {
+        return;
+    }
+    readahead_->cancel_pending();
+    // Ranges a worker already picked up still complete; clearing the flags
+    // only lets a later run queue the dropped ones again.
+    for (auto& pair : tensor_states_by_name_) {
+        TensorState* state = pair.second;
+        if (state != nullptr && !state->loaded_to_params_backend) {
+            state->readahead_issued = false;
+        }
+    }
+}
+
 void ModelManager::finish_compute_backend_usage(const std::vector<TensorState*>& states) {
     if (states.empty()) {
         return;
@@ -1114,13 +1488,52 @@ void ModelManager::finish_compute_backend_usage(const std::vector<TensorState*>&
             state->active_prepare_count--;
         }
     }
+    advise_mmapped_params_cold(states);
     release_compute_staging_blocks(false, &target_states);
 }
 
+void ModelManager::advise_mmapped_params_willneed(const std::vector<TensorState*>& states) const {
+    if (!mmap_prefetch_) {
+        return;
+    }
+    // States arrive in graph leaf order, which follows execution order, so
+    // the kernel reads the first layers first. With a RAM cap only the head
+    // of the list is hinted; the rest still faults in on demand.
+    size_t advised_bytes = 0;
+    for (TensorState* state : states) {
+        if (state == nullptr || !state->mmapped || state->tensor == nullptr || state->tensor->data == nullptr) {
+            continue;
+        }
+        const size_t nbytes = ggml_nbytes(state->tensor);
+        if (mmap_ram_cap_bytes_ > 0 && advised_bytes + nbytes > mmap_ram_cap_bytes_) {
+            break;
+        }
+        mmap_advise_willneed(state->tensor->data, nbytes);
+        advised_bytes += nbytes;
+    }
+}
+
+void ModelManager::advise_mmapped_params_cold(const std::vector<TensorState*>& states) const {
+    if (!mmap_cold_) {
+        return;
+    }
+    if (mmap_ram_cap_bytes_ > 0 && sd_get_resident_memory_bytes() <= mmap_ram_cap_bytes_) {
+        return;
+    }
+    for (TensorState* state : states) {
+        if (state == nullptr || !state->mmapped || state->active_prepare_count > 0 ||
+            state->tensor == nullptr || state->tensor->data == nullptr) {
+            continue;
+        }
+        mmap_advise_cold(state->tensor->data, ggml_nbytes(state->tensor));
+    }
+}
+
 void ModelManager::release_compute_backend_params(const std::vector<ggml_tensor*>& tensors) {
     if (tensors.empty()) {
         return;
     }
+    std::lock_guard<std::mutex> lock(weight_mutex_);
     std::vector<TensorState*> required_states;
     if (!resolve_required_tensor_states(tensors, required_states)) {
         return;
@@ -1132,6 +1545,7 @@ void ModelManager::release_params_backend_params(const std::vector<ggml_tensor*>
     if (tensors.empty()) {
         return;
     }
+    std::lock_guard<std::mutex> lock(weight_mutex_);
     std::vector<TensorState*> required_states;
     if (!resolve_required_tensor_states(tensors, required_states)) {
         return;
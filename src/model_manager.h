@@ -2,15 +2,19 @@
 #define __MODEL_MANAGER_H__
 
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "model_loader.h"
+#include "stable-diffusion.h"
 #include "weight_manager.h"
+#include "weight_registry.h"
 
 class ModelManager : public RunnerWeightManager {
 public:
@@ -44,15 +48,33 @@ private:
 
         bool loaded_to_params_backend  = false;
         bool staged_to_compute_backend = false;
+        bool readahead_issued          = false;
+        bool mmapped                   = false;
         uint64_t applied_lora_epoch    = UINT64_MAX;
     };
 
     struct ParamsStorageBlock {
         ggml_backend_buffer_t buffer = nullptr;
+        // Set when buffer may be shared through SharedWeightRegistry; it then
+        // owns buffer instead of free_params_storage_block().
+        SharedParamsBuffer published_buffer;
+        // Buffers of other managers that this block's tensors point into.
+        std::vector<SharedParamsBuffer> shared_buffers;
         std::vector<MmapTensorStore> mmap_tensor_stores;
         std::vector<TensorState*> states;
     };
 
+    // Merged (base + LoRA) bytes of the params a LoRA stack touched, kept in
+    // host memory so switching back to the stack skips the disk read and
+    // the merge. Params the stack leaves alone are only listed by name, so
+    // they need neither a copy nor another pass over the LoRA files.
+    struct MergedLoraParams {
+        std::string lora_key;
+        std::map<std::string, std::vector<uint8_t>> tensors;
+        std::set<std::string> untouched;
+        size_t nbytes = 0;
+    };
+
     struct ComputeStagingBlock {
         ggml_backend_t compute_backend = nullptr;
         ggml_backend_buffer_t buffer   = nullptr;
@@ -67,13 +89,29 @@ private:
     std::vector<std::unique_ptr<ComputeStagingBlock>> compute_staging_blocks_;
     std::map<ggml_backend_t, ggml_backend_buffer_type_t> split_buffer_types_;
     bool warned_split_lora_skip_ = false;
+    bool warned_numa_bind_       = false;
     std::set<std::string> common_ignore_tensors_;
     std::vector<LoraSpec> loras_;
     SDVersion lora_version_      = VERSION_COUNT;
     uint64_t current_lora_epoch_ = 0;
+    std::string current_lora_key_;
+    std::list<MergedLoraParams> merged_lora_cache_;  // most recently used first
+    size_t merged_lora_cache_max_bytes_ = 0;
+    size_t merged_lora_cache_bytes_     = 0;
     int n_threads_               = 0;
     bool enable_mmap_            = false;
     bool writable_mmap_          = false;
+    size_t readahead_bytes_      = 512ull * 1024 * 1024;
+    bool mmap_prefetch_          = false;
+    bool mmap_cold_              = false;
+    size_t mmap_ram_cap_bytes_   = 0;
+    sd_numa_mode_t numa_mode_    = SD_NUMA_DISABLED;
+    bool share_params_           = true;
+    std::map<std::string, std::string> file_identities_;
+    std::unique_ptr<sd::FileReadahead> readahead_;
+    // Serializes the RunnerWeightManager entry points; runners with backends
+    // of their own (e.g. the LTX audio VAE) compute next to other runners.
+    std::mutex weight_mutex_;
 
     void finish_compute_backend_usage(const std::vector<TensorState*>& states);
     void release_all();
@@ -92,7 +130,13 @@ private:
     bool alloc_params_buffers(const std::vector<TensorState*>& states,
                               std::vector<ParamsStorageBlock*>& created_storage_blocks);
     bool load_tensors(const std::vector<TensorState*>& states);
+    bool shared_weight_key_for(const TensorState& state, SharedWeightKey& key);
+    void bind_shared_params(const std::vector<TensorState*>& states,
+                            std::vector<ParamsStorageBlock*>& created_storage_blocks);
+    void publish_shared_params(const std::vector<ParamsStorageBlock*>& blocks);
     bool stage_tensors_to_compute_backend(const std::vector<TensorState*>& states);
+    void advise_mmapped_params_willneed(const std::vector<TensorState*>& states) const;
+    void advise_mmapped_params_cold(const std::vector<TensorState*>& states) const;
 
     ggml_backend_buffer_type_t params_buffer_type_for(const TensorState& state) const;
     ggml_backend_buffer_type_t split_buffer_type_for(const TensorState& state) const;
@@ -104,6 +148,13 @@ private:
     void free_params_storage_block(ParamsStorageBlock& block);
     void erase_params_storage_block(ParamsStorageBlock* block);
     void reset_lora_applied_params();
+    const MergedLoraParams* find_merged_lora_entry();
+    // True when state holds the params of the current stack afterwards.
+    // Untouched params only count once their base params are loaded.
+    bool restore_merged_lora_params(TensorState* state, bool base_params_loaded);
+    void store_merged_lora_params(const std::vector<TensorState*>& states,
+                                  const std::set<std::string>& patched_names);
+    void trim_merged_lora_cache(size_t max_bytes);
 
 public:
     ~ModelManager() override;
@@ -115,10 +166,24 @@ public:
         n_threads_ = n_threads;
         model_loader_.set_n_threads(n_threads);
     }
-    void set_enable_mmap(bool enable_mmap) { enable_mmap_ = enable_mmap; }
+    void set_enable_mmap(bool enable_mmap);
     void set_writable_mmap(bool writable_mmap) { writable_mmap_ = writable_mmap; }
+    // Upper bound of disk-resident param bytes queued for background
+    // read-ahead by prefetch_params(); 0 disables read-ahead.
+    void set_readahead_bytes(size_t readahead_bytes) {
+        readahead_bytes_ = readahead_bytes;
+        readahead_.reset();
+    }
+    void set_numa_mode(sd_numa_mode_t numa_mode) { numa_mode_ = numa_mode; }
+    // Reuse identical read-only params already loaded by other managers in
+    // this process (and offer ours to them). Never applies while LoRAs are
+    // merged into the params.
+    void set_share_params(bool share_params) { share_params_ = share_params; }
     void set_common_ignore_tensors(std::set<std::string> ignore_tensors);
     void set_loras(std::vector<LoraSpec> loras, SDVersion version);
+    // Host memory budget for merged params of recently used LoRA stacks;
+    // 0 disables the cache.
+    void set_merged_lora_cache_bytes(size_t max_bytes);
     void set_split_buffer_type(ggml_backend_t compute_backend, ggml_backend_buffer_type_t split_buft);
 
     static bool tensor_shape_supports_split_buffer(const ggml_tensor* tensor);
@@ -180,6 +245,8 @@ public:
     bool prepare_params(const std::vector<ggml_tensor*>& tensors) override;
     void release_compute_backend_params(const std::vector<ggml_tensor*>& tensors) override;
     void release_params_backend_params(const std::vector<ggml_tensor*>& tensors) override;
+    void prefetch_params(const std::vector<ggml_tensor*>& tensors) override;
+    void cancel_prefetch() override;
 };
 
 #endif  // __MODEL_MANAGER_H__
@@ -1,12 +1,84 @@
+#include <algorithm>
 #include <map>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
 
 #include "core/util.h"
 #include "name_conversion.h"
 
+// Prefix -> replacement table for the large generated name maps (thousands of
+// entries for SD3/Flux/HunyuanVideo). A lookup probes the name's prefixes of
+// each distinct key length in a hash index instead of testing every entry. When
+// several keys match, the one iterated first in the underlying unordered_map
+// wins, exactly like replace_with_prefix_map on a plain unordered_map.
+//
+// Loader threads may convert names concurrently, so the table is filled and
+// indexed under std::call_once and is read-only afterwards; lookups take no
+// lock.
+class PrefixNameMap {
+public:
+    template <typename Fill>
+    void init_once(Fill&& fill) {
+        std::call_once(init_flag_, [&]() {
+            fill();
+            build_index();
+        });
+    }
+
+    // Only for the init_once() fill callback.
+    std::string& operator[](const std::string& key) {
+        return entries_[key];
+    }
+
+    // Returns the replacement of the matching prefix and its length, or nullptr.
+    const std::string* find_prefix(const std::string& name, size_t* prefix_len) const {
+        const IndexEntry* best = nullptr;
+        size_t best_len        = 0;
+        for (size_t len : key_lengths_) {
+            if (len > name.size()) {
+                break;
+            }
+            auto it = index_.find(std::string_view(name.data(), len));
+            if (it != index_.end() && (best == nullptr || it->second.order < best->order)) {
+                best     = &it->second;
+                best_len = len;
+            }
+        }
+        if (best == nullptr) {
+            return nullptr;
+        }
+        *prefix_len = best_len;
+        return best->value;
+    }
+
+private:
+    struct IndexEntry {
+        size_t order             = 0;
+        const std::string* value = nullptr;
+    };
+
+    void build_index() {
+        index_.clear();
+        key_lengths_.clear();
+        index_.reserve(entries_.size());
+        size_t order = 0;
+        for (const auto& [key, value] : entries_) {
+            index_[std::string_view(key)] = {order++, &value};
+            key_lengths_.push_back(key.size());
+        }
+        std::sort(key_lengths_.begin(), key_lengths_.end());
+        key_lengths_.erase(std::unique(key_lengths_.begin(), key_lengths_.end()), key_lengths_.end());
+    }
+
+    std::unordered_map<std::string, std::string> entries_;
+    std::unordered_map<std::string_view, IndexEntry> index_;
+    std::vector<size_t> key_lengths_;
+    std::once_flag init_flag_;
+};
+
 void replace_with_name_map(std::string& name, const std::vector<std::pair<std::string, std::string>>& name_map) {
-    for (auto kv : name_map) {
+    for (const auto& kv : name_map) {
         size_t pos = name.find(kv.first);
         if (pos != std::string::npos) {
             name.replace(pos, kv.first.size(), kv.second);
@@ -32,6 +104,14 @@ void replace_with_prefix_map(std::string& name, const std::unordered_map<std::st
     }
 }
 
+void replace_with_prefix_map(std::string& name, const PrefixNameMap& prefix_map) {
+    size_t prefix_len             = 0;
+    const std::string* new_prefix = prefix_map.find_prefix(name, &prefix_len);
+    if (new_prefix != nullptr) {
+        name = *new_prefix + name.substr(prefix_len);
+    }
+}
+
 std::string convert_open_clip_to_hf_clip_name(std::string name) {
     static std::unordered_map<std::string, std::string> open_clip_to_hf_clip_model = {
         {"model.ln_final.bias", "transformer.text_model.final_layer_norm.bias"},
@@ -433,9 +513,9 @@ std::string convert_diffusers_unet_to_original_sdxl(std::string name) {
 
 std::string convert_diffusers_dit_to_original_sd3(std::string name) {
     int num_layers = 38;
-    static std::unordered_map<std::string, std::string> sd3_name_map;
+    static PrefixNameMap sd3_name_map;
 
-    if (sd3_name_map.empty()) {
+    sd3_name_map.init_once([&]() {
         // --- time_text_embed ---
         sd3_name_map["time_text_embed.timestep_embedder.linear_1.weight"] = "t_embedder.mlp.0.weight";
         sd3_name_map["time_text_embed.timestep_embedder.linear_1.bias"]   = "t_embedder.mlp.0.bias";
@@ -530,7 +610,7 @@ std::string convert_diffusers_dit_to_original_sd3(std::string name) {
         sd3_name_map["proj_out.bias"]          = "final_layer.linear.bias";
         sd3_name_map["norm_out.linear.weight"] = "final_layer.adaLN_modulation.1.weight";
         sd3_name_map["norm_out.linear.bias"]   = "final_layer.adaLN_modulation.1.bias";
-    }
+    });
 
     replace_with_prefix_map(name, sd3_name_map);
 
@@ -540,9 +620,9 @@ std::string convert_diffusers_dit_to_original_sd3(std::string name) {
 std::string convert_diffusers_dit_to_original_flux(std::string name) {
     int num_layers        = 19;
     int num_single_layers = 38;
-    static std::unordered_map<std::string, std::string> flux_name_map;
+    static PrefixNameMap flux_name_map;
 
-    if (flux_name_map.empty()) {
+    flux_name_map.init_once([&]() {
         // --- time_embed (longcat) ---
         flux_name_map["time_embed.timestep_embedder.linear_1.weight"] = "time_in.in_layer.weight";
         flux_name_map["time_embed.timestep_embedder.linear_1.bias"]   = "time_in.in_layer.bias";
@@ -657,7 +737,7 @@ std::string convert_diffusers_dit_to_original_flux(std::string name) {
         flux_name_map["proj_out.bias"]          = "final_layer.linear.bias";
         flux_name_map["norm_out.linear.weight"] = "final_layer.adaLN_modulation.1.weight";
         flux_name_map["norm_out.linear.bias"]   = "final_layer.adaLN_modulation.1.bias";
-    }
+    });
 
     replace_with_prefix_map(name, flux_name_map);
 
@@ -667,9 +747,9 @@ std::string convert_diffusers_dit_to_original_flux(std::string name) {
 std::string convert_hunyuan_video_to_original_flux(std::string name) {
     int num_layers        = 54;
     int num_single_layers = 0;
-    static std::unordered_map<std::string, std::string> hy_name_map;
+    static PrefixNameMap hy_name_map;
 
-    if (hy_name_map.empty()) {
+    hy_name_map.init_once([&]() {
         // --- double transformer blocks ---
         for (int i = 0; i < num_layers; ++i) {
             std::string block_prefix = "double_blocks." + std::to_string(i) + ".";
@@ -699,22 +779,22 @@ std::string convert_hunyuan_video_to_original_flux(std::string name) {
             hy_name_map[block_prefix + "img_attn_proj"] = dst_prefix + "img_attn.proj";
             hy_name_map[block_prefix + "txt_attn_proj"] = dst_prefix + "txt_attn.proj";
         }
-    }
 
-    hy_name_map["time_in.mlp.0"]     = "time_in.in_layer";
-    hy_name_map["time_in.mlp.2"]     = "time_in.out_layer";
-    hy_name_map["time_r_in.mlp.0"]   = "time_r_in.in_layer";
-    hy_name_map["time_r_in.mlp.2"]   = "time_r_in.out_layer";
-    hy_name_map["vector_in.mlp.0"]   = "vector_in.in_layer";
-    hy_name_map["vector_in.mlp.2"]   = "vector_in.out_layer";
-    hy_name_map["guidance_in.mlp.0"] = "guidance_in.in_layer";
-    hy_name_map["guidance_in.mlp.2"] = "guidance_in.out_layer";
+        hy_name_map["time_in.mlp.0"]     = "time_in.in_layer";
+        hy_name_map["time_in.mlp.2"]     = "time_in.out_layer";
+        hy_name_map["time_r_in.mlp.0"]   = "time_r_in.in_layer";
+        hy_name_map["time_r_in.mlp.2"]   = "time_r_in.out_layer";
+        hy_name_map["vector_in.mlp.0"]   = "vector_in.in_layer";
+        hy_name_map["vector_in.mlp.2"]   = "vector_in.out_layer";
+        hy_name_map["guidance_in.mlp.0"] = "guidance_in.in_layer";
+        hy_name_map["guidance_in.mlp.2"] = "guidance_in.out_layer";
 
-    hy_name_map["txt_in.c_embedder.linear_1"] = "txt_in.c_embedder.in_layer";
-    hy_name_map["txt_in.c_embedder.linear_2"] = "txt_in.c_embedder.out_layer";
+        hy_name_map["txt_in.c_embedder.linear_1"] = "txt_in.c_embedder.in_layer";
+        hy_name_map["txt_in.c_embedder.linear_2"] = "txt_in.c_embedder.out_layer";
 
-    hy_name_map["txt_in.t_embedder.mlp.0"] = "txt_in.t_embedder.in_layer";
-    hy_name_map["txt_in.t_embedder.mlp.2"] = "txt_in.t_embedder.out_layer";
+        hy_name_map["txt_in.t_embedder.mlp.0"] = "txt_in.t_embedder.in_layer";
+        hy_name_map["txt_in.t_embedder.mlp.2"] = "txt_in.t_embedder.out_layer";
+    });
 
     replace_with_prefix_map(name, hy_name_map);
 
@@ -733,9 +813,9 @@ std::string convert_hunyuan_video_to_original_flux(std::string name) {
 std::string convert_diffusers_dit_to_original_lumina2(std::string name) {
     int num_layers         = 30;
     int num_refiner_layers = 2;
-    static std::unordered_map<std::string, std::string> z_image_name_map;
+    static PrefixNameMap z_image_name_map;
 
-    if (z_image_name_map.empty()) {
+    z_image_name_map.init_once([&]() {
         z_image_name_map["all_x_embedder.2-1."]  = "x_embedder.";
         z_image_name_map["all_final_layer.2-1."] = "final_layer.";
 
@@ -761,7 +841,7 @@ std::string convert_diffusers_dit_to_original_lumina2(std::string name) {
         add_attention_map("noise_refiner.", num_refiner_layers);
         add_attention_map("context_refiner.", num_refiner_layers);
         add_attention_map("layers.", num_layers);
-    }
+    });
 
     replace_with_prefix_map(name, z_image_name_map);
 
@@ -1107,7 +1187,7 @@ std::string convert_pmid_v2_name(const std::string& name) {
 }
 
 std::string convert_sep_to_dot(std::string name) {
-    const std::vector<std::string> protected_tokens = {
+    static const std::vector<std::string> protected_tokens = {
         "self_attn",
         "out_proj",
         "q_proj",
@@ -1183,23 +1263,27 @@ std::string convert_sep_to_dot(std::string name) {
         "output_proj",
     };
 
+    if (name.find('_') == std::string::npos) {
+        return name;
+    }
+
     // record the positions of underscores that should NOT be replaced
-    std::unordered_set<size_t> protected_positions;
+    std::vector<bool> protected_positions(name.size(), false);
 
     for (const auto& token : protected_tokens) {
         size_t start = 0;
         while ((start = name.find(token, start)) != std::string::npos) {
             size_t local_pos = token.find('_');
             while (local_pos != std::string::npos) {
-                protected_positions.insert(start + local_pos);
-                local_pos = token.find('_', local_pos + 1);
+                protected_positions[start + local_pos] = true;
+                local_pos                              = token.find('_', local_pos + 1);
             }
             start += token.size();
         }
     }
 
     for (size_t i = 0; i < name.size(); ++i) {
-        if (name[i] == '_' && !protected_positions.count(i)) {
+        if (name[i] == '_' && !protected_positions[i]) {
             name[i] = '.';
         }
     }
@@ -1251,9 +1335,9 @@ bool is_first_stage_model_name(const std::string& name) {
 }
 
 static std::string convert_esrgan_tensor_name(std::string name) {
-    static std::unordered_map<std::string, std::string> esrgan_name_map;
+    static PrefixNameMap esrgan_name_map;
 
-    if (esrgan_name_map.empty()) {
+    esrgan_name_map.init_once([&]() {
         esrgan_name_map["model.0."] = "conv_first.";
 
         constexpr int max_num_blocks = 64;
@@ -1279,28 +1363,53 @@ static std::string convert_esrgan_tensor_name(std::string name) {
         esrgan_name_map["model.7."]  = "conv_last.";
         esrgan_name_map["model.8."]  = "conv_hr.";
         esrgan_name_map["model.10."] = "conv_last.";
-    }
+    });
 
     replace_with_prefix_map(name, esrgan_name_map);
     return name;
 }
 
+static std::unordered_map<std::string, std::string> make_tensor_prefix_map(bool flux) {
+    std::unordered_map<std::string, std::string> prefix_map = {
+        {"diffusion_model.", "model.diffusion_model."},
+        {"unet.", "model.diffusion_model."},
+        {"transformer.", "model.diffusion_model."},  // dit
+        {"vae.", "first_stage_model."},
+        {"text_encoder.", "cond_stage_model.transformer."},
+        {"te.", "cond_stage_model.transformer."},
+        {"text_encoder.2.", "cond_stage_model.1.transformer."},
+        {"conditioner.embedders.0.open_clip.", "cond_stage_model."},
+        // https://huggingface.co/stabilityai/stable-diffusion-xl-base-1.0
+        {"conditioner.embedders.0.", "cond_stage_model."},
+        {"conditioner.embedders.1.", "cond_stage_model.1."},
+        // {"te2.text_model.encoder.layers.", "cond_stage_model.1.model.transformer.resblocks."},
+        {"te2.", "cond_stage_model.1.transformer."},
+        {"te1.", "cond_stage_model.transformer."},
+        {"te3.", "text_encoders.t5xxl.transformer."},
+    };
+
+    if (flux) {
+        prefix_map["te1."] = "text_encoders.clip_l.transformer.";
+    }
+    return prefix_map;
+}
+
 std::string convert_tensor_name(std::string name, SDVersion version) {
     if (version == VERSION_ESRGAN) {
         return convert_esrgan_tensor_name(std::move(name));
     }
 
-    bool is_lora                             = false;
-    bool is_lycoris_underline                = false;
-    bool is_underline                        = false;
-    std::vector<std::string> lora_prefix_vec = {
+    bool is_lora                                          = false;
+    bool is_lycoris_underline                             = false;
+    bool is_underline                                     = false;
+    static const std::vector<std::string> lora_prefix_vec = {
         "lora.lora.",
         "lora.lora_",
         "lora.lycoris_",
         "lora.lycoris.",
         "lora.",
     };
-    std::vector<std::string> underline_lora_prefix_vec = {
+    static const std::vector<std::string> underline_lora_prefix_vec = {
         "unet_",
         "te_",
         "te1_",
@@ -1327,7 +1436,7 @@ std::string convert_tensor_name(std::string name, SDVersion version) {
     }
     // preprocess lora tensor name
     if (is_lora) {
-        std::map<std::string, std::string> lora_suffix_map = {
+        static const std::map<std::string, std::string> lora_suffix_map = {
             {".lora_down.weight", ".weight.lora_down"},
             {".lora_mid.weight", ".weight.lora_mid"},
             {".lora_up.weight", ".weight.lora_up"},
@@ -1372,7 +1481,7 @@ std::string convert_tensor_name(std::string name, SDVersion version) {
             name.replace(pos, strlen(".processor"), "");
         }
 
-        std::vector<std::string> dit_prefix_vec = {
+        static const std::vector<std::string> dit_prefix_vec = {
             "transformer_blocks",
             "single_transformer_blocks",
         };
@@ -1390,29 +1499,10 @@ std::string convert_tensor_name(std::string name, SDVersion version) {
         }
     }
 
-    std::unordered_map<std::string, std::string> prefix_map = {
-        {"diffusion_model.", "model.diffusion_model."},
-        {"unet.", "model.diffusion_model."},
-        {"transformer.", "model.diffusion_model."},  // dit
-        {"vae.", "first_stage_model."},
-        {"text_encoder.", "cond_stage_model.transformer."},
-        {"te.", "cond_stage_model.transformer."},
-        {"text_encoder.2.", "cond_stage_model.1.transformer."},
-        {"conditioner.embedders.0.open_clip.", "cond_stage_model."},
-        // https://huggingface.co/stabilityai/stable-diffusion-xl-base-1.0
-        {"conditioner.embedders.0.", "cond_stage_model."},
-        {"conditioner.embedders.1.", "cond_stage_model.1."},
-        // {"te2.text_model.encoder.layers.", "cond_stage_model.1.model.transformer.resblocks."},
-        {"te2.", "cond_stage_model.1.transformer."},
-        {"te1.", "cond_stage_model.transformer."},
-        {"te3.", "text_encoders.t5xxl.transformer."},
-    };
-
-    if (sd_version_is_flux(version)) {
-        prefix_map["te1."] = "text_encoders.clip_l.transformer.";
-    }
+    static const auto prefix_map_default = make_tensor_prefix_map(false);
+    static const auto prefix_map_flux    = make_tensor_prefix_map(true);
 
-    replace_with_prefix_map(name, prefix_map);
+    replace_with_prefix_map(name, sd_version_is_flux(version) ? prefix_map_flux : prefix_map_default);
 
     if (sd_version_is_boogu_image(version) || sd_version_is_krea2(version) || sd_version_is_mage_flow(version)) {
         const std::string hf_vision_prefix = "text_encoders.llm.model.visual.";
@@ -0,0 +1,124 @@
+#include "runtime/encode-cache.h"
+
+#include <cstring>
+
+#include "core/util.h"
+
+void EncodeCache::set_max_bytes(size_t max_bytes) {
+    max_bytes_ = max_bytes;
+    evict_to(max_bytes_);
+}
+
+void EncodeCache::clear() {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+static inline uint64_t hash_mix(uint64_t h, uint64_t word) {
+    h ^= word * 0x87c37b91114253d5ull;
+    h = (h << 31) | (h >> 33);
+    return h * 0x4cf5ad432745937full;
+}
+
+// Different multipliers and rotation than hash_mix, so the check hash does
+// not collide together with the key hash.
+static inline uint64_t check_mix(uint64_t h, uint64_t word) {
+    h ^= word * 0x9fb21c651e98df25ull;
+    h = (h << 27) | (h >> 37);
+    return h * 0xd6e8feb86659fd93ull;
+}
+
+static inline uint64_t hash_finalize(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+EncodeCache::InputId EncodeCache::identify(const sd::Tensor<float>& tensor) {
+    InputId id;
+    id.shape = tensor.shape();
+
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    uint64_t c = 0x165667b19e3779f9ull;
+    for (int64_t dim : id.shape) {
+        h = hash_mix(h, static_cast<uint64_t>(dim));
+        c = check_mix(c, static_cast<uint64_t>(dim));
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(tensor.data());
+    const size_t size    = static_cast<size_t>(tensor.numel()) * sizeof(float);
+    // Two independent lanes per hash keep the multiplies of neighbouring
+    // words from serializing on each other.
+    uint64_t h0 = h;
+    uint64_t h1 = h ^ 0xc2b2ae3d27d4eb4full;
+    uint64_t c0 = c;
+    uint64_t c1 = c ^ 0x27d4eb2f165667c5ull;
+    size_t pos  = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        uint64_t w0;
+        uint64_t w1;
+        memcpy(&w0, bytes + pos, sizeof(w0));
+        memcpy(&w1, bytes + pos + 8, sizeof(w1));
+        h0 = hash_mix(h0, w0);
+        h1 = hash_mix(h1, w1);
+        c0 = check_mix(c0, w0);
+        c1 = check_mix(c1, w1);
+    }
+    if (pos < size) {
+        uint64_t tail = 0;
+        memcpy(&tail, bytes + pos, size - pos);
+        h0 = hash_mix(h0, tail);
+        c0 = check_mix(c0, tail);
+    }
+
+    id.hash  = hash_finalize(hash_mix(h0, h1 ^ size));
+    id.check = hash_finalize(check_mix(c0, c1 ^ size));
+    return id;
+}
+
+bool EncodeCache::lookup(const std::string& key, const InputId& input, sd::Tensor<float>* value) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return false;
+    }
+    if (!(it->second->input == input)) {
+        LOG_WARN("encode cache: key collision on '%s', encoding again", key.c_str());
+        ++misses_;
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *value = it->second->value;
+    ++hits_;
+    return true;
+}
+
+void EncodeCache::insert(const std::string& key, const InputId& input, const sd::Tensor<float>& value) {
+    const size_t nbytes = static_cast<size_t>(value.numel()) * sizeof(float) + key.size() +
+                          input.shape.size() * sizeof(int64_t);
+    if (nbytes > max_bytes_ || value.empty()) {
+        return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->nbytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+    evict_to(max_bytes_ - nbytes);
+    entries_.push_front({key, input, value, nbytes});
+    index_[key] = entries_.begin();
+    bytes_ += nbytes;
+}
+
+void EncodeCache::evict_to(size_t max_bytes) {
+    while (bytes_ > max_bytes && !entries_.empty()) {
+        bytes_ -= entries_.back().nbytes;
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
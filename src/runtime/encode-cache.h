@@ -0,0 +1,74 @@
+#ifndef __SD_RUNTIME_ENCODE_CACHE_H__
+#define __SD_RUNTIME_ENCODE_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/tensor.hpp"
+
+// Encoder outputs for input images (VAE moments, vision embeddings) of
+// recent requests, most recently used first, within a byte budget. Edit
+// loops resend the same source image with every variant; a hit skips the
+// encode. Callers build keys from whatever selects the encoder output (which
+// encoder, its settings) plus the hash of the identify()'d preprocessed
+// input, which already reflects the target size and resize mode. Entries
+// also keep the input's shape and a second, independent hash that lookup()
+// compares, so a key collision between requests sharing the context is a
+// miss rather than another request's output.
+class EncodeCache {
+public:
+    struct InputId {
+        std::vector<int64_t> shape;
+        uint64_t hash  = 0;  // goes into the key
+        uint64_t check = 0;  // verified on lookup
+
+        bool operator==(const InputId& other) const {
+            return hash == other.hash && check == other.check && shape == other.shape;
+        }
+    };
+
+    void set_max_bytes(size_t max_bytes);
+    bool enabled() const {
+        return max_bytes_ > 0;
+    }
+    // Drops every entry, e.g. when LoRAs change the encoder weights.
+    void clear();
+
+    static InputId identify(const sd::Tensor<float>& tensor);
+
+    bool lookup(const std::string& key, const InputId& input, sd::Tensor<float>* value);
+    void insert(const std::string& key, const InputId& input, const sd::Tensor<float>& value);
+
+    size_t bytes() const {
+        return bytes_;
+    }
+    size_t hits() const {
+        return hits_;
+    }
+    size_t misses() const {
+        return misses_;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        InputId input;
+        sd::Tensor<float> value;
+        size_t nbytes = 0;
+    };
+
+    void evict_to(size_t max_bytes);
+
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t max_bytes_ = 0;
+    size_t bytes_     = 0;
+    size_t hits_      = 0;
+    size_t misses_    = 0;
+};
+
+#endif  // __SD_RUNTIME_ENCODE_CACHE_H__
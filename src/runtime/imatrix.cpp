@@ -36,6 +36,10 @@ static std::string filter_tensor_name(const char* name) {
     return wname;
 }
 
+static bool is_imatrix_weight_name(const std::string& wname) {
+    return wname.substr(0, 6) == "model." || wname.substr(0, 17) == "cond_stage_model." || wname.substr(0, 14) == "text_encoders.";
+}
+
 bool IMatrixCollector::collect_imatrix(struct ggml_tensor* t, bool ask, void* user_data) {
     GGML_UNUSED(user_data);
     if (t == nullptr) {
@@ -60,10 +64,7 @@ bool IMatrixCollector::collect_imatrix(struct ggml_tensor* t, bool ask, void* us
         }
         // why are small batches ignored (<16 tokens)?
         // if (src1->ne[1] < 16 || src1->type != GGML_TYPE_F32) return false;
-        if (!(wname.substr(0, 6) == "model." || wname.substr(0, 17) == "cond_stage_model." || wname.substr(0, 14) == "text_encoders.")) {
-            return false;
-        }
-        return true;
+        return is_imatrix_weight_name(wname);
     }
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -172,15 +173,62 @@ void save_imatrix(const char* imatrix_path) {
     imatrix_collector.save_imatrix(imatrix_path);
 }
 
+void IMatrixCollector::add_column_sums(const std::string& wname, const float* sums, int64_t n_cols, int64_t n_rows) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& e = stats_[wname];
+    if (e.values.empty()) {
+        e.values.resize(n_cols, 0);
+        e.counts.resize(n_cols, 0);
+    } else if (e.values.size() != (size_t)n_cols) {
+        LOG_WARN("inconsistent size for %s (%d vs %d)\n", wname.c_str(), (int)e.values.size(), (int)n_cols);
+        exit(1);  // GGML_ABORT("fatal error");
+    }
+
+    ++e.ncall;
+    for (int64_t j = 0; j < n_cols; ++j) {
+        // The reduction ran on the device, so a non-finite input poisons the
+        // whole column of this call; drop it like the per-row path drops
+        // individual non-finite values.
+        if (!std::isfinite(sums[j])) {
+            continue;
+        }
+        e.values[j] += sums[j];
+        e.counts[j] += (int)n_rows;
+        if (!std::isfinite(e.values[j])) {
+            LOG_WARN("%f detected in %s\n", e.values[j], wname.c_str());
+            exit(1);
+        }
+    }
+}
+
 static bool collect_imatrix(struct ggml_tensor* t, bool ask, void* user_data) {
+    // Plain matmuls are reduced inside the graph (see below); only the
+    // expert matmuls still need the per-node host callback.
+    if (ask && t != nullptr && t->op != GGML_OP_MUL_MAT_ID) {
+        return false;
+    }
     return imatrix_collector.collect_imatrix(t, ask, user_data);
 }
 
+static bool imatrix_matmul_stats_filter(const struct ggml_tensor* mul_mat) {
+    const struct ggml_tensor* src0 = mul_mat->src[0];
+    return src0 != nullptr && is_imatrix_weight_name(filter_tensor_name(src0->name));
+}
+
+static void imatrix_matmul_stats_sink(const struct ggml_tensor* mul_mat,
+                                      const float* col_sums,
+                                      int64_t n_cols,
+                                      int64_t n_rows) {
+    imatrix_collector.add_column_sums(filter_tensor_name(mul_mat->src[0]->name), col_sums, n_cols, n_rows);
+}
+
 void enable_imatrix_collection() {
+    sd_set_matmul_stats_callbacks(imatrix_matmul_stats_filter, imatrix_matmul_stats_sink);
     sd_set_backend_eval_callback(collect_imatrix, nullptr);
 }
 
 void disable_imatrix_collection() {
+    sd_set_matmul_stats_callbacks(nullptr, nullptr);
     sd_set_backend_eval_callback(nullptr, nullptr);
 }
 
@@ -1,6 +1,7 @@
 #ifndef __SD_RUNTIME_IMATRIX_H__
 #define __SD_RUNTIME_IMATRIX_H__
 
+#include <cstdint>
 #include <fstream>
 #include <mutex>
 #include <string>
@@ -28,6 +29,9 @@ private:
 public:
     IMatrixCollector() = default;
     bool collect_imatrix(struct ggml_tensor* t, bool ask, void* user_data);
+    // Accumulates per-column sums of squared activations over n_rows rows,
+    // as produced by the in-graph matmul statistics.
+    void add_column_sums(const std::string& wname, const float* sums, int64_t n_cols, int64_t n_rows);
     void save_imatrix(std::string fname, int ncall = -1) const;
     bool load_imatrix(const char* fname);
     std::vector<float> get_values(const std::string& key) const {
@@ -0,0 +1,68 @@
+#include "runtime/preview-worker.h"
+
+#include <utility>
+
+PreviewWorker::PreviewWorker(DecodeFn decode)
+    : decode_(std::move(decode)) {
+    thread_ = std::thread([this]() { run(); });
+}
+
+PreviewWorker::~PreviewWorker() {
+    stop(false);
+}
+
+void PreviewWorker::submit(int step, const sd::Tensor<float>& latent, bool is_noisy) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        if (has_pending_) {
+            ++dropped_;
+        }
+        pending_step_   = step;
+        pending_noisy_  = is_noisy;
+        pending_latent_ = latent;
+        has_pending_    = true;
+    }
+    cv_.notify_one();
+}
+
+void PreviewWorker::stop(bool drain_pending) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_) {
+            stopping_ = true;
+            drain_    = drain_pending;
+        }
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PreviewWorker::run() {
+    while (true) {
+        int step      = 0;
+        bool is_noisy = false;
+        sd::Tensor<float> latent;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return has_pending_ || stopping_; });
+            if (!has_pending_ || (stopping_ && !drain_)) {
+                if (has_pending_) {
+                    ++dropped_;
+                    has_pending_ = false;
+                }
+                return;
+            }
+            step         = pending_step_;
+            is_noisy     = pending_noisy_;
+            latent       = std::move(pending_latent_);
+            has_pending_ = false;
+        }
+        decode_(step, latent, is_noisy);
+        ++decoded_;
+    }
+}
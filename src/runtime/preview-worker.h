@@ -0,0 +1,55 @@
+#ifndef __SD_RUNTIME_PREVIEW_WORKER_H__
+#define __SD_RUNTIME_PREVIEW_WORKER_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "core/tensor.hpp"
+
+// Decodes sampling previews on a thread of its own. Only one latent waits at
+// a time: submit() replaces a snapshot that was not picked up yet, so a
+// decoder slower than the sampler skips steps instead of stalling it.
+class PreviewWorker {
+public:
+    using DecodeFn = std::function<void(int step, const sd::Tensor<float>& latent, bool is_noisy)>;
+
+    explicit PreviewWorker(DecodeFn decode);
+    ~PreviewWorker();
+
+    PreviewWorker(const PreviewWorker&)            = delete;
+    PreviewWorker& operator=(const PreviewWorker&) = delete;
+
+    void submit(int step, const sd::Tensor<float>& latent, bool is_noisy);
+    // Joins the thread. With drain_pending the waiting snapshot is decoded
+    // first, so the last preview matches the last step; otherwise it is
+    // dropped.
+    void stop(bool drain_pending);
+
+    size_t decoded() const {
+        return decoded_;
+    }
+    size_t dropped() const {
+        return dropped_;
+    }
+
+private:
+    void run();
+
+    DecodeFn decode_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool has_pending_   = false;
+    bool stopping_      = false;
+    bool drain_         = false;
+    int pending_step_   = 0;
+    bool pending_noisy_ = false;
+    sd::Tensor<float> pending_latent_;
+    size_t decoded_ = 0;
+    size_t dropped_ = 0;
+};
+
+#endif  // __SD_RUNTIME_PREVIEW_WORKER_H__
@@ -1,7 +1,9 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <list>
 #include <set>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
 #include <utility>
@@ -18,6 +20,7 @@
 #include "model_loader.h"
 #include "model_manager.h"
 #include "stable-diffusion.h"
+#include "weight_registry.h"
 
 #include "conditioning/conditioner.hpp"
 #include "core/backend_fit.h"
@@ -57,11 +60,13 @@
 #include "model/vae/wan_vae.hpp"
 #include "runtime/denoiser.hpp"
 #include "runtime/guidance.h"
+#include "runtime/encode-cache.h"
 #include "runtime/sample-cache.h"
 #include "upscaler.h"
 
 #include "name_conversion.h"
 #include "runtime/latent-preview.h"
+#include "runtime/preview-worker.h"
 
 #include <atomic>
 
@@ -218,18 +223,29 @@ public:
     std::shared_ptr<DiffusionModelRunner> diffusion_model;
     std::shared_ptr<DiffusionModelRunner> high_noise_diffusion_model;
     std::shared_ptr<VAE> first_stage_model;
+    // Backend instance of the preview-only TAE, so previews can decode while
+    // the diffusion model samples on the shared VAE/diffusion backend.
+    SDBackendHandle preview_vae_backend;
     std::shared_ptr<VAE> preview_vae;
+    static constexpr int MIN_THREADS_FOR_CONCURRENT_AUDIO_DECODE = 4;
+    // CPU backend owned by the audio VAE alone, so its decode can overlap the
+    // video VAE decode; null when the audio VAE shares the VAE backend.
+    SDBackendHandle audio_vae_backend;
     std::shared_ptr<LTXV::LTXAudioVAERunner> audio_vae_model;
     std::shared_ptr<ControlNet> control_net;
     std::vector<std::shared_ptr<GenerationExtension>> generation_extensions;
     std::vector<std::shared_ptr<LoraModel>> runtime_lora_models;
     bool apply_lora_immediately = false;
+    bool f8_weights_requantized = false;
     bool animatediff_loaded     = false;
     int animatediff_num_frames  = 0;
 
     std::string taesd_path;
     sd_tiling_params_t vae_tiling_params = {false, false, 0, 0, 0.5f, 0, 0, nullptr};
     bool enable_mmap                     = false;
+    int64_t last_step_major_faults       = -1;
+    sd_numa_mode_t numa_mode             = SD_NUMA_DISABLED;
+    size_t diffusion_params_mem_size     = 0;
     sd::ggml_graph_cut::MaxVramAssignment max_vram_assignment;
     bool stream_layers = false;
     bool eager_load    = false;
@@ -247,6 +263,28 @@ public:
 
     std::shared_ptr<ModelManager> model_manager;
 
+    // Parsed at_runtime LoRAs of recent requests, most recently used first.
+    struct CachedLoraModel {
+        std::string key;
+        std::shared_ptr<LoraModel> lora;
+        size_t nbytes = 0;
+    };
+    std::list<CachedLoraModel> lora_model_cache;
+    size_t lora_model_cache_max_bytes = 0;
+    size_t lora_model_cache_bytes     = 0;
+
+    // VAE moments and vision embeddings of recent input images. LoRAs can
+    // change every encoder, so the cache is dropped when the applied set
+    // differs from the one its entries were computed with.
+    EncodeCache encode_cache;
+    std::string encode_cache_lora_key;
+
+    // Hires-fix model upscaler, kept loaded across requests that use the
+    // same model file. Keyed by file identity, so a file replaced at the
+    // same path is loaded again.
+    std::unique_ptr<UpscalerGGML> hires_upscaler;
+    std::string hires_upscaler_file_id;
+
     std::shared_ptr<Denoiser> denoiser = std::make_shared<CompVisDenoiser>();
     std::vector<float> file_alphas_cumprod;
 
@@ -288,6 +326,32 @@ public:
         return max_vram_assignment.bytes_for_backend(backend_for(module));
     }
 
+    UpscalerGGML* get_hires_upscaler(const std::string& model_path, int tile_size) {
+        std::string file_id = SharedWeightRegistry::file_identity(model_path);
+        if (hires_upscaler != nullptr && !file_id.empty() && hires_upscaler_file_id == file_id) {
+            LOG_INFO("hires fix: reusing resident model upscaler '%s'", model_path.c_str());
+            hires_upscaler->tile_size = tile_size;
+            return hires_upscaler.get();
+        }
+        hires_upscaler.reset();
+        hires_upscaler_file_id.clear();
+
+        LOG_INFO("hires fix: loading model upscaler from '%s'", model_path.c_str());
+        auto upscaler = std::make_unique<UpscalerGGML>(n_threads,
+                                                       false,
+                                                       tile_size,
+                                                       backend_spec,
+                                                       params_backend_spec);
+        upscaler->set_max_graph_vram_bytes(max_graph_vram_bytes_for_module(SDBackendModule::UPSCALER));
+        if (!upscaler->load_from_file(model_path, n_threads)) {
+            LOG_ERROR("load hires model upscaler failed");
+            return nullptr;
+        }
+        hires_upscaler         = std::move(upscaler);
+        hires_upscaler_file_id = file_id;
+        return hires_upscaler.get();
+    }
+
     std::vector<size_t> layer_split_vram_limits_for_backends(const std::vector<ggml_backend_t>& backends) {
         std::vector<size_t> limits;
         limits.reserve(backends.size());
@@ -667,6 +731,45 @@ public:
         LOG_DEBUG("loaded alphas_cumprod from model file");
     }
 
+    // FP8 (e4m3/e5m2) weights have no ggml type and are widened to f16 by
+    // default, which is exact but twice their size on disk. A compact type
+    // such as q8_0 can be opted into, globally or per module; it rounds small
+    // weights of a block more coarsely than e4m3 does.
+    bool apply_f8_weight_type(ModelLoader& model_loader, const std::string& spec) {
+        SDBackendAssignment assignment;
+        std::string error;
+        if (!sd_parse_backend_assignment(spec, &assignment, &error)) {
+            LOG_ERROR("invalid FP8 weight type '%s': %s", spec.c_str(), error.c_str());
+            return false;
+        }
+        if (assignment.default_name.empty()) {
+            assignment.set_default("f16");
+        }
+
+        const std::pair<SDBackendModule, bool (*)(const std::string&)> targets[] = {
+            {SDBackendModule::TE, is_cond_stage_model_name},
+            {SDBackendModule::DIFFUSION, is_diffusion_model_name},
+            {SDBackendModule::VAE, is_first_stage_model_name},
+        };
+        for (const auto& target : targets) {
+            std::string type_name = assignment.get(target.first);
+            if (type_name == "f16") {
+                continue;
+            }
+            sd_type_t type = str_to_sd_type(type_name.c_str());
+            if (type == SD_TYPE_COUNT) {
+                LOG_ERROR("invalid FP8 weight type '%s' for %s", type_name.c_str(), sd_backend_module_name(target.first));
+                return false;
+            }
+            size_t count = model_loader.requantize_f8_weights(sd_type_to_ggml_type(type), target.second);
+            if (count > 0) {
+                LOG_INFO("loading %zu FP8 %s weights as %s", count, sd_backend_module_name(target.first), type_name.c_str());
+                f8_weights_requantized = f8_weights_requantized || ggml_is_quantized(sd_type_to_ggml_type(type));
+            }
+        }
+        return true;
+    }
+
     bool init(const sd_ctx_params_t* sd_ctx_params) {
         n_threads           = sd_ctx_params->n_threads;
         enable_mmap         = sd_ctx_params->enable_mmap;
@@ -676,6 +779,7 @@ public:
         params_backend_spec = SAFE_STR(sd_ctx_params->params_backend);
         split_mode_spec     = SAFE_STR(sd_ctx_params->split_mode);
         auto_fit_enabled    = sd_ctx_params->auto_fit;
+        numa_mode           = sd_ctx_params->numa;
         max_vram_assignment.reset(0.f);
         {
             std::string error;
@@ -701,9 +805,20 @@ public:
 
         ggml_log_set(ggml_log_callback_default, nullptr);
 
+        if (numa_mode != SD_NUMA_DISABLED) {
+            LOG_INFO("using NUMA mode '%s'", sd_numa_mode_name(numa_mode));
+            if (!sd_backend_cpu_numa_init(numa_mode)) {
+                LOG_WARN("failed to initialize NUMA mode '%s'", sd_numa_mode_name(numa_mode));
+            }
+        }
+
         model_manager = std::make_shared<ModelManager>();
         model_manager->set_n_threads(n_threads);
         model_manager->set_enable_mmap(enable_mmap);
+        model_manager->set_numa_mode(numa_mode);
+        lora_model_cache_max_bytes = (size_t)std::max(0, sd_ctx_params->lora_cache_size) * 1024 * 1024;
+        model_manager->set_merged_lora_cache_bytes(lora_model_cache_max_bytes);
+        encode_cache.set_max_bytes((size_t)std::max(0, sd_ctx_params->encode_cache_size) * 1024 * 1024);
         ModelLoader& model_loader = model_manager->loader();
 
         if (strlen(SAFE_STR(sd_ctx_params->model_path)) > 0) {
@@ -857,6 +972,9 @@ public:
         if (wtype != GGML_TYPE_COUNT || tensor_type_rules.size() > 0) {
             model_loader.set_wtype_override(wtype, tensor_type_rules);
         }
+        if (!apply_f8_weight_type(model_loader, SAFE_STR(sd_ctx_params->f8_weight_type))) {
+            return false;
+        }
 
         if (auto_fit_enabled) {
             if (!sd::backend_fit::derive_backend_specs(model_loader,
@@ -915,7 +1033,7 @@ public:
 
         if (sd_ctx_params->lora_apply_mode == LORA_APPLY_AUTO) {
             bool have_quantized_weight = false;
-            if (wtype != GGML_TYPE_COUNT && ggml_is_quantized(wtype)) {
+            if ((wtype != GGML_TYPE_COUNT && ggml_is_quantized(wtype)) || f8_weights_requantized) {
                 have_quantized_weight = true;
             } else {
                 for (const auto& [type, _] : wtype_stat) {
@@ -1298,9 +1416,9 @@ public:
                 return false;
             }
 
-            auto create_tae = [&](bool decode_only) -> std::shared_ptr<VAE> {
+            auto create_tae = [&](bool decode_only, ggml_backend_t backend) -> std::shared_ptr<VAE> {
                 if (sd_version_uses_wan_vae(version) || sd_version_is_hunyuan_video(version) || sd_version_is_ltxav(version)) {
-                    return std::make_shared<TinyVideoAutoEncoder>(backend_for(SDBackendModule::VAE),
+                    return std::make_shared<TinyVideoAutoEncoder>(backend,
                                                                   tensor_storage_map,
                                                                   "decoder",
                                                                   decode_only,
@@ -1308,7 +1426,7 @@ public:
                                                                   model_manager);
 
                 } else {
-                    auto model = std::make_shared<TinyImageAutoEncoder>(backend_for(SDBackendModule::VAE),
+                    auto model = std::make_shared<TinyImageAutoEncoder>(backend,
                                                                         tensor_storage_map,
                                                                         "decoder.layers",
                                                                         decode_only,
@@ -1389,7 +1507,7 @@ public:
                 }
             } else if (use_tae && !tae_preview_only) {
                 LOG_INFO("using TAE for encoding / decoding");
-                first_stage_model = create_tae(false);
+                first_stage_model = create_tae(false, backend_for(SDBackendModule::VAE));
                 first_stage_model->set_max_graph_vram_bytes(max_graph_vram_bytes_for_module(SDBackendModule::VAE));
                 if (!register_runner_params("VAE",
                                             first_stage_model,
@@ -1409,26 +1527,58 @@ public:
                 }
                 if (use_tae && tae_preview_only) {
                     LOG_INFO("using TAE for preview");
-                    preview_vae = create_tae(true);
+                    if (backend_manager.params_backend_follows_runtime(SDBackendModule::VAE)) {
+                        preview_vae_backend = backend_manager.create_private_runtime_backend(SDBackendModule::VAE);
+                    }
+                    ggml_backend_t preview_backend = preview_vae_backend ? preview_vae_backend.get() : backend_for(SDBackendModule::VAE);
+                    preview_vae                    = create_tae(true, preview_backend);
                     preview_vae->set_max_graph_vram_bytes(max_graph_vram_bytes_for_module(SDBackendModule::VAE));
-                    if (!register_runner_params("preview VAE",
-                                                preview_vae,
-                                                SDBackendModule::VAE,
-                                                &vae_params_mem_size)) {
+                    bool preview_vae_registered = false;
+                    if (preview_vae_backend) {
+                        preview_vae_registered = model_manager->register_runner_params("preview VAE",
+                                                                                       *preview_vae,
+                                                                                       ModelManager::ResidencyMode::ParamBackend,
+                                                                                       preview_backend,
+                                                                                       preview_backend,
+                                                                                       &vae_params_mem_size);
+                    } else {
+                        preview_vae_registered = register_runner_params("preview VAE",
+                                                                        preview_vae,
+                                                                        SDBackendModule::VAE,
+                                                                        &vae_params_mem_size);
+                    }
+                    if (!preview_vae_registered) {
                         return false;
                     }
                 }
             }
 
             if (use_audio_vae) {
-                audio_vae_model = std::make_shared<LTXV::LTXAudioVAERunner>(backend_for(SDBackendModule::VAE),
-                                                                            tensor_storage_map,
-                                                                            "",
-                                                                            model_manager);
-                if (!register_runner_params("LTX audio VAE",
-                                            audio_vae_model,
-                                            SDBackendModule::VAE,
-                                            &vae_params_mem_size)) {
+                if (n_threads >= MIN_THREADS_FOR_CONCURRENT_AUDIO_DECODE &&
+                    backend_manager.runtime_backend_is_cpu(SDBackendModule::VAE) &&
+                    backend_manager.params_backend_follows_runtime(SDBackendModule::VAE)) {
+                    audio_vae_backend = backend_manager.create_private_runtime_backend(SDBackendModule::VAE);
+                }
+                ggml_backend_t audio_backend = audio_vae_backend ? audio_vae_backend.get() : backend_for(SDBackendModule::VAE);
+                audio_vae_model              = std::make_shared<LTXV::LTXAudioVAERunner>(audio_backend,
+                                                                                         tensor_storage_map,
+                                                                                         "",
+                                                                                         model_manager);
+                bool audio_vae_registered = false;
+                if (audio_vae_backend) {
+                    audio_vae_registered = model_manager->register_runner_params("LTX audio VAE",
+                                                                                 *audio_vae_model,
+                                                                                 ModelManager::ResidencyMode::ParamBackend,
+                                                                                 audio_backend,
+                                                                                 audio_backend,
+                                                                                 &vae_params_mem_size);
+                } else {
+                    audio_vae_registered = register_runner_params("LTX audio VAE",
+                                                                  audio_vae_model,
+                                                                  SDBackendModule::VAE,
+                                                                  &vae_params_mem_size);
+                }
+                if (!audio_vae_registered) {
                     return false;
                 }
             }
@@ -1638,6 +1788,7 @@ public:
                 params_memory_location(control_net_params_mem_size, SDBackendModule::CONTROL_NET),
                 extension_params_mem_size / 1024.0 / 1024.0,
                 params_memory_location(extension_params_mem_size, SDBackendModule::PHOTOMAKER));
+            diffusion_params_mem_size = unet_params_mem_size;
         }
 
         // init denoiser
@@ -1843,6 +1994,114 @@ public:
         return lora;
     }
 
+    // Same file (device, inode, size, mtime), same module and same tensor
+    // selection give the same parsed LoRA; the multiplier is set per use.
+    std::string lora_model_cache_key(const ModelManager::LoraSpec& lora_spec, SDBackendModule module) {
+        std::string file_id = SharedWeightRegistry::file_identity(lora_spec.path);
+        if (file_id.empty()) {
+            return "";
+        }
+        return sd_format("%s|%d|%s|%d|%s|%s",
+                         file_id.c_str(),
+                         (int)version,
+                         sd_backend_module_name(module),
+                         lora_spec.is_high_noise ? 1 : 0,
+                         lora_spec.tensor_name_prefix_filter.c_str(),
+                         lora_spec.path.c_str());
+    }
+
+    std::shared_ptr<LoraModel> acquire_lora_model(const ModelManager::LoraSpec& lora_spec,
+                                                  SDBackendModule module,
+                                                  LoraModel::filter_t module_filter = nullptr) {
+        std::string key = lora_model_cache_max_bytes > 0 ? lora_model_cache_key(lora_spec, module) : "";
+        if (!key.empty()) {
+            auto it = std::find_if(lora_model_cache.begin(),
+                                   lora_model_cache.end(),
+                                   [&key](const CachedLoraModel& entry) { return entry.key == key; });
+            // The same LoRA listed twice in one request needs its own
+            // instance, since the multiplier lives on the model.
+            if (it != lora_model_cache.end() &&
+                std::find(runtime_lora_models.begin(), runtime_lora_models.end(), it->lora) == runtime_lora_models.end()) {
+                lora_model_cache.splice(lora_model_cache.begin(), lora_model_cache, it);
+                auto lora        = lora_model_cache.front().lora;
+                lora->multiplier = lora_spec.multiplier;
+                LOG_DEBUG("using cached lora %s", lora_log_id(lora_spec).c_str());
+                return lora;
+            }
+        }
+
+        auto lora = load_lora_model(lora_spec, module, module_filter);
+        if (lora == nullptr || key.empty()) {
+            return lora;
+        }
+        size_t nbytes = 0;
+        for (const auto& pair : lora->lora_tensors) {
+            nbytes += ggml_nbytes(pair.second);
+        }
+        if (nbytes > lora_model_cache_max_bytes) {
+            return lora;
+        }
+        lora_model_cache.erase(std::remove_if(lora_model_cache.begin(),
+                                              lora_model_cache.end(),
+                                              [&key](const CachedLoraModel& entry) { return entry.key == key; }),
+                               lora_model_cache.end());
+        lora_model_cache.push_front({key, lora, nbytes});
+        lora_model_cache_bytes = 0;
+        for (const auto& entry : lora_model_cache) {
+            lora_model_cache_bytes += entry.nbytes;
+        }
+        while (lora_model_cache_bytes > lora_model_cache_max_bytes) {
+            lora_model_cache_bytes -= lora_model_cache.back().nbytes;
+            lora_model_cache.pop_back();
+        }
+        return lora;
+    }
+
+    bool preload_loras(const sd_lora_t* loras, uint32_t lora_count) {
+        if (apply_lora_immediately) {
+            LOG_WARN("lora preload only applies to the at_runtime lora apply mode");
+            return false;
+        }
+        if (lora_model_cache_max_bytes == 0) {
+            LOG_WARN("lora preload needs a lora cache size");
+            return false;
+        }
+
+        std::set<std::string> model_tensor_names;
+        if (model_manager != nullptr) {
+            model_tensor_names = model_manager->tensor_names();
+        }
+        std::vector<std::pair<SDBackendModule, LoraModel::filter_t>> targets;
+        if (cond_stage_model) {
+            targets.push_back({SDBackendModule::TE, is_cond_stage_model_name});
+        }
+        if (diffusion_model) {
+            targets.push_back({SDBackendModule::DIFFUSION, is_diffusion_model_name});
+        }
+        if (first_stage_model) {
+            targets.push_back({SDBackendModule::VAE, is_first_stage_model_name});
+        }
+
+        bool ok = true;
+        for (uint32_t i = 0; i < lora_count; i++) {
+            ModelManager::LoraSpec lora_spec;
+            lora_spec.path          = SAFE_STR(loras[i].path);
+            lora_spec.multiplier    = loras[i].multiplier;
+            lora_spec.is_high_noise = loras[i].is_high_noise;
+            for (const auto& target : targets) {
+                auto lora = acquire_lora_model(lora_spec, target.first, target.second);
+                if (lora == nullptr) {
+                    LOG_WARN("preload lora failed: %s", lora_spec.path.c_str());
+                    ok = false;
+                    break;
+                }
+                lora->preprocess_lora_tensors(model_tensor_names);
+            }
+        }
+        LOG_INFO("lora cache: %zu entries, %.2f MB", lora_model_cache.size(), lora_model_cache_bytes / (1024.0 * 1024.0));
+        return ok;
+    }
+
     void clear_lora_adapters() {
         if (cond_stage_model) {
             cond_stage_model->set_weight_adapter(nullptr);
@@ -1864,7 +2123,7 @@ public:
                                                                           LoraModel::filter_t module_filter = nullptr) {
         std::vector<std::shared_ptr<LoraModel>> module_lora_models;
         for (const auto& lora_spec : loras) {
-            auto lora = load_lora_model(lora_spec, module, module_filter);
+            auto lora = acquire_lora_model(lora_spec, module, module_filter);
             if (lora == nullptr) {
                 if (lora_spec.required) {
                     LOG_ERROR("required lora load failed: %s", lora_spec.path.c_str());
@@ -2001,6 +2260,22 @@ public:
             extension->collect_loras(all_loras);
         }
 
+        if (encode_cache.enabled()) {
+            std::string lora_key;
+            for (const auto& lora_spec : all_loras) {
+                lora_key += sd_format("%s|%s|%.6f|%d|%s;",
+                                      lora_spec.path.c_str(),
+                                      SharedWeightRegistry::file_identity(lora_spec.path).c_str(),
+                                      lora_spec.multiplier,
+                                      lora_spec.is_high_noise ? 1 : 0,
+                                      lora_spec.tensor_name_prefix_filter.c_str());
+            }
+            if (lora_key != encode_cache_lora_key) {
+                encode_cache.clear();
+                encode_cache_lora_key = std::move(lora_key);
+            }
+        }
+
         int64_t t0 = ggml_time_ms();
         if (apply_lora_immediately) {
             apply_loras_immediately(all_loras);
@@ -2051,12 +2326,28 @@ public:
             }
         } else {
             auto pixel_values = clip_preprocess(image, clip_vision->vision_model.image_size, clip_vision->vision_model.image_size);
-            auto output_opt   = clip_vision->compute(n_threads, pixel_values, return_pooled, clip_skip);
+            std::string cache_key;
+            EncodeCache::InputId input_id;
+            if (encode_cache.enabled()) {
+                input_id  = EncodeCache::identify(pixel_values);
+                cache_key = sd_format("clip_vision|%d|%d|%016llx",
+                                      return_pooled ? 1 : 0,
+                                      clip_skip,
+                                      (unsigned long long)input_id.hash);
+                if (encode_cache.lookup(cache_key, input_id, &output)) {
+                    LOG_DEBUG("using cached clip_vision output");
+                    return output;
+                }
+            }
+            auto output_opt = clip_vision->compute(n_threads, pixel_values, return_pooled, clip_skip);
             if (output_opt.empty()) {
                 LOG_ERROR("clip_vision compute failed");
                 return {};
             }
             output = std::move(output_opt);
+            if (!cache_key.empty()) {
+                encode_cache.insert(cache_key, input_id, output);
+            }
         }
         return output;
     }
@@ -2123,13 +2414,30 @@ public:
         return video_timesteps;
     }
 
+    // Average-pools the spatial dims of VAE latents; the preview decode cost
+    // shrinks with the square of the factor.
+    static sd::Tensor<float> downscale_preview_latents(const sd::Tensor<float>& latents, int downscale) {
+        if (downscale <= 1 || latents.dim() < 2) {
+            return latents;
+        }
+        std::vector<int64_t> shape = latents.shape();
+        shape[0]                   = std::max<int64_t>(1, shape[0] / downscale);
+        shape[1]                   = std::max<int64_t>(1, shape[1] / downscale);
+        if (shape == latents.shape()) {
+            return latents;
+        }
+        return sd::ops::interpolate(latents, shape, sd::ops::InterpolateMode::NearestAvg);
+    }
+
     void preview_image(int step,
                        const sd::Tensor<float>& latents,
                        enum SDVersion version,
                        preview_t preview_mode,
                        std::function<void(int, int, sd_image_t*, bool, void*)> step_callback,
                        void* step_callback_data,
-                       bool is_noisy) {
+                       bool is_noisy,
+                       int decode_threads = -1,
+                       int downscale      = 1) {
         bool is_video = preview_latent_tensor_is_video(latents);
         uint32_t dim  = is_video ? static_cast<uint32_t>(latents.shape()[3]) : static_cast<uint32_t>(latents.shape()[2]);
         int channels  = get_latent_channel();
@@ -2212,14 +2520,15 @@ public:
         if (preview_mode == PREVIEW_VAE || preview_mode == PREVIEW_TAE) {
             sd::Tensor<float> vae_latents;
             sd::Tensor<float> decoded;
+            const int threads = decode_threads > 0 ? decode_threads : n_threads;
             if (preview_vae) {
                 preview_vae->set_temporal_tiling_enabled(vae_tiling_params.temporal_tiling);
-                vae_latents = preview_vae->diffusion_to_vae_latents(_latents);
-                decoded     = preview_vae->decode(n_threads, vae_latents, vae_tiling_params, is_video, circular_x, circular_y, true);
+                vae_latents = downscale_preview_latents(preview_vae->diffusion_to_vae_latents(_latents), downscale);
+                decoded     = preview_vae->decode(threads, vae_latents, vae_tiling_params, is_video, circular_x, circular_y, true);
             } else {
                 first_stage_model->set_temporal_tiling_enabled(vae_tiling_params.temporal_tiling);
-                vae_latents = first_stage_model->diffusion_to_vae_latents(_latents);
-                decoded     = first_stage_model->decode(n_threads, vae_latents, vae_tiling_params, is_video, circular_x, circular_y, true);
+                vae_latents = downscale_preview_latents(first_stage_model->diffusion_to_vae_latents(_latents), downscale);
+                decoded     = first_stage_model->decode(threads, vae_latents, vae_tiling_params, is_video, circular_x, circular_y, true);
             }
             if (decoded.empty()) {
                 LOG_ERROR("preview decode failed at step %d", step);
@@ -2298,12 +2607,99 @@ public:
         sd_preview_cb_t callback = nullptr;
         void* data               = nullptr;
         preview_t mode           = PREVIEW_NONE;
+        int interval             = 1;
+        int downscale            = 1;
+        std::unique_ptr<PreviewWorker> worker;
     };
 
+    // Backend the VAE/TAE preview decode computes on.
+    ggml_backend_t preview_decode_backend() {
+        return preview_vae_backend ? preview_vae_backend.get() : backend_for(SDBackendModule::VAE);
+    }
+
+    // Threads for a preview worker, or 0 when previews must stay on the
+    // sampling thread: the decoder would share a backend instance with a
+    // runner that computes during sampling, or (without an explicit thread
+    // count) would take CPU cores from CPU sampling.
+    int async_preview_decode_threads() {
+        const int requested = sd_get_preview_decode_threads();
+        if (requested < 0) {
+            return 0;
+        }
+        ggml_backend_t decode_backend = preview_decode_backend();
+        if (decode_backend == nullptr) {
+            return 0;
+        }
+        std::vector<ggml_backend_t> sampling_backends = backend_manager.runtime_backends(SDBackendModule::DIFFUSION);
+        if (control_net) {
+            for (ggml_backend_t backend : backend_manager.runtime_backends(SDBackendModule::CONTROL_NET)) {
+                sampling_backends.push_back(backend);
+            }
+        }
+        bool sampling_on_cpu = false;
+        for (ggml_backend_t backend : sampling_backends) {
+            if (backend == decode_backend) {
+                return 0;
+            }
+            sampling_on_cpu = sampling_on_cpu || sd_backend_is_cpu(backend);
+        }
+        if (requested > 0) {
+            return requested;
+        }
+        if (sd_backend_is_cpu(decode_backend) && sampling_on_cpu) {
+            return 0;
+        }
+        return n_threads;
+    }
+
     SamplePreviewContext prepare_sample_preview_context() {
-        return SamplePreviewContext{sd_get_preview_callback(),
-                                    sd_get_preview_callback_data(),
-                                    sd_get_preview_mode()};
+        SamplePreviewContext preview;
+        preview.callback  = sd_get_preview_callback();
+        preview.data      = sd_get_preview_callback_data();
+        preview.mode      = sd_get_preview_mode();
+        preview.interval  = std::max(1, sd_get_preview_interval());
+        preview.downscale = sd_get_preview_downscale();
+        if (preview.callback == nullptr || (preview.mode != PREVIEW_VAE && preview.mode != PREVIEW_TAE)) {
+            return preview;
+        }
+        const int threads = async_preview_decode_threads();
+        if (threads > 0) {
+            sd_preview_cb_t callback = preview.callback;
+            void* data               = preview.data;
+            preview_t mode           = preview.mode;
+            int downscale            = preview.downscale;
+
+            auto decode = [this, callback, data, mode, threads, downscale](int step, const sd::Tensor<float>& latent, bool is_noisy) {
+                preview_image(step, latent, version, mode, callback, data, is_noisy, threads, downscale);
+            };
+            preview.worker = std::make_unique<PreviewWorker>(decode);
+            LOG_DEBUG("decoding previews on a worker thread (%d threads)", threads);
+        }
+        return preview;
+    }
+
+    void send_sample_preview(SamplePreviewContext& preview, int step, const sd::Tensor<float>& latent, bool is_noisy) {
+        if (preview.callback == nullptr || std::abs(step) % preview.interval != 0) {
+            return;
+        }
+        if (preview.worker) {
+            preview.worker->submit(step, latent, is_noisy);
+            return;
+        }
+        preview_image(step, latent, version, preview.mode, preview.callback, preview.data, is_noisy, -1, preview.downscale);
+    }
+
+    // Waits for the preview worker; the newest preview is still decoded
+    // unless the generation was cancelled.
+    void finish_sample_previews(SamplePreviewContext& preview) {
+        if (!preview.worker) {
+            return;
+        }
+        preview.worker->stop(get_cancel_flag() != SD_CANCEL_ALL);
+        LOG_DEBUG("preview worker decoded %zu previews, skipped %zu stale ones",
+                  preview.worker->decoded(),
+                  preview.worker->dropped());
+        preview.worker.reset();
     }
 
     void report_sample_progress(int step, size_t total_steps, int64_t* last_progress_us) {
@@ -2317,9 +2713,41 @@ public:
             if (last_progress_us != nullptr) {
                 *last_progress_us = now;
             }
+            report_step_major_faults(showstep);
+            report_step_weight_bandwidth(showstep, step_seconds);
         }
     }
 
+    // Every sampling step streams the whole diffusion model through the CPU
+    // caches at least once, so params bytes / step time is a lower bound of
+    // the memory bandwidth the step achieved. Useful to compare NUMA modes.
+    void report_step_weight_bandwidth(int step, float step_seconds) {
+        if (numa_mode == SD_NUMA_DISABLED || step_seconds <= 0.f || diffusion_params_mem_size == 0) {
+            return;
+        }
+        LOG_DEBUG("step %d: %.2f GB/s effective weight bandwidth (%.2f GB diffusion params, NUMA mode %s)",
+                  step,
+                  diffusion_params_mem_size / (1024.0 * 1024.0 * 1024.0) / step_seconds,
+                  diffusion_params_mem_size / (1024.0 * 1024.0 * 1024.0),
+                  sd_numa_mode_name(numa_mode));
+    }
+
+    // With mmapped weights every major fault is a synchronous disk read in
+    // the middle of a compute, so surface them per sampling step.
+    void report_step_major_faults(int step) {
+        if (!enable_mmap) {
+            return;
+        }
+        int64_t major_faults = sd_get_major_page_faults();
+        if (major_faults < 0) {
+            return;
+        }
+        if (last_step_major_faults >= 0) {
+            LOG_DEBUG("step %d: %" PRId64 " major page faults", step, major_faults - last_step_major_faults);
+        }
+        last_step_major_faults = major_faults;
+    }
+
     void compute_sample_controls(const sd::Tensor<float>& control_image,
                                  const sd::Tensor<float>& noised_input,
                                  const sd::Tensor<float>& timesteps_tensor,
@@ -2469,7 +2897,8 @@ public:
 
             if (step == 1 || step == -1) {
                 pretty_progress(0, (int)steps, 0);
-                last_progress_us = ggml_time_us();
+                last_progress_us       = ggml_time_us();
+                last_step_major_faults = sd_get_major_page_faults();
             }
 
             std::vector<float> scaling = denoiser->get_scalings(sigma);
@@ -2508,8 +2937,8 @@ public:
                 if (!denoise_mask.empty()) {
                     denoised = denoised * denoise_mask + init_latent * (1.0f - denoise_mask);
                 }
-                if (sd_should_preview_denoised() && preview.callback != nullptr) {
-                    preview_image(step, denoised, version, preview.mode, preview.callback, preview.data, false);
+                if (sd_should_preview_denoised()) {
+                    send_sample_preview(preview, step, denoised, false);
                 }
                 report_sample_progress(step, steps, &last_progress_us);
                 sd::guidance::GuiderOutput output;
@@ -2517,8 +2946,8 @@ public:
                 return output;
             }
 
-            if (sd_should_preview_noisy() && preview.callback != nullptr) {
-                preview_image(step, noised_input, version, preview.mode, preview.callback, preview.data, true);
+            if (sd_should_preview_noisy()) {
+                send_sample_preview(preview, step, noised_input, true);
             }
 
             sd::Tensor<float> cond_out;
@@ -2708,8 +3137,8 @@ public:
             if (!denoise_mask.empty()) {
                 denoised = denoised * denoise_mask + init_latent * (1.0f - denoise_mask);
             }
-            if (sd_should_preview_denoised() && preview.callback != nullptr) {
-                preview_image(step, denoised, version, preview.mode, preview.callback, preview.data, false);
+            if (sd_should_preview_denoised()) {
+                send_sample_preview(preview, step, denoised, false);
             }
             report_sample_progress(step, steps, &last_progress_us);
             output.pred = denoised;
@@ -2717,6 +3146,7 @@ public:
         };
 
         auto x0_opt = sample_k_diffusion(method, denoise, x_t, sigmas, sampler_rng, eta, is_flow_denoiser, extra_sample_args, denoiser);
+        finish_sample_previews(preview);
         if (x0_opt.empty()) {
             LOG_ERROR("Diffusion model sampling failed");
             if (control_net) {
@@ -2845,17 +3275,52 @@ public:
         return latent_frames_to_video_frames(video_frames_to_latent_frames(frames));
     }
 
-    sd::Tensor<float> encode_to_vae_latents(const sd::Tensor<float>& x) {
-        auto latents = first_stage_model->encode(n_threads, x, vae_tiling_params, circular_x, circular_y);
+    // What the VAE encode of an input depends on besides the VAE weights.
+    std::string vae_encode_cache_key(const EncodeCache::InputId& input_id) const {
+        return sd_format("vae|%d|%d|%d|%d|%.4f|%.4f|%.4f|%s|%d|%d|%016llx",
+                         vae_tiling_params.enabled ? 1 : 0,
+                         vae_tiling_params.temporal_tiling ? 1 : 0,
+                         vae_tiling_params.tile_size_x,
+                         vae_tiling_params.tile_size_y,
+                         vae_tiling_params.target_overlap,
+                         vae_tiling_params.rel_size_x,
+                         vae_tiling_params.rel_size_y,
+                         SAFE_STR(vae_tiling_params.extra_tiling_args),
+                         circular_x ? 1 : 0,
+                         circular_y ? 1 : 0,
+                         (unsigned long long)input_id.hash);
+    }
+
+    // use_encode_cache is for encodes of request inputs; intermediate images
+    // (e.g. the hires-fix upscale) never repeat and would only evict them.
+    sd::Tensor<float> encode_to_vae_latents(const sd::Tensor<float>& x, bool use_encode_cache = true) {
+        // The cache holds the raw encoder output: vae_output_to_latents()
+        // may sample from it with rng, which has to happen on every call.
+        sd::Tensor<float> latents;
+        std::string cache_key;
+        EncodeCache::InputId input_id;
+        if (use_encode_cache && encode_cache.enabled()) {
+            input_id  = EncodeCache::identify(x);
+            cache_key = vae_encode_cache_key(input_id);
+            if (encode_cache.lookup(cache_key, input_id, &latents)) {
+                LOG_DEBUG("using cached vae encode");
+            }
+        }
         if (latents.empty()) {
-            return {};
+            latents = first_stage_model->encode(n_threads, x, vae_tiling_params, circular_x, circular_y);
+            if (latents.empty()) {
+                return {};
+            }
+            if (!cache_key.empty()) {
+                encode_cache.insert(cache_key, input_id, latents);
+            }
         }
         latents = first_stage_model->vae_output_to_latents(latents, rng);
         return latents;
     }
 
-    sd::Tensor<float> encode_first_stage(const sd::Tensor<float>& x) {
-        auto latents = encode_to_vae_latents(x);
+    sd::Tensor<float> encode_first_stage(const sd::Tensor<float>& x, bool use_encode_cache = true) {
+        auto latents = encode_to_vae_latents(x, use_encode_cache);
         if (latents.empty()) {
             return {};
         }
@@ -2883,6 +3348,46 @@ public:
         return decoded;
     }
 
+    // decode_first_stage() straight to an 8-bit image. With spatial tiling the
+    // tiles are blended one tile row at a time and converted as soon as their
+    // rows are final, so the full-resolution float image never exists.
+    sd_image_t decode_first_stage_image(const sd::Tensor<float>& x) {
+        bool stream = vae_tiling_params.enabled &&
+                      !circular_y &&
+                      x.dim() == 4 &&
+                      x.shape()[3] == 1 &&
+                      !sd_version_is_pid(version) &&
+                      !sd_version_is_minit2i(version);
+        if (stream) {
+            auto latents = first_stage_model->diffusion_to_vae_latents(x);
+            sd_image_t image{};
+            bool ok = first_stage_model->decode_rows(n_threads, latents, vae_tiling_params, circular_x, [&](SDTileRows& rows) {
+                if (image.data == nullptr) {
+                    image.width   = static_cast<uint32_t>(rows.width);
+                    image.height  = static_cast<uint32_t>(rows.height);
+                    image.channel = static_cast<uint32_t>(rows.plane_count);
+                    image.data    = (uint8_t*)malloc(static_cast<size_t>(image.width) * image.height * image.channel);
+                    if (image.data == nullptr) {
+                        LOG_ERROR("failed to allocate %ux%u decoded image", image.width, image.height);
+                        return false;
+                    }
+                }
+                sd_image_set_rows(&image, rows.data, static_cast<int64_t>(rows.width) * rows.plane_rows, rows.y0, rows.n_rows);
+                return true;
+            });
+            if (ok) {
+                return image;
+            }
+            free(image.data);
+            LOG_WARN("streaming VAE decode failed, retrying with a full decode");
+        }
+        auto decoded = decode_first_stage(x);
+        if (decoded.empty()) {
+            return {};
+        }
+        return tensor_to_sd_image(decoded);
+    }
+
     sd::Tensor<float> normalize_ltx_video_latents(const sd::Tensor<float>& x) {
         auto ltx_vae = std::dynamic_pointer_cast<LTXVideoVAE>(first_stage_model);
         if (!ltx_vae) {
@@ -2901,14 +3406,24 @@ public:
         return ltx_vae->un_normalize_latents(n_threads, x);
     }
 
-    sd::Tensor<float> decode_ltx_audio_latent(const sd::Tensor<float>& audio_latent) {
+    sd::Tensor<float> decode_ltx_audio_latent(const sd::Tensor<float>& audio_latent, int threads = -1) {
         if (audio_vae_model == nullptr || audio_latent.empty()) {
             return {};
         }
-        auto waveform = audio_vae_model->decode(n_threads, audio_latent);
+        auto waveform = audio_vae_model->decode(threads > 0 ? threads : n_threads, audio_latent);
         return waveform;
     }
 
+    // Threads given to the audio decode when it runs next to the video decode.
+    // The audio VAE is much lighter than the video VAE; a quarter of the
+    // threads usually lets it finish before the video decode does.
+    int concurrent_audio_decode_threads() const {
+        if (audio_vae_backend == nullptr || n_threads < MIN_THREADS_FOR_CONCURRENT_AUDIO_DECODE) {
+            return 0;
+        }
+        return std::max(1, n_threads / 4);
+    }
+
     void set_flow_shift(float flow_shift = INFINITY) {
         auto flow_denoiser = std::dynamic_pointer_cast<DiscreteFlowDenoiser>(denoiser);
         if (flow_denoiser) {
@@ -3238,6 +3753,29 @@ enum lora_apply_mode_t str_to_lora_apply_mode(const char* str) {
     return LORA_APPLY_MODE_COUNT;
 }
 
+const char* numa_mode_to_str[] = {
+    "disabled",
+    "distribute",
+    "isolate",
+    "numactl",
+};
+
+const char* sd_numa_mode_name(enum sd_numa_mode_t mode) {
+    if (mode < SD_NUMA_MODE_COUNT) {
+        return numa_mode_to_str[mode];
+    }
+    return NONE_STR;
+}
+
+enum sd_numa_mode_t str_to_sd_numa_mode(const char* str) {
+    for (int i = 0; i < SD_NUMA_MODE_COUNT; i++) {
+        if (!strcmp(str, numa_mode_to_str[i])) {
+            return (enum sd_numa_mode_t)i;
+        }
+    }
+    return SD_NUMA_MODE_COUNT;
+}
+
 const char* hires_upscaler_to_str[] = {
     "None",
     "Latent",
@@ -3364,6 +3902,10 @@ void sd_ctx_params_init(sd_ctx_params_t* sd_ctx_params) {
     sd_ctx_params->rpc_servers          = nullptr;
     sd_ctx_params->model_args           = nullptr;
     sd_ctx_params->pulid_weights_path   = nullptr;
+    sd_ctx_params->numa                 = SD_NUMA_DISABLED;
+    sd_ctx_params->lora_cache_size      = 0;
+    sd_ctx_params->f8_weight_type       = nullptr;
+    sd_ctx_params->encode_cache_size    = 0;
 }
 
 char* sd_ctx_params_to_str(const sd_ctx_params_t* sd_ctx_params) {
@@ -3404,6 +3946,10 @@ char* sd_ctx_params_to_str(const sd_ctx_params_t* sd_ctx_params) {
              "split_mode: %s\n"
              "model_args: %s\n"
              "auto_fit: %s\n"
+             "numa: %s\n"
+             "lora_cache_size: %d\n"
+             "f8_weight_type: %s\n"
+             "encode_cache_size: %d\n"
              "flash_attn: %s\n"
              "diffusion_flash_attn: %s\n"
              "vae_format: %s\n",
@@ -3438,6 +3984,10 @@ char* sd_ctx_params_to_str(const sd_ctx_params_t* sd_ctx_params) {
              SAFE_STR(sd_ctx_params->split_mode),
              SAFE_STR(sd_ctx_params->model_args),
              BOOL_STR(sd_ctx_params->auto_fit),
+             sd_numa_mode_name(sd_ctx_params->numa),
+             sd_ctx_params->lora_cache_size,
+             SAFE_STR(sd_ctx_params->f8_weight_type),
+             sd_ctx_params->encode_cache_size,
              BOOL_STR(sd_ctx_params->flash_attn),
              BOOL_STR(sd_ctx_params->diffusion_flash_attn),
              sd_vae_format_name(sd_ctx_params->vae_format));
@@ -3626,6 +4176,9 @@ void sd_vid_gen_params_init(sd_vid_gen_params_t* sd_vid_gen_params) {
     sd_vid_gen_params->hires.custom_sigmas_count             = 0;
     sd_vid_gen_params->circular_x                            = false;
     sd_vid_gen_params->circular_y                            = false;
+    sd_vid_gen_params->frame_sink                            = nullptr;
+    sd_vid_gen_params->frame_sink_data                       = nullptr;
+    sd_vid_gen_params->audio_sink                            = nullptr;
     sd_cache_params_init(&sd_vid_gen_params->cache);
 }
 
@@ -3752,6 +4305,13 @@ SD_API bool sd_ctx_unload_control_net(sd_ctx_t* sd_ctx) {
     return sd_ctx->sd->unload_control_net();
 }
 
+SD_API bool sd_ctx_preload_loras(sd_ctx_t* sd_ctx, const sd_lora_t* loras, uint32_t lora_count) {
+    if (sd_ctx == nullptr || sd_ctx->sd == nullptr || (loras == nullptr && lora_count > 0)) {
+        return false;
+    }
+    return sd_ctx->sd->preload_loras(loras, lora_count);
+}
+
 SD_API bool sd_ctx_has_control_net(const sd_ctx_t* sd_ctx) {
     if (sd_ctx == nullptr || sd_ctx->sd == nullptr) {
         return false;
@@ -3875,6 +4435,9 @@ struct GenerationRequest {
     int requested_frames                     = -1;
     int fps                                  = 16;
     float vace_strength                      = 1.f;
+    sd_frame_sink_t frame_sink               = nullptr;
+    void* frame_sink_data                    = nullptr;
+    sd_audio_sink_t audio_sink               = nullptr;
 
     GenerationRequest(sd_ctx_t* sd_ctx, const sd_img_gen_params_t* sd_img_gen_params) {
         prompt                      = SAFE_STR(sd_img_gen_params->prompt);
@@ -3918,6 +4481,9 @@ struct GenerationRequest {
         guidance                    = sd_vid_gen_params->sample_params.guidance;
         high_noise_guidance         = sd_vid_gen_params->high_noise_sample_params.guidance;
         hires                       = sd_vid_gen_params->hires;
+        frame_sink                  = sd_vid_gen_params->frame_sink;
+        frame_sink_data             = sd_vid_gen_params->frame_sink_data;
+        audio_sink                  = sd_vid_gen_params->audio_sink;
         resolve(sd_ctx);
         if (frames != requested_frames) {
             LOG_WARN("align video frames from %d to %d for %s",
@@ -4949,6 +5515,7 @@ static std::optional<ImageGenerationEmbeds> prepare_image_generation_embeds(sd_c
     }
 
     condition_params.ref_image_params = ref_image_params;
+    condition_params.encode_cache     = &sd_ctx->sd->encode_cache;
 
     sd_ctx->sd->prepare_generation_extensions(request->pm_params,
                                               request->pulid_params,
@@ -5045,7 +5612,19 @@ static sd_image_t* decode_image_outputs(sd_ctx_t* sd_ctx,
     } else {
         LOG_INFO("decoding %zu latents", final_latents.size());
     }
-    std::vector<sd::Tensor<float>> decoded_images;
+    // Decoded straight to 8-bit images, so only one float image (or, with
+    // tiling, one tile row of it) is alive at a time.
+    std::vector<sd_image_t> decoded_images;
+    struct DecodedImagesGuard {
+        std::vector<sd_image_t>* images = nullptr;
+        ~DecodedImagesGuard() {
+            if (images != nullptr) {
+                for (auto& image : *images) {
+                    free(image.data);
+                }
+            }
+        }
+    } decoded_images_guard{&decoded_images};
     int64_t t0     = ggml_time_ms();
     bool cancelled = false;
 
@@ -5072,12 +5651,12 @@ static sd_image_t* decode_image_outputs(sd_ctx_t* sd_ctx,
                 }
                 sd::Tensor<float> layer_latent = sd::ops::slice(final_latents[i], 2, layer_index, layer_index + 1);
                 layer_latent.squeeze_(2);
-                sd::Tensor<float> image = sd_ctx->sd->decode_first_stage(layer_latent);
-                if (image.empty()) {
+                sd_image_t image = sd_ctx->sd->decode_first_stage_image(layer_latent);
+                if (image.data == nullptr) {
                     LOG_ERROR("decode_first_stage failed for latent %zu layer %d", i + 1, layer_index + 1);
                     return nullptr;
                 }
-                decoded_images.push_back(std::move(image));
+                decoded_images.push_back(image);
             }
             if (cancelled) {
                 break;
@@ -5093,20 +5672,20 @@ static sd_image_t* decode_image_outputs(sd_ctx_t* sd_ctx,
                     break;
                 }
                 sd::Tensor<float> frame_latent = sd::ops::slice(final_latents[i], 3, f, f + 1);
-                sd::Tensor<float> image        = sd_ctx->sd->decode_first_stage(frame_latent);
-                if (image.empty()) {
+                sd_image_t image               = sd_ctx->sd->decode_first_stage_image(frame_latent);
+                if (image.data == nullptr) {
                     LOG_ERROR("decode_first_stage failed for AnimateDiff frame %d/%d", f + 1, n_frames);
                     return nullptr;
                 }
-                decoded_images.push_back(std::move(image));
+                decoded_images.push_back(image);
             }
         } else {
-            sd::Tensor<float> image = sd_ctx->sd->decode_first_stage(final_latents[i]);
-            if (image.empty()) {
+            sd_image_t image = sd_ctx->sd->decode_first_stage_image(final_latents[i]);
+            if (image.data == nullptr) {
                 LOG_ERROR("decode_first_stage failed for latent %" PRId64, i + 1);
                 return nullptr;
             }
-            decoded_images.push_back(std::move(image));
+            decoded_images.push_back(image);
         }
         int64_t t2 = ggml_time_ms();
         LOG_INFO("latent %zu decoded, taking %.2fs", i + 1, (t2 - t1) * 1.0f / 1000);
@@ -5129,8 +5708,9 @@ static sd_image_t* decode_image_outputs(sd_ctx_t* sd_ctx,
     }
 
     for (size_t i = 0; i < decoded_images.size(); i++) {
-        result_images[i] = tensor_to_sd_image(decoded_images[i]);
+        result_images[i] = decoded_images[i];
     }
+    decoded_images_guard.images = nullptr;
 
     return result_images;
 }
@@ -5260,7 +5840,7 @@ static sd::Tensor<float> upscale_hires_latent(sd_ctx_t* sd_ctx,
             LOG_ERROR("cancelling hires latent encode");
             return {};
         }
-        sd::Tensor<float> upscaled_latent = sd_ctx->sd->encode_first_stage(upscaled_tensor);
+        sd::Tensor<float> upscaled_latent = sd_ctx->sd->encode_first_stage(upscaled_tensor, false);
         if (upscaled_latent.empty()) {
             LOG_ERROR("encode_first_stage failed after hires %s upscale",
                       sd_hires_upscaler_name(request.hires.upscaler));
@@ -5448,23 +6028,15 @@ SD_API bool generate_image(sd_ctx_t* sd_ctx,
         }
         LOG_INFO("hires fix: upscaling to %dx%d", request.hires.target_width, request.hires.target_height);
 
-        std::unique_ptr<UpscalerGGML> hires_upscaler;
+        UpscalerGGML* hires_upscaler = nullptr;
         if (request.hires.upscaler == SD_HIRES_UPSCALER_MODEL) {
             if (sd_ctx->sd->get_cancel_flag() == SD_CANCEL_ALL) {
                 LOG_ERROR("cancelling generation before hires model load");
                 return false;
             }
-            LOG_INFO("hires fix: loading model upscaler from '%s'", request.hires.model_path);
-            hires_upscaler                    = std::make_unique<UpscalerGGML>(sd_ctx->sd->n_threads,
-                                                            false,
-                                                            request.hires.upscale_tile_size,
-                                                            sd_ctx->sd->backend_spec,
-                                                            sd_ctx->sd->params_backend_spec);
-            const size_t max_graph_vram_bytes = sd_ctx->sd->max_graph_vram_bytes_for_module(SDBackendModule::UPSCALER);
-            hires_upscaler->set_max_graph_vram_bytes(max_graph_vram_bytes);
-            if (!hires_upscaler->load_from_file(request.hires.model_path,
-                                                sd_ctx->sd->n_threads)) {
-                LOG_ERROR("load hires model upscaler failed");
+            hires_upscaler = sd_ctx->sd->get_hires_upscaler(request.hires.model_path,
+                                                            request.hires.upscale_tile_size);
+            if (hires_upscaler == nullptr) {
                 return false;
             }
         }
@@ -5498,7 +6070,7 @@ SD_API bool generate_image(sd_ctx_t* sd_ctx,
             sd::Tensor<float> upscaled = upscale_hires_latent(sd_ctx,
                                                               final_latents[b],
                                                               request,
-                                                              hires_upscaler.get());
+                                                              hires_upscaler);
             if (upscaled.empty()) {
                 return false;
             }
@@ -5984,6 +6556,7 @@ static ImageGenerationEmbeds prepare_video_generation_embeds(sd_ctx_t* sd_ctx,
     condition_params.text            = request.prompt;
     condition_params.zero_out_masked = true;
     condition_params.ref_images      = &latents.ref_images;
+    condition_params.encode_cache    = &sd_ctx->sd->encode_cache;
     if (sd_version_is_lingbot_video(sd_ctx->sd->version)) {
         condition_params.ref_image_params.vlm_resize_mode = RefImageResizeMode::AREA;
     }
@@ -6007,17 +6580,48 @@ static ImageGenerationEmbeds prepare_video_generation_embeds(sd_ctx_t* sd_ctx,
     return embeds;
 }
 
-static sd_image_t* decode_video_outputs(sd_ctx_t* sd_ctx,
-                                        const GenerationRequest& request,
-                                        const sd::Tensor<float>& final_latent,
-                                        int* num_frames_out) {
+// Converts frames [first, first + count) of a decoded video tensor to images
+// and hands them to the request's frame sink.
+static bool send_video_frames_to_sink(const GenerationRequest& request,
+                                      const sd::Tensor<float>& video,
+                                      int64_t first_frame_in_video,
+                                      int64_t first_frame,
+                                      int64_t count) {
+    if (count <= 0) {
+        return true;
+    }
+    std::vector<sd_image_t> frames(static_cast<size_t>(count));
+    for (int64_t i = 0; i < count; i++) {
+        frames[i] = tensor_to_sd_image(video, static_cast<int>(first_frame_in_video + i));
+    }
+    bool keep_going = request.frame_sink(frames.data(),
+                                         static_cast<int>(first_frame),
+                                         static_cast<int>(count),
+                                         request.frame_sink_data);
+    for (auto& frame : frames) {
+        free(frame.data);
+    }
+    if (!keep_going) {
+        LOG_INFO("frame sink stopped the video at frame %" PRId64, first_frame + count);
+    }
+    return keep_going;
+}
+
+// before_first_frame, if set, runs once before anything reaches the frame
+// sink (or after the decode if no frame did); returning false stops the video.
+static bool decode_video_outputs(sd_ctx_t* sd_ctx,
+                                 const GenerationRequest& request,
+                                 const sd::Tensor<float>& final_latent,
+                                 sd_image_t** frames_out,
+                                 int* num_frames_out,
+                                 const std::function<bool()>& before_first_frame = nullptr) {
     if (final_latent.empty()) {
         LOG_ERROR("no latent video to decode");
-        return nullptr;
+        return false;
     }
     if (sd_ctx->sd->get_cancel_flag() == SD_CANCEL_ALL) {
         LOG_ERROR("cancelling video decode");
-        return nullptr;
+        return false;
     }
     sd::Tensor<float> video_latent = final_latent;
     if (sd_version_is_ltxav(sd_ctx->sd->version) &&
@@ -6029,14 +6633,44 @@ static sd_image_t* decode_video_outputs(sd_ctx_t* sd_ctx,
               (int)video_latent.shape()[1],
               (int)video_latent.shape()[2],
               (int)video_latent.shape()[3]);
+
+    // With a frame sink, decoders that finish frames early (LTX temporal
+    // tiling) push them out during the decode; whatever was not streamed is
+    // sent from the decoded tensor afterwards.
+    const int64_t frame_limit = request.frames > 0 ? request.frames : INT64_MAX;
+    int64_t sent_frames       = 0;
+    bool sink_started         = false;
+    auto start_sink           = [&]() {
+        if (sink_started) {
+            return true;
+        }
+        sink_started = true;
+        return !before_first_frame || before_first_frame();
+    };
+    if (request.frame_sink != nullptr) {
+        sd_ctx->sd->first_stage_model->set_decoded_frames_callback([&](const sd::Tensor<float>& frames, int64_t first_frame) {
+            int64_t begin = std::max(first_frame, sent_frames);
+            int64_t end   = std::min(first_frame + frames.shape()[2], frame_limit);
+            if (begin >= end) {
+                return true;
+            }
+            if (!start_sink() ||
+                !send_video_frames_to_sink(request, frames, begin - first_frame, begin, end - begin)) {
+                return false;
+            }
+            sent_frames = end;
+            return true;
+        });
+    }
     // auto z = sd::load_tensor_from_file_as_tensor<float>("ltx_vae_z.bin");
     int64_t t4            = ggml_time_ms();
     sd::Tensor<float> vid = sd_ctx->sd->decode_first_stage(video_latent, true);
     int64_t t5            = ggml_time_ms();
+    sd_ctx->sd->first_stage_model->set_decoded_frames_callback(nullptr);
     LOG_INFO("decode_first_stage completed, taking %.2fs", (t5 - t4) * 1.0f / 1000);
     if (vid.empty()) {
         LOG_ERROR("decode_first_stage failed for video");
-        return nullptr;
+        return false;
     }
     LOG_DEBUG("decode_video_outputs decoded %dx%dx%dx%d",
               (int)vid.shape()[0],
@@ -6048,9 +6682,27 @@ static sd_image_t* decode_video_outputs(sd_ctx_t* sd_ctx,
         vid = sd::ops::slice(vid, 2, 0, request.frames);
     }
 
+    if (request.frame_sink != nullptr) {
+        // A streamed decode returns only its last chunk, which is never longer
+        // than what was already sent.
+        for (int64_t i = sent_frames; i < vid.shape()[2]; i++) {
+            if (!start_sink() || !send_video_frames_to_sink(request, vid, i, i, 1)) {
+                return false;
+            }
+            sent_frames = i + 1;
+        }
+        if (!start_sink()) {
+            return false;
+        }
+        if (num_frames_out != nullptr) {
+            *num_frames_out = static_cast<int>(sent_frames);
+        }
+        return true;
+    }
+
     sd_image_t* result_images = (sd_image_t*)calloc(vid.shape()[2], sizeof(sd_image_t));
     if (result_images == nullptr) {
-        return nullptr;
+        return false;
     }
     if (num_frames_out != nullptr) {
         *num_frames_out = static_cast<int>(vid.shape()[2]);
@@ -6059,8 +6711,12 @@ static sd_image_t* decode_video_outputs(sd_ctx_t* sd_ctx,
     for (int64_t i = 0; i < vid.shape()[2]; i++) {
         result_images[i] = tensor_to_sd_image(vid, static_cast<int>(i));
     }
-
-    return result_images;
+    if (frames_out != nullptr) {
+        *frames_out = result_images;
+    } else {
+        free_sd_images(result_images, static_cast<int>(vid.shape()[2]));
+    }
+    return true;
 }
 
 static sd::Tensor<float> upscale_ltx_spatial_video_latent(sd_ctx_t* sd_ctx,
@@ -6287,8 +6943,24 @@ static bool generate_animatediff_video(sd_ctx_t* sd_ctx,
     img_gen_params.circular_y        = sd_vid_gen_params->circular_y;
 
     sd_ctx->sd->animatediff_num_frames = n_frames;
-    bool ok                            = generate_image(sd_ctx, &img_gen_params, frames_out, num_frames_out);
+    if (sd_vid_gen_params->frame_sink == nullptr) {
+        bool ok                            = generate_image(sd_ctx, &img_gen_params, frames_out, num_frames_out);
+        sd_ctx->sd->animatediff_num_frames = 0;
+        return ok;
+    }
+
+    // The motion module decodes all frames in one batch; hand them over in one go.
+    sd_image_t* frames                 = nullptr;
+    int frame_count                    = 0;
+    bool ok                            = generate_image(sd_ctx, &img_gen_params, &frames, &frame_count);
     sd_ctx->sd->animatediff_num_frames = 0;
+    if (ok && frame_count > 0) {
+        ok = sd_vid_gen_params->frame_sink(frames, 0, frame_count, sd_vid_gen_params->frame_sink_data);
+        if (ok && num_frames_out != nullptr) {
+            *num_frames_out = frame_count;
+        }
+    }
+    free_sd_images(frames, frame_count);
     return ok;
 }
 
@@ -6608,6 +7280,7 @@ SD_API bool generate_video(sd_ctx_t* sd_ctx,
     LOG_INFO("generating latent video completed, taking %.2fs", (latent_end - latent_start) * 1.0f / 1000);
 
     sd_audio_t* generated_audio = nullptr;
+    sd::Tensor<float> audio_latent;
     if (sd_version_is_ltxav(sd_ctx->sd->version) &&
         latents.audio_length > 0 &&
         sd_ctx->sd->audio_vae_model != nullptr) {
@@ -6615,26 +7288,67 @@ SD_API bool generate_video(sd_ctx_t* sd_ctx,
             LOG_ERROR("cancelling generation before audio decode");
             return false;
         }
-        int64_t audio_latent_decode_start = ggml_time_ms();
-
-        auto audio_latent = unpack_ltxav_audio_latent(final_latent,
-                                                      latents.audio_length,
-                                                      sd_ctx->sd->get_latent_channel());
+        audio_latent = unpack_ltxav_audio_latent(final_latent,
+                                                 latents.audio_length,
+                                                 sd_ctx->sd->get_latent_channel());
         if (!audio_latent.empty()) {
             LOG_DEBUG("decode audio latent %dx%dx%dx%d",
                       (int)audio_latent.shape()[0],
                       (int)audio_latent.shape()[1],
                       (int)audio_latent.shape()[2],
                       (int)audio_latent.shape()[3]);
-            auto waveform = sd_ctx->sd->decode_ltx_audio_latent(audio_latent);
-            if (!waveform.empty()) {
-                generated_audio = waveform_to_sd_audio(sd_ctx->sd, waveform);
-            } else {
-                LOG_WARN("LTX audio latent decode failed; continuing with silent video output");
-            }
         }
-        int64_t audio_latent_decode_end = ggml_time_ms();
+    }
+
+    sd::Tensor<float> waveform;
+    auto decode_audio = [&](int threads) {
+        int64_t audio_latent_decode_start = ggml_time_ms();
+        waveform                          = sd_ctx->sd->decode_ltx_audio_latent(audio_latent, threads);
+        int64_t audio_latent_decode_end   = ggml_time_ms();
         LOG_INFO("decoding audio latent completed, taking %.2fs", (audio_latent_decode_end - audio_latent_decode_start) * 1.0f / 1000);
+    };
+    bool audio_finished = false;
+    auto finish_audio   = [&]() {
+        if (audio_finished || audio_latent.empty()) {
+            return;
+        }
+        audio_finished = true;
+        if (!waveform.empty()) {
+            generated_audio = waveform_to_sd_audio(sd_ctx->sd, waveform);
+        } else {
+            LOG_WARN("LTX audio latent decode failed; continuing with silent video output");
+        }
+    };
+
+    // The audio VAE may own a CPU backend; its decode then runs on a share of
+    // the threads while the video VAE decodes on the rest.
+    const int audio_threads = audio_latent.empty() ? 0 : sd_ctx->sd->concurrent_audio_decode_threads();
+    if (!audio_latent.empty() && audio_threads == 0) {
+        decode_audio(-1);
+        finish_audio();
+    }
+
+    // A streaming caller gets the audio ahead of the first frame; with the
+    // concurrent decode that first frame waits for the audio thread.
+    std::thread audio_thread;
+    std::function<bool()> before_first_frame;
+    if (request.frame_sink != nullptr && request.audio_sink != nullptr) {
+        before_first_frame = [&]() {
+            if (audio_thread.joinable()) {
+                audio_thread.join();
+            }
+            finish_audio();
+            if (generated_audio == nullptr) {
+                return true;
+            }
+            bool keep_going = request.audio_sink(generated_audio, request.frame_sink_data);
+            free_sd_audio(generated_audio);
+            generated_audio = nullptr;
+            if (!keep_going) {
+                LOG_INFO("audio sink stopped the video");
+            }
+            return keep_going;
+        };
     }
 
     if (latents.video_conditioning_frame_count > 0) {
@@ -6652,8 +7366,38 @@ SD_API bool generate_video(sd_ctx_t* sd_ctx,
         free_sd_audio(generated_audio);
         return false;
     }
-    auto result = decode_video_outputs(sd_ctx, latent_upscale_enabled ? hires_request : request, final_latent, num_frames_out);
-    if (result == nullptr) {
+
+    bool video_decoded = false;
+    if (audio_threads > 0) {
+        const int n_threads        = sd_ctx->sd->n_threads;
+        int64_t media_decode_start = ggml_time_ms();
+        audio_thread          = std::thread(decode_audio, audio_threads);
+        sd_ctx->sd->n_threads = n_threads - audio_threads;
+        video_decoded         = decode_video_outputs(sd_ctx,
+                                                     latent_upscale_enabled ? hires_request : request,
+                                                     final_latent,
+                                                     frames_out,
+                                                     num_frames_out,
+                                                     before_first_frame);
+        sd_ctx->sd->n_threads = n_threads;
+        if (audio_thread.joinable()) {
+            audio_thread.join();
+        }
+        finish_audio();
+        int64_t media_decode_end = ggml_time_ms();
+        LOG_INFO("decoding audio (%d threads) and video (%d threads) completed, taking %.2fs",
+                 audio_threads,
+                 n_threads - audio_threads,
+                 (media_decode_end - media_decode_start) * 1.0f / 1000);
+    } else {
+        video_decoded = decode_video_outputs(sd_ctx,
+                                             latent_upscale_enabled ? hires_request : request,
+                                             final_latent,
+                                             frames_out,
+                                             num_frames_out,
+                                             before_first_frame);
+    }
+    if (!video_decoded) {
         free_sd_audio(generated_audio);
         return false;
     }
@@ -6662,9 +7406,6 @@ SD_API bool generate_video(sd_ctx_t* sd_ctx,
 
     int64_t t1 = ggml_time_ms();
     LOG_INFO("generate_video completed in %.2fs", (t1 - t0) * 1.0f / 1000);
-    if (frames_out != nullptr) {
-        *frames_out = result;
-    }
     if (audio_out != nullptr) {
         *audio_out = generated_audio;
     } else {
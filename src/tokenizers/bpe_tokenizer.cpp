@@ -1,11 +1,76 @@
 #include "bpe_tokenizer.h"
 
 #include <algorithm>
+#include <set>
 #include <sstream>
 
 #include "core/util.h"
 #include "tokenize_util.h"
 
+void BPEMergeTable::clear() {
+    keys_.clear();
+    values_.clear();
+    size_ = 0;
+}
+
+void BPEMergeTable::reserve(size_t n) {
+    size_t capacity = 16;
+    while (capacity < n * 2) {
+        capacity <<= 1;
+    }
+    if (capacity <= keys_.size()) {
+        return;
+    }
+    std::vector<uint64_t> old_keys   = std::move(keys_);
+    std::vector<BPEMerge> old_values = std::move(values_);
+    keys_.assign(capacity, EMPTY_KEY);
+    values_.assign(capacity, BPEMerge());
+    for (size_t i = 0; i < old_keys.size(); i++) {
+        if (old_keys[i] != EMPTY_KEY) {
+            size_t slot   = slot_of(old_keys[i]);
+            keys_[slot]   = old_keys[i];
+            values_[slot] = old_values[i];
+        }
+    }
+}
+
+size_t BPEMergeTable::slot_of(uint64_t key) const {
+    // splitmix64 finalizer; ids are small and dense, so spread them out
+    uint64_t h = key;
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    const size_t mask = keys_.size() - 1;
+    size_t slot       = static_cast<size_t>(h) & mask;
+    while (keys_[slot] != EMPTY_KEY && keys_[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void BPEMergeTable::insert(int first, int second, const BPEMerge& merge) {
+    if ((size_ + 1) * 2 > keys_.size()) {
+        reserve(size_ + 1);
+    }
+    uint64_t key = make_key(first, second);
+    size_t slot  = slot_of(key);
+    if (keys_[slot] == EMPTY_KEY) {
+        keys_[slot] = key;
+        size_++;
+    }
+    values_[slot] = merge;
+}
+
+const BPEMerge* BPEMergeTable::find(int first, int second) const {
+    if (size_ == 0) {
+        return nullptr;
+    }
+    size_t slot = slot_of(make_key(first, second));
+    return keys_[slot] == EMPTY_KEY ? nullptr : &values_[slot];
+}
+
 std::vector<std::pair<int, std::u32string>> BPETokenizer::bytes_to_unicode() {
     std::vector<std::pair<int, std::u32string>> byte_unicode_pairs;
     std::set<int> byte_set;
@@ -47,87 +112,168 @@ std::vector<std::u32string> BPETokenizer::split_utf32(const std::string& text, c
     return result;
 }
 
-static std::set<std::pair<std::u32string, std::u32string>> get_pairs(const std::vector<std::u32string>& subwords) {
-    std::set<std::pair<std::u32string, std::u32string>> pairs;
-    if (subwords.empty()) {
-        return pairs;
+std::vector<std::pair<std::u32string, std::u32string>> BPETokenizer::parse_merges(const std::vector<std::u32string>& merges) {
+    std::vector<std::pair<std::u32string, std::u32string>> merge_pairs;
+    merge_pairs.reserve(merges.size());
+    for (const auto& merge : merges) {
+        size_t space_pos = merge.find(' ');
+        merge_pairs.emplace_back(merge.substr(0, space_pos), merge.substr(space_pos + 1));
     }
+    return merge_pairs;
+}
 
-    std::u32string prev_subword = subwords[0];
-    for (int i = 1; i < static_cast<int>(subwords.size()); i++) {
-        std::u32string subword = subwords[i];
-        std::pair<std::u32string, std::u32string> pair(prev_subword, subword);
-        pairs.insert(pair);
-        prev_subword = subword;
+void BPETokenizer::init_byte_encoder() {
+    for (auto& pair : bytes_to_unicode()) {
+        byte_encoder[pair.first]  = pair.second;
+        byte_decoder[pair.second] = pair.first;
     }
-    return pairs;
 }
 
-std::vector<std::u32string> BPETokenizer::bpe(const std::u32string& token) const {
-    std::vector<std::u32string> word;
-
-    for (int i = 0; i < static_cast<int>(token.size()) - 1; i++) {
-        word.emplace_back(1, token[i]);
+int BPETokenizer::intern_symbol(const std::u32string& symbol) {
+    auto it = symbol_ids.find(symbol);
+    if (it != symbol_ids.end()) {
+        return it->second;
     }
-    word.push_back(token.substr(token.size() - 1) + utf8_to_utf32(end_of_word_suffix));
+    int id = static_cast<int>(symbols.size());
+    symbols.push_back(symbol);
+    symbol_ids.emplace(symbol, id);
+    return id;
+}
 
-    std::set<std::pair<std::u32string, std::u32string>> pairs = get_pairs(word);
+void BPETokenizer::set_bpe_merges(const std::vector<std::pair<std::u32string, std::u32string>>& merge_pairs) {
+    symbols.clear();
+    symbol_ids.clear();
+    bpe_merges.clear();
+    bpe_cache.clear();
+    symbols.reserve(merge_pairs.size() + 512);
+    symbol_ids.reserve(merge_pairs.size() + 512);
+    bpe_merges.reserve(merge_pairs.size());
 
-    if (pairs.empty()) {
-        return {token + utf8_to_utf32(end_of_word_suffix)};
+    int rank = 0;
+    for (const auto& merge : merge_pairs) {
+        int first  = intern_symbol(merge.first);
+        int second = intern_symbol(merge.second);
+        BPEMerge entry;
+        entry.rank   = rank++;
+        entry.merged = intern_symbol(merge.first + merge.second);
+        bpe_merges.insert(first, second, entry);
     }
+    bpe_len = rank;
+}
 
-    while (true) {
-        auto min_pair_iter = std::min_element(pairs.begin(),
-                                              pairs.end(),
-                                              [&](const std::pair<std::u32string, std::u32string>& a,
-                                                  const std::pair<std::u32string, std::u32string>& b) {
-                                                  if (bpe_ranks.find(a) == bpe_ranks.end()) {
-                                                      return false;
-                                                  } else if (bpe_ranks.find(b) == bpe_ranks.end()) {
-                                                      return true;
-                                                  }
-                                                  return bpe_ranks.at(a) < bpe_ranks.at(b);
-                                              });
-
-        const std::pair<std::u32string, std::u32string>& bigram = *min_pair_iter;
+std::vector<std::u32string> BPETokenizer::bpe(const std::u32string& token) const {
+    if (token.empty()) {
+        return {};
+    }
 
-        if (bpe_ranks.find(bigram) == bpe_ranks.end()) {
-            break;
+    // Symbols that never take part in a merge get ids past the interned
+    // range; no merge can match them, they only need to survive to the end.
+    std::vector<std::u32string> extra_symbols;
+    auto symbol_id = [&](const std::u32string& symbol) {
+        auto it = symbol_ids.find(symbol);
+        if (it != symbol_ids.end()) {
+            return it->second;
+        }
+        extra_symbols.push_back(symbol);
+        return static_cast<int>(symbols.size() + extra_symbols.size() - 1);
+    };
+    auto symbol_str = [&](int id) -> const std::u32string& {
+        if (id < static_cast<int>(symbols.size())) {
+            return symbols[id];
         }
+        return extra_symbols[id - symbols.size()];
+    };
 
-        std::u32string first  = bigram.first;
-        std::u32string second = bigram.second;
-        std::vector<std::u32string> new_word;
-        int32_t i = 0;
+    std::vector<int> word;
+    word.reserve(token.size());
+    for (size_t i = 0; i + 1 < token.size(); i++) {
+        word.push_back(symbol_id(std::u32string(1, token[i])));
+    }
+    word.push_back(symbol_id(token.substr(token.size() - 1) + utf8_to_utf32(end_of_word_suffix)));
 
-        while (i < static_cast<int32_t>(word.size())) {
-            auto it = std::find(word.begin() + i, word.end(), first);
-            if (it == word.end()) {
-                new_word.insert(new_word.end(), word.begin() + i, word.end());
-                break;
+    std::vector<int> new_word;
+    new_word.reserve(word.size());
+    while (word.size() > 1) {
+        const BPEMerge* best = nullptr;
+        int first            = -1;
+        int second           = -1;
+        for (size_t i = 0; i + 1 < word.size(); i++) {
+            const BPEMerge* merge = bpe_merges.find(word[i], word[i + 1]);
+            if (merge != nullptr && (best == nullptr || merge->rank < best->rank)) {
+                best   = merge;
+                first  = word[i];
+                second = word[i + 1];
             }
-            new_word.insert(new_word.end(), word.begin() + i, it);
-            i = static_cast<int32_t>(std::distance(word.begin(), it));
+        }
+        if (best == nullptr) {
+            break;
+        }
 
-            if (word[i] == first && i < static_cast<int32_t>(word.size()) - 1 && word[i + 1] == second) {
-                new_word.push_back(first + second);
+        new_word.clear();
+        size_t i = 0;
+        while (i < word.size()) {
+            if (word[i] == first && i + 1 < word.size() && word[i + 1] == second) {
+                new_word.push_back(best->merged);
                 i += 2;
             } else {
                 new_word.push_back(word[i]);
                 i += 1;
             }
         }
+        word.swap(new_word);
+    }
+
+    std::vector<std::u32string> result;
+    result.reserve(word.size());
+    for (int id : word) {
+        result.push_back(symbol_str(id));
+    }
+    return result;
+}
 
-        word = new_word;
+const BPETokenizer::BPECacheEntry& BPETokenizer::encode_word(const std::string& token) {
+    auto cached = bpe_cache.find(token);
+    if (cached != bpe_cache.end()) {
+        return cached->second;
+    }
+    if (bpe_cache.size() >= BPE_CACHE_MAX_ENTRIES) {
+        bpe_cache.clear();
+    }
 
-        if (word.size() == 1) {
-            break;
+    std::string token_str = normalize_before_split ? token : normalize(token);
+    std::u32string utf32_token;
+    if (byte_level_bpe) {
+        for (size_t i = 0; i < token_str.length(); i++) {
+            unsigned char b = token_str[i];
+            utf32_token += byte_encoder[b];
         }
-        pairs = get_pairs(word);
+    } else {
+        utf32_token = utf8_to_utf32(token_str);
     }
 
-    return word;
+    BPECacheEntry entry;
+    auto bpe_strs = bpe(utf32_token);
+    for (const auto& bpe_str : bpe_strs) {
+        auto iter = encoder.find(bpe_str);
+        if (iter != encoder.end()) {
+            entry.ids.push_back(iter->second);
+            entry.pieces.push_back(utf32_to_utf8(bpe_str));
+        } else if (byte_fallback) {
+            auto utf8_token_str = utf32_to_utf8(bpe_str);
+            for (size_t i = 0; i < utf8_token_str.length(); i++) {
+                unsigned char b = utf8_token_str[i];
+                char hex_buf[16];
+                snprintf(hex_buf, sizeof(hex_buf), "<0x%02X>", b);
+                iter = encoder.find(utf8_to_utf32(hex_buf));
+                entry.ids.push_back(iter != encoder.end() ? iter->second : UNK_TOKEN_ID);
+                entry.pieces.push_back(hex_buf);
+            }
+        } else {
+            entry.ids.push_back(UNK_TOKEN_ID);
+            entry.pieces.push_back(utf32_to_utf8(bpe_str));
+        }
+    }
+    return bpe_cache.emplace(token, std::move(entry)).first->second;
 }
 
 std::vector<int> BPETokenizer::encode(const std::string& text, on_new_token_cb_t on_new_token_cb) {
@@ -160,42 +306,9 @@ std::vector<int> BPETokenizer::encode(const std::string& text, on_new_token_cb_t
                 }
             }
 
-            std::string token_str = normalize_before_split ? token : normalize(token);
-            std::u32string utf32_token;
-            if (byte_level_bpe) {
-                for (int i = 0; i < token_str.length(); i++) {
-                    unsigned char b = token_str[i];
-                    utf32_token += byte_encoder[b];
-                }
-            } else {
-                utf32_token = utf8_to_utf32(token_str);
-            }
-            auto bpe_strs = bpe(utf32_token);
-            for (auto bpe_str : bpe_strs) {
-                int token_id;
-                auto iter = encoder.find(bpe_str);
-                if (iter != encoder.end()) {
-                    token_id = iter->second;
-                } else {
-                    if (byte_fallback) {
-                        auto utf8_token_str = utf32_to_utf8(bpe_str);
-                        for (int i = 0; i < utf8_token_str.length(); i++) {
-                            unsigned char b = utf8_token_str[i];
-                            char hex_buf[16];
-                            snprintf(hex_buf, sizeof(hex_buf), "<0x%02X>", b);
-                            iter     = encoder.find(utf8_to_utf32(hex_buf));
-                            token_id = iter != encoder.end() ? iter->second : UNK_TOKEN_ID;
-                            bpe_tokens.push_back(token_id);
-                            token_strs.push_back(hex_buf);
-                        }
-                        continue;
-                    } else {
-                        token_id = UNK_TOKEN_ID;
-                    }
-                }
-                bpe_tokens.push_back(token_id);
-                token_strs.push_back(utf32_to_utf8(bpe_str));
-            }
+            const BPECacheEntry& entry = encode_word(token);
+            bpe_tokens.insert(bpe_tokens.end(), entry.ids.begin(), entry.ids.end());
+            token_strs.insert(token_strs.end(), entry.pieces.begin(), entry.pieces.end());
         }
     }
 
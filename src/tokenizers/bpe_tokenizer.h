@@ -1,35 +1,83 @@
 #ifndef __SD_TOKENIZERS_BPE_TOKENIZER_H__
 #define __SD_TOKENIZERS_BPE_TOKENIZER_H__
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <map>
-#include <regex>
-#include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "tokenizer.h"
 
+struct BPEMerge {
+    int rank   = -1;
+    int merged = -1;  // symbol id of first + second
+};
+
+// Open-addressing (linear probing) map from a pair of symbol ids to its merge.
+// This is the hot lookup of the BPE loop, so it avoids the node allocations
+// and string compares of a tree/bucket map.
+class BPEMergeTable {
+public:
+    void clear();
+    void reserve(size_t n);
+    void insert(int first, int second, const BPEMerge& merge);
+    const BPEMerge* find(int first, int second) const;
+    size_t size() const { return size_; }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = ~0ull;
+
+    static uint64_t make_key(int first, int second) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) | static_cast<uint32_t>(second);
+    }
+    size_t slot_of(uint64_t key) const;
+
+    std::vector<uint64_t> keys_;
+    std::vector<BPEMerge> values_;
+    size_t size_ = 0;
+};
+
 class BPETokenizer : public Tokenizer {
 protected:
-    std::map<int, std::u32string> byte_encoder;
-    std::map<std::u32string, int> byte_decoder;
-    std::map<std::u32string, int> encoder;
-    std::map<int, std::u32string> decoder;
-    std::map<std::pair<std::u32string, std::u32string>, int> bpe_ranks;
+    struct BPECacheEntry {
+        std::vector<int> ids;
+        std::vector<std::string> pieces;
+    };
+
+    std::array<std::u32string, 256> byte_encoder;
+    std::unordered_map<std::u32string, int> byte_decoder;
+    std::unordered_map<std::u32string, int> encoder;
+    std::unordered_map<int, std::u32string> decoder;
     int encoder_len     = 0;
     int bpe_len         = 0;
     bool byte_level_bpe = true;
     bool byte_fallback  = false;
 
+    // Every string that appears in a merge (either side or the result) is
+    // interned once; the BPE loop then only works on integer ids.
+    std::vector<std::u32string> symbols;
+    std::unordered_map<std::u32string, int> symbol_ids;
+    BPEMergeTable bpe_merges;
+
+    // Per pre-token result of bpe() + encoder lookup; prompts repeat words a lot.
+    static constexpr size_t BPE_CACHE_MAX_ENTRIES = 16384;
+    std::unordered_map<std::string, BPECacheEntry> bpe_cache;
+
 protected:
     static std::vector<std::pair<int, std::u32string>> bytes_to_unicode();
     static std::vector<std::u32string> split_utf32(const std::string& text, char32_t delimiter = U'\n');
+    static std::vector<std::pair<std::u32string, std::u32string>> parse_merges(const std::vector<std::u32string>& merges);
+    void init_byte_encoder();
+    int intern_symbol(const std::u32string& symbol);
+    // Ranks follow the order of merge_pairs; a repeated pair keeps its last rank.
+    void set_bpe_merges(const std::vector<std::pair<std::u32string, std::u32string>>& merge_pairs);
     virtual std::vector<std::string> token_split(const std::string& text) const;
     std::vector<std::u32string> bpe(const std::u32string& token) const;
+    const BPECacheEntry& encode_word(const std::string& token);
     std::string decode_token(int token_id) const override;
 
 public:
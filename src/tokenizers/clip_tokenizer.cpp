@@ -3,8 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cmath>
-#include <regex>
-#include <set>
+#include <cstring>
 
 #include "core/util.h"
 #include "ggml.h"
@@ -38,19 +37,12 @@ CLIPTokenizer::CLIPTokenizer(int pad_token_id, const std::string& merges_utf8_st
 
 void CLIPTokenizer::load_from_merges(const std::string& merges_utf8_str) {
     auto byte_unicode_pairs = bytes_to_unicode();
-    byte_encoder            = std::map<int, std::u32string>(byte_unicode_pairs.begin(), byte_unicode_pairs.end());
-    for (auto& pair : byte_unicode_pairs) {
-        byte_decoder[pair.second] = pair.first;
-    }
+    init_byte_encoder();
 
     std::vector<std::u32string> merges = split_utf32(merges_utf8_str);
     GGML_ASSERT(merges.size() == 48895);
     merges = std::vector<std::u32string>(merges.begin() + 1, merges.end());
-    std::vector<std::pair<std::u32string, std::u32string>> merge_pairs;
-    for (const auto& merge : merges) {
-        size_t space_pos = merge.find(' ');
-        merge_pairs.emplace_back(merge.substr(0, space_pos), merge.substr(space_pos + 1));
-    }
+    auto merge_pairs = parse_merges(merges);
     std::vector<std::u32string> vocab;
     for (const auto& pair : byte_unicode_pairs) {
         vocab.push_back(pair.second);
@@ -64,6 +56,8 @@ void CLIPTokenizer::load_from_merges(const std::string& merges_utf8_str) {
     vocab.push_back(utf8_to_utf32("<|startoftext|>"));
     vocab.push_back(utf8_to_utf32("<|endoftext|>"));
     LOG_DEBUG("vocab size: %zu", vocab.size());
+    encoder.reserve(vocab.size());
+    decoder.reserve(vocab.size());
     int i = 0;
     for (const auto& token : vocab) {
         encoder[token] = i;
@@ -72,45 +66,95 @@ void CLIPTokenizer::load_from_merges(const std::string& merges_utf8_str) {
     }
     encoder_len = i;
 
-    int rank = 0;
-    for (const auto& merge : merge_pairs) {
-        bpe_ranks[merge] = rank++;
-    }
-    bpe_len = rank;
+    set_bpe_merges(merge_pairs);
 }
 
-static std::string strip(const std::string& str) {
-    std::string::size_type start = str.find_first_not_of(" \t\n\r\v\f");
-    std::string::size_type end   = str.find_last_not_of(" \t\n\r\v\f");
+static bool clip_is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-    if (start == std::string::npos) {
-        return "";
-    }
+static bool clip_is_alpha(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
 
-    return str.substr(start, end - start + 1);
+static bool clip_is_digit(unsigned char c) {
+    return c >= '0' && c <= '9';
 }
 
+// collapse runs of whitespace to a single space
 static std::string whitespace_clean(const std::string& text) {
-    auto result = std::regex_replace(text, std::regex(R"(\s+)"), " ");
-    result      = strip(result);
+    std::string result;
+    result.reserve(text.size());
+    bool in_space = false;
+    for (unsigned char c : text) {
+        if (clip_is_space(c)) {
+            in_space = true;
+            continue;
+        }
+        if (in_space && !result.empty()) {
+            result.push_back(' ');
+        }
+        in_space = false;
+        result.push_back(static_cast<char>(c));
+    }
     return result;
 }
-
 std::string CLIPTokenizer::normalize(const std::string& text) const {
     auto normalized_text = whitespace_clean(text);
     std::transform(normalized_text.begin(), normalized_text.end(), normalized_text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
     return normalized_text;
 }
 
+// Hand-written equivalent of the byte-wise, C-locale regex
+//   's|'t|'re|'ve|'m|'ll|'d|[[:alpha:]]+|[[:digit:]]|[^[:space:][:alpha:][:digit:]]+
+// (case-insensitive). Bytes >= 0x80 fall into the last class, like with std::regex.
 std::vector<std::string> CLIPTokenizer::token_split(const std::string& text) const {
-    std::regex clip_pat(R"('s|'t|'re|'ve|'m|'ll|'d|[[:alpha:]]+|[[:digit:]]|[^[:space:][:alpha:][:digit:]]+)",
-                        std::regex::icase);
-    std::sregex_iterator iter(text.begin(), text.end(), clip_pat);
-    std::sregex_iterator end;
+    static const char* contractions[] = {"s", "t", "re", "ve", "m", "ll", "d"};
 
     std::vector<std::string> result;
-    for (; iter != end; ++iter) {
-        result.emplace_back(iter->str());
+    const size_t n = text.size();
+    size_t i       = 0;
+    while (i < n) {
+        unsigned char c = text[i];
+        if (c == '\'') {
+            size_t matched = 0;
+            for (const char* contraction : contractions) {
+                size_t len = strlen(contraction);
+                if (i + 1 + len > n) {
+                    continue;
+                }
+                size_t j = 0;
+                while (j < len && std::tolower(static_cast<unsigned char>(text[i + 1 + j])) == contraction[j]) {
+                    j++;
+                }
+                if (j == len) {
+                    matched = 1 + len;
+                    break;
+                }
+            }
+            if (matched > 0) {
+                result.emplace_back(text, i, matched);
+                i += matched;
+                continue;
+            }
+        }
+
+        size_t start = i;
+        if (clip_is_alpha(c)) {
+            while (i < n && clip_is_alpha(text[i])) {
+                i++;
+            }
+        } else if (clip_is_digit(c)) {
+            i++;
+        } else if (clip_is_space(c)) {
+            i++;
+            continue;
+        } else {
+            while (i < n && !clip_is_space(text[i]) && !clip_is_alpha(text[i]) && !clip_is_digit(text[i])) {
+                i++;
+            }
+        }
+        result.emplace_back(text, start, i - start);
     }
 
     return result;
@@ -32,18 +32,10 @@ void GemmaTokenizer::load_from_merges(const std::string& merges_utf8_str, const
     LOG_DEBUG("vocab size: %d", encoder_len);
 
     std::vector<std::u32string> merges = split_utf32(merges_utf8_str);
-    std::vector<std::pair<std::u32string, std::u32string>> merge_pairs;
-    for (const auto& merge : merges) {
-        size_t space_pos = merge.find(' ');
-        merge_pairs.emplace_back(merge.substr(0, space_pos), merge.substr(space_pos + 1));
-    }
+    auto merge_pairs = parse_merges(merges);
     LOG_DEBUG("merges size %zu", merge_pairs.size());
 
-    int rank = 0;
-    for (const auto& merge : merge_pairs) {
-        bpe_ranks[merge] = rank++;
-    }
-    bpe_len = rank;
+    set_bpe_merges(merge_pairs);
 }
 
 GemmaTokenizer::GemmaTokenizer(const std::string& merges_utf8_str, const std::string& vocab_utf8_str) {
@@ -217,18 +209,10 @@ void Gemma2Tokenizer::load_from_merges(const std::string& merges_utf8_str, const
     LOG_DEBUG("vocab size: %d", encoder_len);
 
     std::vector<std::u32string> merges = split_utf32(merges_utf8_str);
-    std::vector<std::pair<std::u32string, std::u32string>> merge_pairs;
-    for (const auto& merge : merges) {
-        size_t space_pos = merge.find(' ');
-        merge_pairs.emplace_back(merge.substr(0, space_pos), merge.substr(space_pos + 1));
-    }
+    auto merge_pairs = parse_merges(merges);
     LOG_DEBUG("merges size %zu", merge_pairs.size());
 
-    int rank = 0;
-    for (const auto& merge : merge_pairs) {
-        bpe_ranks[merge] = rank++;
-    }
-    bpe_len = rank;
+    set_bpe_merges(merge_pairs);
 }
 
 Gemma2Tokenizer::Gemma2Tokenizer(const std::string& merges_utf8_str, const std::string& vocab_utf8_str) {
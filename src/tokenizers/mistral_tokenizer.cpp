@@ -22,24 +22,12 @@ void MistralTokenizer::load_from_merges(const std::string& merges_utf8_str, cons
     encoder_len = static_cast<int>(vocab.size());
     LOG_DEBUG("vocab size: %d", encoder_len);
 
-    auto byte_unicode_pairs = bytes_to_unicode();
-    byte_encoder            = std::map<int, std::u32string>(byte_unicode_pairs.begin(), byte_unicode_pairs.end());
-    for (auto& pair : byte_unicode_pairs) {
-        byte_decoder[pair.second] = pair.first;
-    }
+    init_byte_encoder();
     std::vector<std::u32string> merges = split_utf32(merges_utf8_str);
     LOG_DEBUG("merges size %zu", merges.size());
-    std::vector<std::pair<std::u32string, std::u32string>> merge_pairs;
-    for (const auto& merge : merges) {
-        size_t space_pos = merge.find(' ');
-        merge_pairs.emplace_back(merge.substr(0, space_pos), merge.substr(space_pos + 1));
-    }
+    auto merge_pairs = parse_merges(merges);
 
-    int rank = 0;
-    for (const auto& merge : merge_pairs) {
-        bpe_ranks[merge] = rank++;
-    }
-    bpe_len = rank;
+    set_bpe_merges(merge_pairs);
 }
 
 MistralTokenizer::MistralTokenizer(const std::string& merges_utf8_str, const std::string& vocab_utf8_str) {
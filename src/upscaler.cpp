@@ -120,7 +120,7 @@ sd::Tensor<float> UpscalerGGML::upscale_tensor(const sd::Tensor<float>& input_te
         upscaled = esrgan_upscaler->compute(n_threads, input_tensor);
     } else {
         auto on_processing = [&](const sd::Tensor<float>& input_tile) -> sd::Tensor<float> {
-            auto output_tile = esrgan_upscaler->compute(n_threads, input_tile);
+            auto output_tile = esrgan_upscaler->compute_tile(n_threads, input_tile);
             if (output_tile.empty()) {
                 LOG_ERROR("esrgan compute failed while processing a tile");
                 return {};
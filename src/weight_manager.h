@@ -14,6 +14,12 @@ struct RunnerWeightManager {
     virtual bool prepare_params(const std::vector<ggml_tensor*>& tensors)                 = 0;
     virtual void release_compute_backend_params(const std::vector<ggml_tensor*>& tensors) = 0;
     virtual void release_params_backend_params(const std::vector<ggml_tensor*>& tensors)  = 0;
+
+    // Optional hint that the given tensors will be prepared soon. Managers may
+    // start fetching their data in the background; the default does nothing.
+    virtual void prefetch_params(const std::vector<ggml_tensor*>& tensors) { (void)tensors; }
+    // Drops prefetches that have not started yet, e.g. after a failed run.
+    virtual void cancel_prefetch() {}
 };
 
 #endif  // __WEIGHT_MANAGER_H__
@@ -0,0 +1,69 @@
+#include "weight_registry.h"
+
+#include <sys/stat.h>
+
+#include "core/util.h"
+
+SharedWeightRegistry& SharedWeightRegistry::instance() {
+    static SharedWeightRegistry registry;
+    return registry;
+}
+
+std::string SharedWeightRegistry::file_identity(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return "";
+    }
+    std::string identity = sd_format("%llu:%llu:%llu:%lld",
+                                     (unsigned long long)st.st_dev,
+                                     (unsigned long long)st.st_ino,
+                                     (unsigned long long)st.st_size,
+                                     (long long)st.st_mtime);
+    if (st.st_ino == 0) {
+        // No inode numbers (e.g. Windows): fall back to the path.
+        identity += ":" + path;
+    }
+    return identity;
+}
+
+bool SharedWeightRegistry::lookup(const SharedWeightKey& key, SharedParamsBuffer* buffer, void** data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return false;
+    }
+    SharedParamsBuffer locked = it->second.buffer.lock();
+    if (locked == nullptr) {
+        entries_.erase(it);
+        return false;
+    }
+    *buffer = std::move(locked);
+    *data   = it->second.data;
+    return true;
+}
+
+void SharedWeightRegistry::publish(const SharedWeightKey& key, const SharedParamsBuffer& buffer, void* data) {
+    if (key.file_id.empty() || buffer == nullptr || data == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+    if (entry.buffer.expired()) {
+        entry.buffer = buffer;
+        entry.data   = data;
+    }
+    if (++publishes_since_prune_ >= 4096) {
+        prune_expired_locked();
+    }
+}
+
+void SharedWeightRegistry::prune_expired_locked() {
+    publishes_since_prune_ = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.buffer.expired()) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __WEIGHT_REGISTRY_H__
+#define __WEIGHT_REGISTRY_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "ggml-backend.h"
+#include "ggml.h"
+
+using SharedParamsBuffer = std::shared_ptr<struct ggml_backend_buffer>;
+
+// Identifies one loaded weight independently of the ModelManager that
+// loaded it: the same bytes of the same file, converted to the same type,
+// living in the same kind of buffer.
+struct SharedWeightKey {
+    std::string file_id;
+    uint64_t offset                 = 0;
+    uint64_t nbytes                 = 0;
+    ggml_type src_type              = GGML_TYPE_COUNT;
+    ggml_type dst_type              = GGML_TYPE_COUNT;
+    ggml_backend_buffer_type_t buft = nullptr;
+
+    bool operator<(const SharedWeightKey& other) const {
+        return std::tie(file_id, offset, nbytes, src_type, dst_type, buft) <
+               std::tie(other.file_id, other.offset, other.nbytes, other.src_type, other.dst_type, other.buft);
+    }
+};
+
+// Process-wide index of read-only params loaded by any ModelManager, so
+// sd_ctx_t, upscaler_ctx_t and adetailer_ctx_t instances that use the same
+// model files hold one copy. The registry only keeps weak references: the
+// buffers stay owned by the managers that use them and disappear with the
+// last one.
+class SharedWeightRegistry {
+public:
+    static SharedWeightRegistry& instance();
+
+    // Stable identity of a file on disk (device, inode, size, mtime); empty
+    // if the file cannot be stat'ed.
+    static std::string file_identity(const std::string& path);
+
+    bool lookup(const SharedWeightKey& key, SharedParamsBuffer* buffer, void** data);
+    void publish(const SharedWeightKey& key, const SharedParamsBuffer& buffer, void* data);
+
+private:
+    struct Entry {
+        std::weak_ptr<struct ggml_backend_buffer> buffer;
+        void* data = nullptr;
+    };
+
+    void prune_expired_locked();
+
+    std::mutex mutex_;
+    std::map<SharedWeightKey, Entry> entries_;
+    size_t publishes_since_prune_ = 0;
+};
+
+#endif  // __WEIGHT_REGISTRY_H__